@@ -0,0 +1,274 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "codec_dev_defaults.h"
+#include "codec_dev_utils.h"
+#include "codec_dev_err.h"
+#include "esp_log.h"
+
+#define TAG                 "Cache_If"
+
+#define CACHE_BIT_SET(bits, n) ((bits)[(n) >> 3] & (1 << ((n) & 7)))
+
+typedef struct {
+    audio_codec_ctrl_if_t        base;
+    const audio_codec_ctrl_if_t *ctrl_if;
+    codec_reg_cache_desc_t       desc;
+    bool                         is_open;
+    uint8_t                     *values;
+    uint8_t                     *valid;
+} cache_ctrl_t;
+
+static bool _cache_ctrl_cacheable(cache_ctrl_t *cache, int reg)
+{
+    if (reg < 0 || reg >= cache->desc.reg_num) {
+        return false;
+    }
+    if (cache->desc.volatile_mask && CACHE_BIT_SET(cache->desc.volatile_mask, reg)) {
+        return false;
+    }
+    return true;
+}
+
+static bool _cache_ctrl_hit(cache_ctrl_t *cache, int reg, uint8_t value)
+{
+    return _cache_ctrl_cacheable(cache, reg) && CACHE_BIT_SET(cache->valid, reg) && cache->values[reg] == value;
+}
+
+static void _cache_ctrl_update(cache_ctrl_t *cache, int reg, uint8_t value)
+{
+    if (reg == cache->desc.reset_reg) {
+        // Register content changed to default after reset, read from device again
+        memset(cache->valid, 0, (cache->desc.reg_num + 7) >> 3);
+        return;
+    }
+    if (_cache_ctrl_cacheable(cache, reg)) {
+        cache->values[reg] = value;
+        cache->valid[reg >> 3] |= (1 << (reg & 7));
+    }
+}
+
+static int _cache_ctrl_open(const audio_codec_ctrl_if_t *ctrl, void *cfg, int cfg_size)
+{
+    if (ctrl == NULL || cfg == NULL || cfg_size != sizeof(codec_cache_ctrl_cfg_t)) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    codec_cache_ctrl_cfg_t *cache_cfg = (codec_cache_ctrl_cfg_t *) cfg;
+    if (cache_cfg->ctrl_if == NULL || cache_cfg->desc == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    cache->ctrl_if = cache_cfg->ctrl_if;
+    cache->is_open = true;
+    return CODEC_DEV_OK;
+}
+
+static bool _cache_ctrl_is_open(const audio_codec_ctrl_if_t *ctrl)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache && cache->is_open) {
+        return cache->ctrl_if->is_open ? cache->ctrl_if->is_open(cache->ctrl_if) : true;
+    }
+    return false;
+}
+
+static int _cache_ctrl_read_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache == NULL || data == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (cache->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    const audio_codec_ctrl_if_t *ctrl_if = cache->ctrl_if;
+    if (addr_len != 1) {
+        return ctrl_if->read_addr(ctrl_if, addr, addr_len, data, data_len);
+    }
+    // Keep cache consistent with device when accessed from several tasks
+    int ret = audio_codec_ctrl_acquire(ctrl_if, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    uint8_t *v = (uint8_t *) data;
+    int i;
+    for (i = 0; i < data_len; i++) {
+        int reg = addr + i;
+        if (_cache_ctrl_cacheable(cache, reg) == false || CACHE_BIT_SET(cache->valid, reg) == 0) {
+            break;
+        }
+        v[i] = cache->values[reg];
+    }
+    if (i < data_len) {
+        ret = ctrl_if->read_addr(ctrl_if, addr, addr_len, data, data_len);
+        if (ret == CODEC_DEV_OK) {
+            for (i = 0; i < data_len; i++) {
+                if (addr + i != cache->desc.reset_reg) {
+                    _cache_ctrl_update(cache, addr + i, v[i]);
+                }
+            }
+        }
+    }
+    audio_codec_ctrl_acquire(ctrl_if, false);
+    return ret;
+}
+
+static int _cache_ctrl_write_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache == NULL || data == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (cache->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    const audio_codec_ctrl_if_t *ctrl_if = cache->ctrl_if;
+    if (addr_len != 1) {
+        return ctrl_if->write_addr(ctrl_if, addr, addr_len, data, data_len);
+    }
+    int ret = audio_codec_ctrl_acquire(ctrl_if, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    uint8_t *v = (uint8_t *) data;
+    int i;
+    for (i = 0; i < data_len; i++) {
+        if (addr + i == cache->desc.reset_reg || _cache_ctrl_hit(cache, addr + i, v[i]) == false) {
+            break;
+        }
+    }
+    // Skip write if register value not changed
+    if (i < data_len) {
+        ret = ctrl_if->write_addr(ctrl_if, addr, addr_len, data, data_len);
+        if (ret == CODEC_DEV_OK) {
+            for (i = 0; i < data_len; i++) {
+                _cache_ctrl_update(cache, addr + i, v[i]);
+            }
+        }
+    }
+    audio_codec_ctrl_acquire(ctrl_if, false);
+    return ret;
+}
+
+static int _cache_ctrl_write_regs(const audio_codec_ctrl_if_t *ctrl, const codec_reg_val_pair_t *seq, int n)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache == NULL || seq == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (cache->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    int ret = audio_codec_ctrl_acquire(cache->ctrl_if, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    int i = 0;
+    while (i < n) {
+        // Send changed registers in batch, keep write order
+        int start = i;
+        while (i < n && (seq[i].reg == cache->desc.reset_reg || !_cache_ctrl_hit(cache, seq[i].reg, seq[i].value))) {
+            i++;
+        }
+        if (i > start) {
+            int err = audio_codec_write_regs(cache->ctrl_if, seq + start, i - start);
+            if (err != CODEC_DEV_OK) {
+                ret = err;
+            } else {
+                for (int j = start; j < i; j++) {
+                    _cache_ctrl_update(cache, seq[j].reg, seq[j].value);
+                }
+            }
+        }
+        while (i < n && seq[i].reg != cache->desc.reset_reg && _cache_ctrl_hit(cache, seq[i].reg, seq[i].value)) {
+            i++;
+        }
+    }
+    audio_codec_ctrl_acquire(cache->ctrl_if, false);
+    return ret;
+}
+
+static int _cache_ctrl_acquire_bus(const audio_codec_ctrl_if_t *ctrl, bool acquire)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (cache->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    return audio_codec_ctrl_acquire(cache->ctrl_if, acquire);
+}
+
+static int _cache_ctrl_close(const audio_codec_ctrl_if_t *ctrl)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl;
+    if (cache == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    cache->is_open = false;
+    return CODEC_DEV_OK;
+}
+
+int audio_codec_cache_ctrl_invalidate(const audio_codec_ctrl_if_t *ctrl_if)
+{
+    cache_ctrl_t *cache = (cache_ctrl_t *) ctrl_if;
+    if (cache == NULL || ctrl_if->open != _cache_ctrl_open) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    memset(cache->valid, 0, (cache->desc.reg_num + 7) >> 3);
+    return CODEC_DEV_OK;
+}
+
+const audio_codec_ctrl_if_t *audio_codec_new_cache_ctrl_if(codec_cache_ctrl_cfg_t *cache_cfg)
+{
+    if (cache_cfg == NULL || cache_cfg->desc == NULL) {
+        return NULL;
+    }
+    int reg_num = cache_cfg->desc->reg_num;
+    // Put register values and valid bits together with instance so that default delete API can free all
+    cache_ctrl_t *cache = calloc(1, sizeof(cache_ctrl_t) + reg_num + ((reg_num + 7) >> 3));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->values = (uint8_t *) (cache + 1);
+    cache->valid = cache->values + reg_num;
+    memcpy(&cache->desc, cache_cfg->desc, sizeof(codec_reg_cache_desc_t));
+    cache->base.open = _cache_ctrl_open;
+    cache->base.is_open = _cache_ctrl_is_open;
+    cache->base.read_addr = _cache_ctrl_read_addr;
+    cache->base.write_addr = _cache_ctrl_write_addr;
+    cache->base.write_regs = _cache_ctrl_write_regs;
+    cache->base.acquire_bus = _cache_ctrl_acquire_bus;
+    cache->base.close = _cache_ctrl_close;
+    int ret = _cache_ctrl_open(&cache->base, cache_cfg, sizeof(codec_cache_ctrl_cfg_t));
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Fail to open cache control interface");
+        free(cache);
+        return NULL;
+    }
+    return &cache->base;
+}
@@ -28,12 +28,35 @@
 #include "audio_codec_data_if.h"
 #include "codec_dev_err.h"
 #include "audio_codec_vol.h"
+#include "codec_dev_os.h"
 #include "esp_log.h"
 
 #define TAG                 "Adev_Codec"
 
 #define VOL_TRANSITION_TIME (50)
 
+#define ASYNC_CTRL_STACK    (3072)
+
+#define ASYNC_CTRL_OUT_MASK ((1 << ESP_CODEC_DEV_CTRL_OUT_VOL) | (1 << ESP_CODEC_DEV_CTRL_OUT_MUTE))
+#define ASYNC_CTRL_IN_MASK  ((1 << ESP_CODEC_DEV_CTRL_IN_GAIN) | (1 << ESP_CODEC_DEV_CTRL_IN_MUTE))
+
+typedef struct {
+    void                        *lock;
+    void                        *wake_sem;
+    void                        *exit_sem;
+    void                        *idle_sem;
+    bool                         running;
+    bool                         busy;
+    bool                         idle_wait;
+    uint8_t                      pending;
+    int                          volume;
+    bool                         muted;
+    float                        mic_gain;
+    bool                         mic_muted;
+    esp_codec_dev_ctrl_done_cb_t done_cb;
+    void                        *ctx;
+} codec_dev_async_t;
+
 typedef struct {
     const audio_codec_if_t      *codec_if;
     const audio_codec_data_if_t *data_if;
@@ -46,7 +69,12 @@ typedef struct {
     bool                         mic_muted;
     float                        hw_gain_db;
     audio_codec_vol_handle_t     sw_vol;
+    bool                         sw_fade_en;
+    bool                         sw_fade;
+    bool                         vol_set;
+    float                        fixed_vol_db;
     esp_codec_dev_vol_curve_t    vol_curve;
+    codec_dev_async_t           *async;
 } codec_dev_t;
 
 static bool _verify_codec_ready(codec_dev_t *dev)
@@ -130,6 +158,33 @@ static float _get_vol_db(esp_codec_dev_vol_curve_t *curve, int vol)
     return 0.0;
 }
 
+static float _get_max_vol_db(esp_codec_dev_vol_curve_t *curve)
+{
+    float db = curve->count ? curve->vol_map[0].db_value : 0.0;
+    for (int i = 1; i < curve->count; i++) {
+        if (curve->vol_map[i].db_value > db) {
+            db = curve->vol_map[i].db_value;
+        }
+    }
+    return db;
+}
+
+static int _enable_codec(codec_dev_t *dev, codec_dev_type_t dev_type, bool enable)
+{
+    const audio_codec_if_t *codec = dev->codec_if;
+    if (codec == NULL) {
+        return CODEC_DEV_OK;
+    }
+    // Prefer path control so that other device sharing the codec keeps its own path running
+    if (codec->enable_path) {
+        return codec->enable_path(codec, dev_type, enable);
+    }
+    if (codec->enable) {
+        return codec->enable(codec, enable);
+    }
+    return CODEC_DEV_OK;
+}
+
 esp_codec_dev_handle_t esp_codec_dev_new(esp_codec_dev_cfg_t *cfg)
 {
     if (cfg == NULL || cfg->data_if == NULL || cfg->dev_type == CODEC_DEV_TYPE_NONE) {
@@ -142,18 +197,15 @@ esp_codec_dev_handle_t esp_codec_dev_new(esp_codec_dev_cfg_t *cfg)
     dev->dev_caps = cfg->dev_type;
     dev->codec_if = cfg->codec_if;
     dev->data_if = cfg->data_if;
+    dev->sw_fade_en = cfg->sw_fade;
     if (cfg->dev_type & CODEC_DEV_TYPE_OUT) {
         _get_default_vol_curve(&dev->vol_curve);
     }
     return (esp_codec_dev_handle_t) dev;
 }
 
-int esp_codec_dev_open(esp_codec_dev_handle_t handle, codec_sample_info_t *fs)
+static int _codec_dev_open(codec_dev_t *dev, codec_sample_info_t *fs)
 {
-    codec_dev_t *dev = (codec_dev_t *) handle;
-    if (dev == NULL || fs == NULL) {
-        return CODEC_DEV_INVALID_ARG;
-    }
     if (dev->input_opened || dev->output_opened) {
         ESP_LOGI(TAG, "Input already open");
         return CODEC_DEV_OK;
@@ -179,30 +231,119 @@ int esp_codec_dev_open(esp_codec_dev_handle_t handle, codec_sample_info_t *fs)
         return CODEC_DEV_NOT_SUPPORT;
     }
     const audio_codec_if_t *codec = dev->codec_if;
+    const audio_codec_data_if_t *data_if = dev->data_if;
+    // Only set format for opened direction, the other direction on shared port keeps its own format
+    codec_dev_type_t dev_type = CODEC_DEV_TYPE_NONE;
+    if (dev->input_opened) {
+        dev_type |= CODEC_DEV_TYPE_IN;
+    }
+    if (dev->output_opened) {
+        dev_type |= CODEC_DEV_TYPE_OUT;
+    }
+    if (data_if->set_fmt) {
+        // Data interface writes back sample rate and MCLK it actually runs at
+        int ret = data_if->set_fmt(data_if, dev_type, fs);
+        if (ret != CODEC_DEV_OK) {
+            ESP_LOGE(TAG, "Fail to set format to data interface ret %d", ret);
+            dev->input_opened = dev->output_opened = false;
+            return ret;
+        }
+    }
+    uint32_t caps = CODEC_IF_CAP_NONE;
+    if (codec && codec->get_caps) {
+        codec->get_caps(codec, &caps);
+    }
     if (codec) {
-        // TODO not set codec fs
-        if (0 && codec->set_fs) {
-            if (codec->set_fs(codec, fs) != 0) {
+        // Configure codec clock after data interface so that both run on same sample rate and MCLK
+        if (codec->set_fs) {
+            int ret = codec->set_fs(codec, fs);
+            if (ret != CODEC_DEV_OK && (caps & CODEC_IF_CAP_FIXED_FMT)) {
+                // Codec keeps its own format and converts data on interface
+                ESP_LOGW(TAG, "Codec runs at fixed format, sample rate %d converted by codec", fs->sample_rate);
+            } else if (ret != CODEC_DEV_OK) {
+                ESP_LOGE(TAG, "Fail to set codec sample rate %d mclk %d ret %d", fs->sample_rate, fs->mclk, ret);
+                if (data_if->set_fmt) {
+                    data_if->set_fmt(data_if, dev_type, NULL);
+                }
+                dev->input_opened = dev->output_opened = false;
                 return CODEC_DEV_NOT_SUPPORT;
             }
         }
-        if (codec->enable) {
-            codec->enable(codec, true);
-        }
-    }
-    const audio_codec_data_if_t *data_if = dev->data_if;
-    if (data_if->set_fmt) {
-        data_if->set_fmt(data_if, fs);
+        _enable_codec(dev, dev_type, true);
     }
     if (dev->output_opened) {
         if (codec == NULL || codec->set_vol == NULL) {
+            // Ramp volume in software only when codec can not set volume
             dev->sw_vol = audio_codec_sw_vol_open(fs, VOL_TRANSITION_TIME);
+        } else if ((caps & CODEC_IF_CAP_VOL_RAMP) == 0) {
+            // Fade in software only when user asks for it, it costs CPU on every write
+            if (dev->sw_fade_en && fs->bits_per_sample == 16) {
+                dev->sw_vol = audio_codec_sw_vol_open(fs, VOL_TRANSITION_TIME);
+            }
+            if (dev->sw_vol) {
+                // Keep codec at top of volume curve and attenuate in software
+                ESP_LOGI(TAG, "Codec volume change is not ramped by hardware, use software fade");
+                dev->sw_fade = true;
+                dev->fixed_vol_db = _get_max_vol_db(&dev->vol_curve) - dev->hw_gain_db;
+                codec->set_vol(codec, dev->fixed_vol_db);
+                if (dev->vol_set) {
+                    float db_value = _get_vol_db(&dev->vol_curve, dev->volume) - dev->hw_gain_db - dev->fixed_vol_db;
+                    audio_codec_sw_vol_set_direct(dev->sw_vol, db_value > 0.0 ? 0.0 : db_value);
+                }
+            } else {
+                ESP_LOGI(TAG, "Codec volume change is not ramped by hardware");
+            }
         }
     }
     ESP_LOGI(TAG, "open audio_device_codec OK\n");
     return CODEC_DEV_OK;
 }
 
+static uint8_t _async_ctrl_opened_mask(codec_dev_t *dev)
+{
+    return (dev->output_opened ? ASYNC_CTRL_OUT_MASK : 0) | (dev->input_opened ? ASYNC_CTRL_IN_MASK : 0);
+}
+
+static void _async_ctrl_lock_idle(codec_dev_async_t *async)
+{
+    // Wait for command in execution, worker can not take new command until unlocked
+    codec_dev_mutex_lock(async->lock);
+    while (async->busy) {
+        async->idle_wait = true;
+        codec_dev_mutex_unlock(async->lock);
+        codec_dev_sem_take(async->idle_sem, -1);
+        codec_dev_mutex_lock(async->lock);
+    }
+}
+
+static void _async_ctrl_unlock(codec_dev_t *dev, codec_dev_async_t *async)
+{
+    uint8_t opened = _async_ctrl_opened_mask(dev);
+    bool pending = (async->pending & opened) != 0;
+    codec_dev_mutex_unlock(async->lock);
+    if (pending) {
+        // Wake worker for commands kept until direction opened
+        codec_dev_sem_give(async->wake_sem);
+    }
+}
+
+int esp_codec_dev_open(esp_codec_dev_handle_t handle, codec_sample_info_t *fs)
+{
+    codec_dev_t *dev = (codec_dev_t *) handle;
+    if (dev == NULL || fs == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    codec_dev_async_t *async = dev->async;
+    if (async) {
+        _async_ctrl_lock_idle(async);
+    }
+    int ret = _codec_dev_open(dev, fs);
+    if (async) {
+        _async_ctrl_unlock(dev, async);
+    }
+    return ret;
+}
+
 int esp_codec_dev_read(esp_codec_dev_handle_t handle, void *data, int len)
 {
     codec_dev_t *dev = (codec_dev_t *) handle;
@@ -277,6 +418,239 @@ int esp_codec_dev_set_vol_curve(esp_codec_dev_handle_t handle, esp_codec_dev_vol
     return CODEC_DEV_OK;
 }
 
+static int _set_out_vol(codec_dev_t *dev, int volume)
+{
+    const audio_codec_if_t *codec = dev->codec_if;
+    float db_value = _get_vol_db(&dev->vol_curve, volume);
+    db_value -= dev->hw_gain_db;
+    if (dev->sw_fade) {
+        // Codec stays at fixed volume, software only attenuates
+        db_value -= dev->fixed_vol_db;
+        dev->volume = volume;
+        dev->vol_set = true;
+        return audio_codec_sw_vol_set(dev->sw_vol, db_value > 0.0 ? 0.0 : db_value);
+    }
+    if (codec && codec->set_vol) {
+        dev->volume = volume;
+        dev->vol_set = true;
+        return codec->set_vol(codec, db_value);
+    } else if (dev->sw_vol) {
+        dev->volume = volume;
+        dev->vol_set = true;
+        return audio_codec_sw_vol_set(dev->sw_vol, db_value);
+    }
+    return CODEC_DEV_NOT_SUPPORT;
+}
+
+static int _set_out_mute(codec_dev_t *dev, bool mute)
+{
+    const audio_codec_if_t *codec = dev->codec_if;
+    if (codec && codec->mute) {
+        dev->muted = mute;
+        return codec->mute(codec, mute);
+    }
+    return CODEC_DEV_NOT_SUPPORT;
+}
+
+static int _set_in_gain(codec_dev_t *dev, float db)
+{
+    const audio_codec_if_t *codec = dev->codec_if;
+    if (codec && codec->set_mic_gain) {
+        dev->mic_gain = db;
+        return codec->set_mic_gain(codec, (int) db);
+    }
+    return CODEC_DEV_NOT_SUPPORT;
+}
+
+static int _set_in_mute(codec_dev_t *dev, bool mute)
+{
+    const audio_codec_if_t *codec = dev->codec_if;
+    if (codec && codec->mute_mic) {
+        dev->mic_muted = mute;
+        return codec->mute_mic(codec, mute);
+    }
+    return CODEC_DEV_NOT_SUPPORT;
+}
+
+static bool _async_ctrl_supported(codec_dev_t *dev, esp_codec_dev_ctrl_cmd_t cmd)
+{
+    const audio_codec_if_t *codec = dev->codec_if;
+    switch (cmd) {
+        case ESP_CODEC_DEV_CTRL_OUT_VOL:
+            return (codec && codec->set_vol) || dev->sw_vol;
+        case ESP_CODEC_DEV_CTRL_OUT_MUTE:
+            return codec && codec->mute;
+        case ESP_CODEC_DEV_CTRL_IN_GAIN:
+            return codec && codec->set_mic_gain;
+        case ESP_CODEC_DEV_CTRL_IN_MUTE:
+            return codec && codec->mute_mic;
+        default:
+            return false;
+    }
+}
+
+static void _async_ctrl_run(codec_dev_t *dev, esp_codec_dev_ctrl_cmd_t cmd, codec_dev_async_t *req)
+{
+    int ret = _verify_codec_setting(dev, cmd < ESP_CODEC_DEV_CTRL_IN_GAIN);
+    if (ret == CODEC_DEV_OK) {
+        switch (cmd) {
+            case ESP_CODEC_DEV_CTRL_OUT_VOL:
+                ret = _set_out_vol(dev, req->volume);
+                break;
+            case ESP_CODEC_DEV_CTRL_OUT_MUTE:
+                ret = _set_out_mute(dev, req->muted);
+                break;
+            case ESP_CODEC_DEV_CTRL_IN_GAIN:
+                ret = _set_in_gain(dev, req->mic_gain);
+                break;
+            case ESP_CODEC_DEV_CTRL_IN_MUTE:
+                ret = _set_in_mute(dev, req->mic_muted);
+                break;
+            default:
+                break;
+        }
+    }
+    if (req->done_cb) {
+        req->done_cb((esp_codec_dev_handle_t) dev, cmd, ret, req->ctx);
+    }
+}
+
+static void _async_ctrl_thread(void *arg)
+{
+    codec_dev_t *dev = (codec_dev_t *) arg;
+    codec_dev_async_t *async = dev->async;
+    bool running = true;
+    while (running) {
+        codec_dev_sem_take(async->wake_sem, -1);
+        // Take snapshot of latest settings, commands superseded before worker runs are dropped
+        // Commands for closed direction are kept until it is opened
+        codec_dev_mutex_lock(async->lock);
+        uint8_t opened = _async_ctrl_opened_mask(dev);
+        codec_dev_async_t req = *async;
+        req.pending &= opened;
+        async->pending &= ~opened;
+        async->busy = (req.pending != 0);
+        running = async->running;
+        codec_dev_mutex_unlock(async->lock);
+        for (int i = 0; i < ESP_CODEC_DEV_CTRL_MAX; i++) {
+            if (req.pending & (1 << i)) {
+                _async_ctrl_run(dev, (esp_codec_dev_ctrl_cmd_t) i, &req);
+            }
+        }
+        codec_dev_mutex_lock(async->lock);
+        async->busy = false;
+        if (async->idle_wait) {
+            async->idle_wait = false;
+            codec_dev_sem_give(async->idle_sem);
+        }
+        codec_dev_mutex_unlock(async->lock);
+    }
+    codec_dev_sem_give(async->exit_sem);
+    codec_dev_thread_exit();
+}
+
+static void _async_ctrl_free(codec_dev_async_t *async)
+{
+    if (async->lock) {
+        codec_dev_mutex_delete(async->lock);
+    }
+    if (async->wake_sem) {
+        codec_dev_sem_delete(async->wake_sem);
+    }
+    if (async->exit_sem) {
+        codec_dev_sem_delete(async->exit_sem);
+    }
+    if (async->idle_sem) {
+        codec_dev_sem_delete(async->idle_sem);
+    }
+    free(async);
+}
+
+static int _async_ctrl_post(codec_dev_t *dev, esp_codec_dev_ctrl_cmd_t cmd, void *value)
+{
+    if (_async_ctrl_supported(dev, cmd) == false) {
+        return CODEC_DEV_NOT_SUPPORT;
+    }
+    codec_dev_async_t *async = dev->async;
+    codec_dev_mutex_lock(async->lock);
+    switch (cmd) {
+        case ESP_CODEC_DEV_CTRL_OUT_VOL:
+            async->volume = *(int *) value;
+            dev->volume = async->volume;
+            break;
+        case ESP_CODEC_DEV_CTRL_OUT_MUTE:
+            async->muted = *(bool *) value;
+            dev->muted = async->muted;
+            break;
+        case ESP_CODEC_DEV_CTRL_IN_GAIN:
+            async->mic_gain = *(float *) value;
+            dev->mic_gain = async->mic_gain;
+            break;
+        case ESP_CODEC_DEV_CTRL_IN_MUTE:
+            async->mic_muted = *(bool *) value;
+            dev->mic_muted = async->mic_muted;
+            break;
+        default:
+            break;
+    }
+    async->pending |= (1 << cmd);
+    codec_dev_mutex_unlock(async->lock);
+    codec_dev_sem_give(async->wake_sem);
+    return CODEC_DEV_OK;
+}
+
+int esp_codec_dev_set_async_ctrl(esp_codec_dev_handle_t handle, esp_codec_dev_async_ctrl_cfg_t *cfg)
+{
+    codec_dev_t *dev = (codec_dev_t *) handle;
+    if (dev == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    codec_dev_async_t *async = dev->async;
+    if (async) {
+        // Stop worker after pending commands executed
+        codec_dev_mutex_lock(async->lock);
+        async->running = false;
+        codec_dev_mutex_unlock(async->lock);
+        codec_dev_sem_give(async->wake_sem);
+        codec_dev_sem_take(async->exit_sem, -1);
+        dev->async = NULL;
+        // Execute commands kept for closed direction directly
+        for (int i = 0; i < ESP_CODEC_DEV_CTRL_MAX; i++) {
+            if (async->pending & (1 << i)) {
+                _async_ctrl_run(dev, (esp_codec_dev_ctrl_cmd_t) i, async);
+            }
+        }
+        _async_ctrl_free(async);
+    }
+    if (cfg == NULL) {
+        return CODEC_DEV_OK;
+    }
+    async = (codec_dev_async_t *) calloc(1, sizeof(codec_dev_async_t));
+    if (async == NULL) {
+        return CODEC_DEV_NO_MEM;
+    }
+    async->lock = codec_dev_mutex_create();
+    async->wake_sem = codec_dev_sem_create();
+    async->exit_sem = codec_dev_sem_create();
+    async->idle_sem = codec_dev_sem_create();
+    if (async->lock == NULL || async->wake_sem == NULL || async->exit_sem == NULL || async->idle_sem == NULL) {
+        _async_ctrl_free(async);
+        return CODEC_DEV_NO_MEM;
+    }
+    async->running = true;
+    async->done_cb = cfg->done_cb;
+    async->ctx = cfg->ctx;
+    dev->async = async;
+    int stack_size = cfg->task_stack ? cfg->task_stack : ASYNC_CTRL_STACK;
+    if (codec_dev_thread_create(_async_ctrl_thread, "CodecCtrl", dev, stack_size, cfg->task_prio) != 0) {
+        ESP_LOGE(TAG, "Fail to create control worker");
+        dev->async = NULL;
+        _async_ctrl_free(async);
+        return CODEC_DEV_NO_MEM;
+    }
+    return CODEC_DEV_OK;
+}
+
 int esp_codec_dev_set_out_vol(esp_codec_dev_handle_t handle, int volume)
 {
     codec_dev_t *dev = (codec_dev_t *) handle;
@@ -287,18 +661,11 @@ int esp_codec_dev_set_out_vol(esp_codec_dev_handle_t handle, int volume)
     if (ret != CODEC_DEV_OK) {
         return ret;
     }
-    const audio_codec_if_t *codec = dev->codec_if;
-    float db_value = _get_vol_db(&dev->vol_curve, volume);
-    db_value -= dev->hw_gain_db;
-    if (codec && codec->set_vol) {
-        codec->set_vol(codec, db_value);
-        dev->volume = volume;
-        return CODEC_DEV_OK;
-    } else if (dev->sw_vol) {
-        audio_codec_sw_vol_set(dev->sw_vol, db_value);
-        return CODEC_DEV_OK;
+    if (dev->async) {
+        return _async_ctrl_post(dev, ESP_CODEC_DEV_CTRL_OUT_VOL, &volume);
     }
-    return CODEC_DEV_NOT_SUPPORT;
+    ret = _set_out_vol(dev, volume);
+    return ret == CODEC_DEV_NOT_SUPPORT ? ret : CODEC_DEV_OK;
 }
 
 int esp_codec_dev_get_out_vol(esp_codec_dev_handle_t handle, int *volume)
@@ -325,13 +692,11 @@ int esp_codec_dev_set_out_mute(esp_codec_dev_handle_t handle, bool mute)
     if (ret != CODEC_DEV_OK) {
         return ret;
     }
-    const audio_codec_if_t *codec = dev->codec_if;
-    if (codec && codec->mute) {
-        codec->mute(codec, mute);
-        dev->muted = mute;
-        return CODEC_DEV_OK;
+    if (dev->async) {
+        return _async_ctrl_post(dev, ESP_CODEC_DEV_CTRL_OUT_MUTE, &mute);
     }
-    return CODEC_DEV_NOT_SUPPORT;
+    ret = _set_out_mute(dev, mute);
+    return ret == CODEC_DEV_NOT_SUPPORT ? ret : CODEC_DEV_OK;
 }
 
 int esp_codec_dev_get_out_mute(esp_codec_dev_handle_t handle, bool *muted)
@@ -358,13 +723,11 @@ int esp_codec_dev_set_in_gain(esp_codec_dev_handle_t handle, float db)
     if (ret != CODEC_DEV_OK) {
         return ret;
     }
-    const audio_codec_if_t *codec = dev->codec_if;
-    if (codec && codec->set_mic_gain) {
-        codec->set_mic_gain(codec, (int) db);
-        dev->mic_gain = db;
-        return CODEC_DEV_OK;
+    if (dev->async) {
+        return _async_ctrl_post(dev, ESP_CODEC_DEV_CTRL_IN_GAIN, &db);
     }
-    return CODEC_DEV_NOT_SUPPORT;
+    ret = _set_in_gain(dev, db);
+    return ret == CODEC_DEV_NOT_SUPPORT ? ret : CODEC_DEV_OK;
 }
 
 int esp_codec_dev_get_in_gain(esp_codec_dev_handle_t handle, float *db_value)
@@ -391,13 +754,11 @@ int esp_codec_dev_set_in_mute(esp_codec_dev_handle_t handle, bool mute)
     if (ret != CODEC_DEV_OK) {
         return ret;
     }
-    const audio_codec_if_t *codec = dev->codec_if;
-    if (codec && codec->mute_mic) {
-        codec->mute_mic(codec, mute);
-        dev->mic_muted = mute;
-        return CODEC_DEV_OK;
+    if (dev->async) {
+        return _async_ctrl_post(dev, ESP_CODEC_DEV_CTRL_IN_MUTE, &mute);
     }
-    return CODEC_DEV_NOT_SUPPORT;
+    ret = _set_in_mute(dev, mute);
+    return ret == CODEC_DEV_NOT_SUPPORT ? ret : CODEC_DEV_OK;
 }
 
 int esp_codec_dev_get_in_mute(esp_codec_dev_handle_t handle, bool *muted)
@@ -414,26 +775,53 @@ int esp_codec_dev_get_in_mute(esp_codec_dev_handle_t handle, bool *muted)
     return CODEC_DEV_OK;
 }
 
-int esp_codec_dev_close(esp_codec_dev_handle_t handle)
+static void _codec_dev_close(codec_dev_t *dev)
 {
-    codec_dev_t *dev = (codec_dev_t *) handle;
-    if (dev == NULL) {
-        return CODEC_DEV_INVALID_ARG;
-    }
     if (dev->output_opened == false && dev->input_opened == false) {
-        return CODEC_DEV_OK;
+        return;
     }
-    const audio_codec_if_t *codec = dev->codec_if;
-    if (codec) {
-        if (codec->enable) {
-            codec->enable(codec, false);
+    codec_dev_type_t dev_type = CODEC_DEV_TYPE_NONE;
+    if (dev->input_opened) {
+        dev_type |= CODEC_DEV_TYPE_IN;
+    }
+    if (dev->output_opened) {
+        dev_type |= CODEC_DEV_TYPE_OUT;
+    }
+    if (dev->sw_fade) {
+        // Give volume back to codec before path disabled so that it holds while software fade is closed
+        dev->sw_fade = false;
+        if (dev->vol_set) {
+            _set_out_vol(dev, dev->volume);
         }
     }
+    _enable_codec(dev, dev_type, false);
+    const audio_codec_data_if_t *data_if = dev->data_if;
+    if (data_if->set_fmt) {
+        // Release format of this direction so that other device on same port can renegotiate
+        data_if->set_fmt(data_if, dev_type, NULL);
+    }
     if (dev->sw_vol) {
         audio_codec_sw_vol_close(dev->sw_vol);
         dev->sw_vol = NULL;
     }
     dev->output_opened = dev->input_opened = false;
+}
+
+int esp_codec_dev_close(esp_codec_dev_handle_t handle)
+{
+    codec_dev_t *dev = (codec_dev_t *) handle;
+    if (dev == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    // Worker must not access codec or software volume while path is disabled and released
+    codec_dev_async_t *async = dev->async;
+    if (async) {
+        _async_ctrl_lock_idle(async);
+    }
+    _codec_dev_close(dev);
+    if (async) {
+        _async_ctrl_unlock(dev, async);
+    }
     return CODEC_DEV_OK;
 }
 
@@ -441,6 +829,7 @@ void esp_codec_dev_delete(esp_codec_dev_handle_t handle)
 {
     codec_dev_t *dev = (codec_dev_t *) handle;
     if (dev) {
+        esp_codec_dev_set_async_ctrl(handle, NULL);
         esp_codec_dev_close(handle);
         if (dev->vol_curve.vol_map) {
             free(dev->vol_curve.vol_map);
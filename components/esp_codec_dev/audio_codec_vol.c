@@ -119,8 +119,20 @@ int audio_codec_sw_vol_set(audio_codec_vol_handle_t h, float db_value)
     vol->gain = gain;
     float step = (float) (vol->gain - vol->cur) * 1000 / vol->duration / vol->fs.sample_rate;
     vol->step = (int) step;
-    if (step == 0) {
+    // Change too small to ramp, apply directly otherwise it never reaches target
+    if (vol->step == 0) {
         vol->cur = vol->gain;
     }
     return 0;
 }
+
+int audio_codec_sw_vol_set_direct(audio_codec_vol_handle_t h, float db_value)
+{
+    audio_vol_t *vol = (audio_vol_t *) h;
+    if (audio_codec_sw_vol_set(h, db_value) != 0) {
+        return -1;
+    }
+    vol->cur = vol->gain;
+    vol->step = 0;
+    return 0;
+}
@@ -23,7 +23,20 @@
  */
 
 #include <math.h>
+#include <stddef.h>
 #include "codec_dev_utils.h"
+#include "codec_dev_err.h"
+#include "codec_dev_os.h"
+
+#define REG_SEQ_BATCH_SIZE (16)
+
+typedef struct {
+    const audio_codec_ctrl_if_t *ctrl;
+    codec_reg_seq_stats_t       *stats;
+    codec_reg_val_pair_t         batch[REG_SEQ_BATCH_SIZE];
+    int                          batch_num;
+    bool                         locked;
+} reg_seq_run_t;
 
 int audio_codec_calc_vol_reg(const codec_dev_vol_range_t *vol_range, float db)
 {
@@ -65,3 +78,210 @@ float audio_codec_calc_vol_db(const codec_dev_vol_range_t *vol_range, int vol)
         (vol_range->max_vol.db_value - vol_range->min_vol.db_value) / (vol_range->max_vol.vol - vol_range->min_vol.vol);
     return ((vol - vol_range->min_vol.vol) * ratio + vol_range->min_vol.db_value);
 }
+
+int audio_codec_write_regs(const audio_codec_ctrl_if_t *ctrl, const codec_reg_val_pair_t *seq, int n)
+{
+    if (ctrl == NULL || seq == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (ctrl->write_regs) {
+        return ctrl->write_regs(ctrl, seq, n);
+    }
+    int ret = audio_codec_ctrl_acquire(ctrl, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    for (int i = 0; i < n; i++) {
+        int value = seq[i].value;
+        ret |= ctrl->write_addr(ctrl, seq[i].reg, 1, &value, 1);
+    }
+    audio_codec_ctrl_acquire(ctrl, false);
+    return ret ? CODEC_DEV_WRITE_FAIL : CODEC_DEV_OK;
+}
+
+int audio_codec_read_regs(const audio_codec_ctrl_if_t *ctrl, uint8_t reg, uint8_t *values, int n)
+{
+    if (ctrl == NULL || values == NULL || n <= 0) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    return ctrl->read_addr(ctrl, reg, 1, values, n);
+}
+
+int audio_codec_ctrl_acquire(const audio_codec_ctrl_if_t *ctrl, bool acquire)
+{
+    if (ctrl == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (ctrl->acquire_bus == NULL) {
+        return CODEC_DEV_OK;
+    }
+    return ctrl->acquire_bus(ctrl, acquire);
+}
+
+static int reg_seq_flush(reg_seq_run_t *run)
+{
+    if (run->batch_num == 0) {
+        return CODEC_DEV_OK;
+    }
+    int ret = CODEC_DEV_OK;
+    if (run->ctrl) {
+        ret = audio_codec_write_regs(run->ctrl, run->batch, run->batch_num);
+    }
+    run->stats->writes += run->batch_num;
+    run->stats->transactions += (run->ctrl == NULL || run->ctrl->write_regs) ? 1 : run->batch_num;
+    run->batch_num = 0;
+    return ret;
+}
+
+static int reg_seq_write(reg_seq_run_t *run, uint8_t reg, uint8_t value)
+{
+    if (run->batch_num == REG_SEQ_BATCH_SIZE) {
+        int ret = reg_seq_flush(run);
+        if (ret != CODEC_DEV_OK) {
+            return ret;
+        }
+    }
+    run->batch[run->batch_num].reg = reg;
+    run->batch[run->batch_num].value = value;
+    run->batch_num++;
+    return CODEC_DEV_OK;
+}
+
+static int reg_seq_update_bits(reg_seq_run_t *run, uint8_t reg, uint8_t mask, uint8_t value)
+{
+    uint8_t old = 0;
+    int i;
+    // Register written in current batch, no need to read back
+    for (i = run->batch_num - 1; i >= 0; i--) {
+        if (run->batch[i].reg == reg) {
+            old = run->batch[i].value;
+            break;
+        }
+    }
+    if (i < 0) {
+        int ret = reg_seq_flush(run);
+        if (ret != CODEC_DEV_OK) {
+            return ret;
+        }
+        run->stats->reads++;
+        run->stats->transactions++;
+        if (run->ctrl == NULL) {
+            return reg_seq_write(run, reg, value & mask);
+        }
+        if (audio_codec_read_regs(run->ctrl, reg, &old, 1) != CODEC_DEV_OK) {
+            return CODEC_DEV_READ_FAIL;
+        }
+    }
+    uint8_t new_value = (old & ~mask) | (value & mask);
+    if (new_value == old) {
+        run->stats->skipped++;
+        return CODEC_DEV_OK;
+    }
+    // Fold into pending write when it is the last one, else keep write order to other registers
+    if (i >= 0 && i == run->batch_num - 1) {
+        run->batch[i].value = new_value;
+        return CODEC_DEV_OK;
+    }
+    return reg_seq_write(run, reg, new_value);
+}
+
+static int reg_seq_delay(reg_seq_run_t *run, int ms)
+{
+    int ret = reg_seq_flush(run);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    run->stats->delay_ms += ms;
+    if (run->ctrl == NULL) {
+        return CODEC_DEV_OK;
+    }
+    // Not hold control bus during delay
+    audio_codec_ctrl_acquire(run->ctrl, false);
+    run->locked = false;
+    codec_dev_sleep(ms);
+    ret = audio_codec_ctrl_acquire(run->ctrl, true);
+    run->locked = (ret == CODEC_DEV_OK);
+    return ret;
+}
+
+static int reg_seq_run(reg_seq_run_t *run, const codec_reg_seq_t *seq, int n, uint32_t cond)
+{
+    int ret = CODEC_DEV_OK;
+    int i = 0;
+    while (i < n && ret == CODEC_DEV_OK) {
+        const codec_reg_seq_t *entry = &seq[i++];
+        switch (entry->op) {
+            case CODEC_REG_SEQ_OP_WRITE:
+                ret = reg_seq_write(run, entry->reg, entry->value);
+                break;
+            case CODEC_REG_SEQ_OP_UPDATE_BITS:
+                ret = reg_seq_update_bits(run, entry->reg, entry->mask, entry->value);
+                break;
+            case CODEC_REG_SEQ_OP_DELAY:
+                ret = reg_seq_delay(run, entry->value);
+                break;
+            case CODEC_REG_SEQ_OP_IF:
+                if (entry->reg >= 32 || i + entry->value > n) {
+                    ret = CODEC_DEV_INVALID_ARG;
+                } else if (((cond >> entry->reg) & 1) != entry->mask) {
+                    i += entry->value;
+                }
+                break;
+            case CODEC_REG_SEQ_OP_BURST: {
+                // Data bytes packed 4 per entry right after burst entry
+                int data_entries = (entry->value + 3) / 4;
+                if (i + data_entries > n || entry->reg + entry->value > 0x100) {
+                    ret = CODEC_DEV_INVALID_ARG;
+                    break;
+                }
+                const uint8_t *data = (const uint8_t *) (seq + i);
+                for (int j = 0; j < entry->value && ret == CODEC_DEV_OK; j++) {
+                    ret = reg_seq_write(run, entry->reg + j, data[j]);
+                }
+                i += data_entries;
+                break;
+            }
+            default:
+                ret = CODEC_DEV_INVALID_ARG;
+                break;
+        }
+    }
+    if (ret == CODEC_DEV_OK) {
+        ret = reg_seq_flush(run);
+    }
+    return ret;
+}
+
+int audio_codec_run_reg_seq(const audio_codec_ctrl_if_t *ctrl, const codec_reg_seq_t *seq, int n, uint32_t cond,
+                            codec_reg_seq_stats_t *stats)
+{
+    if (ctrl == NULL || seq == NULL || n < 0) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    codec_reg_seq_stats_t run_stats = {0};
+    reg_seq_run_t run = {
+        .ctrl = ctrl,
+        .stats = stats ? stats : &run_stats,
+    };
+    int ret = audio_codec_ctrl_acquire(ctrl, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    run.locked = true;
+    ret = reg_seq_run(&run, seq, n, cond);
+    if (run.locked) {
+        audio_codec_ctrl_acquire(ctrl, false);
+    }
+    return ret;
+}
+
+int audio_codec_count_reg_seq(const codec_reg_seq_t *seq, int n, uint32_t cond, codec_reg_seq_stats_t *stats)
+{
+    if (seq == NULL || n < 0 || stats == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    reg_seq_run_t run = {
+        .stats = stats,
+    };
+    return reg_seq_run(&run, seq, n, cond);
+}
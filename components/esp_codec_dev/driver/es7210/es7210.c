@@ -62,18 +62,18 @@ typedef struct {
  * Clock coefficient structer
  */
 struct _coeff_div {
-    uint32_t mclk; /* mclk frequency */
-    uint32_t lrck; /* lrck */
-    uint8_t  ss_ds;
-    uint8_t  adc_div;  /* adcclk divider */
-    uint8_t  dll;      /* dll_bypass */
-    uint8_t  doubler;  /* doubler enable */
-    uint8_t  osr;      /* adc osr */
-    uint8_t  mclk_src; /* select mclk  source */
-    uint32_t lrck_h;   /* The high 4 bits of lrck */
-    uint32_t lrck_l;   /* The low 8 bits of lrck */
+    uint32_t mclk;    /* mclk frequency */
+    uint32_t lrck;    /* lrck */
+    uint8_t  mainclk; /* adc_div, doubler and dll in register 0x02 */
+    uint8_t  lrck_h;  /* The high 4 bits of lrck */
+    uint8_t  lrck_l;  /* The low 8 bits of lrck */
+    uint8_t  osr;     /* adc osr */
 };
 
+/* Build register values of one coefficient row at compile time, ss_ds and mclk_src are not used by register */
+#define ES7210_COEFF(mclk, lrck, ss_ds, adc_div, dll, doubler, osr, mclk_src, lrck_h, lrck_l) \
+    {(mclk), (lrck), (adc_div) | ((doubler) << 6) | ((dll) << 7), (lrck_h), (lrck_l), (osr)}
+
 /* Codec hifi mclk clock divider coefficients
  *           MEMBER      REG
  *           mclk:       0x03
@@ -86,57 +86,64 @@ struct _coeff_div {
  *           mclk_src:   0x03
  *           lrckh:      0x04
  *           lrckl:      0x05
+ * Sorted by lrck then mclk for binary search
  */
 static const struct _coeff_div coeff_div[] = {
   //  mclk      lrck    ss_ds adc_div  dll  doubler osr  mclk_src  lrckh   lrckl
   /* 8k */
-    {12288000, 8000,  0x00, 0x03, 0x01, 0x00, 0x20, 0x00, 0x06, 0x00},
-    {16384000, 8000,  0x00, 0x04, 0x01, 0x00, 0x20, 0x00, 0x08, 0x00},
-    {19200000, 8000,  0x00, 0x1e, 0x00, 0x01, 0x28, 0x00, 0x09, 0x60},
-    {4096000,  8000,  0x00, 0x01, 0x01, 0x00, 0x20, 0x00, 0x02, 0x00},
+    ES7210_COEFF(4096000,  8000,  0x00, 0x01, 0x01, 0x00, 0x20, 0x00, 0x02, 0x00),
+    ES7210_COEFF(12288000, 8000,  0x00, 0x03, 0x01, 0x00, 0x20, 0x00, 0x06, 0x00),
+    ES7210_COEFF(16384000, 8000,  0x00, 0x04, 0x01, 0x00, 0x20, 0x00, 0x08, 0x00),
+    ES7210_COEFF(19200000, 8000,  0x00, 0x1e, 0x00, 0x01, 0x28, 0x00, 0x09, 0x60),
 
  /* 11.025k */
-    {11289600, 11025, 0x00, 0x02, 0x01, 0x00, 0x20, 0x00, 0x01, 0x00},
+    ES7210_COEFF(11289600, 11025, 0x00, 0x02, 0x01, 0x00, 0x20, 0x00, 0x01, 0x00),
 
  /* 12k */
-    {12288000, 12000, 0x00, 0x02, 0x01, 0x00, 0x20, 0x00, 0x04, 0x00},
-    {19200000, 12000, 0x00, 0x14, 0x00, 0x01, 0x28, 0x00, 0x06, 0x40},
+    ES7210_COEFF(12288000, 12000, 0x00, 0x02, 0x01, 0x00, 0x20, 0x00, 0x04, 0x00),
+    ES7210_COEFF(19200000, 12000, 0x00, 0x14, 0x00, 0x01, 0x28, 0x00, 0x06, 0x40),
 
  /* 16k */
-    {4096000,  16000, 0x00, 0x01, 0x01, 0x01, 0x20, 0x00, 0x01, 0x00},
-    {19200000, 16000, 0x00, 0x0a, 0x00, 0x00, 0x1e, 0x00, 0x04, 0x80},
-    {16384000, 16000, 0x00, 0x02, 0x01, 0x00, 0x20, 0x00, 0x04, 0x00},
-    {12288000, 16000, 0x00, 0x03, 0x01, 0x01, 0x20, 0x00, 0x03, 0x00},
+    ES7210_COEFF(4096000,  16000, 0x00, 0x01, 0x01, 0x01, 0x20, 0x00, 0x01, 0x00),
+    ES7210_COEFF(12288000, 16000, 0x00, 0x03, 0x01, 0x01, 0x20, 0x00, 0x03, 0x00),
+    ES7210_COEFF(16384000, 16000, 0x00, 0x02, 0x01, 0x00, 0x20, 0x00, 0x04, 0x00),
+    ES7210_COEFF(19200000, 16000, 0x00, 0x0a, 0x00, 0x00, 0x1e, 0x00, 0x04, 0x80),
 
  /* 22.05k */
-    {11289600, 22050, 0x00, 0x01, 0x01, 0x00, 0x20, 0x00, 0x02, 0x00},
+    ES7210_COEFF(11289600, 22050, 0x00, 0x01, 0x01, 0x00, 0x20, 0x00, 0x02, 0x00),
 
  /* 24k */
-    {12288000, 24000, 0x00, 0x01, 0x01, 0x00, 0x20, 0x00, 0x02, 0x00},
-    {19200000, 24000, 0x00, 0x0a, 0x00, 0x01, 0x28, 0x00, 0x03, 0x20},
+    ES7210_COEFF(12288000, 24000, 0x00, 0x01, 0x01, 0x00, 0x20, 0x00, 0x02, 0x00),
+    ES7210_COEFF(19200000, 24000, 0x00, 0x0a, 0x00, 0x01, 0x28, 0x00, 0x03, 0x20),
 
  /* 32k */
-    {12288000, 32000, 0x00, 0x03, 0x00, 0x00, 0x20, 0x00, 0x01, 0x80},
-    {16384000, 32000, 0x00, 0x01, 0x01, 0x00, 0x20, 0x00, 0x02, 0x00},
-    {19200000, 32000, 0x00, 0x05, 0x00, 0x00, 0x1e, 0x00, 0x02, 0x58},
+    ES7210_COEFF(12288000, 32000, 0x00, 0x03, 0x00, 0x00, 0x20, 0x00, 0x01, 0x80),
+    ES7210_COEFF(16384000, 32000, 0x00, 0x01, 0x01, 0x00, 0x20, 0x00, 0x02, 0x00),
+    ES7210_COEFF(19200000, 32000, 0x00, 0x05, 0x00, 0x00, 0x1e, 0x00, 0x02, 0x58),
 
  /* 44.1k */
-    {11289600, 44100, 0x00, 0x01, 0x01, 0x01, 0x20, 0x00, 0x01, 0x00},
+    ES7210_COEFF(11289600, 44100, 0x00, 0x01, 0x01, 0x01, 0x20, 0x00, 0x01, 0x00),
 
  /* 48k */
-    {12288000, 48000, 0x00, 0x01, 0x01, 0x01, 0x20, 0x00, 0x01, 0x00},
-    {19200000, 48000, 0x00, 0x05, 0x00, 0x01, 0x28, 0x00, 0x01, 0x90},
+    ES7210_COEFF(12288000, 48000, 0x00, 0x01, 0x01, 0x01, 0x20, 0x00, 0x01, 0x00),
+    ES7210_COEFF(19200000, 48000, 0x00, 0x05, 0x00, 0x01, 0x28, 0x00, 0x01, 0x90),
 
  /* 64k */
-    {16384000, 64000, 0x01, 0x01, 0x01, 0x00, 0x20, 0x00, 0x01, 0x00},
-    {19200000, 64000, 0x00, 0x05, 0x00, 0x01, 0x1e, 0x00, 0x01, 0x2c},
+    ES7210_COEFF(16384000, 64000, 0x01, 0x01, 0x01, 0x00, 0x20, 0x00, 0x01, 0x00),
+    ES7210_COEFF(19200000, 64000, 0x00, 0x05, 0x00, 0x01, 0x1e, 0x00, 0x01, 0x2c),
 
  /* 88.2k */
-    {11289600, 88200, 0x01, 0x01, 0x01, 0x01, 0x20, 0x00, 0x00, 0x80},
+    ES7210_COEFF(11289600, 88200, 0x01, 0x01, 0x01, 0x01, 0x20, 0x00, 0x00, 0x80),
 
  /* 96k */
-    {12288000, 96000, 0x01, 0x01, 0x01, 0x01, 0x20, 0x00, 0x00, 0x80},
-    {19200000, 96000, 0x01, 0x05, 0x00, 0x01, 0x28, 0x00, 0x00, 0xc8},
+    ES7210_COEFF(12288000, 96000, 0x01, 0x01, 0x01, 0x01, 0x20, 0x00, 0x00, 0x80),
+    ES7210_COEFF(19200000, 96000, 0x01, 0x05, 0x00, 0x01, 0x28, 0x00, 0x00, 0xc8),
+};
+
+const codec_reg_cache_desc_t es7210_reg_cache_desc = {
+    .reg_num = 0x50,
+    .reset_reg = ES7210_RESET_REG00,
+    .volatile_mask = NULL,
 };
 
 static int es7210_write_reg(audio_codec_es7210_t *codec, int reg, int value)
@@ -153,51 +160,54 @@ static int es7210_read_reg(audio_codec_es7210_t *codec, int reg, int *value)
 static int es7210_update_reg_bit(audio_codec_es7210_t *codec, uint8_t reg_addr, uint8_t update_bits, uint8_t data)
 {
     int regv = 0;
+    // Hold bus so that read-modify-write is not interleaved by other device on same bus
+    int ret = audio_codec_ctrl_acquire(codec->ctrl_if, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
     es7210_read_reg(codec, reg_addr, &regv);
     regv = (regv & (~update_bits)) | (update_bits & data);
-    return es7210_write_reg(codec, reg_addr, regv);
+    ret = es7210_write_reg(codec, reg_addr, regv);
+    audio_codec_ctrl_acquire(codec->ctrl_if, false);
+    return ret;
 }
 
 static int get_coeff(uint32_t mclk, uint32_t lrck)
 {
-    for (int i = 0; i < (sizeof(coeff_div) / sizeof(coeff_div[0])); i++) {
-        if (coeff_div[i].lrck == lrck && coeff_div[i].mclk == mclk)
-            return i;
+    int low = 0;
+    int high = sizeof(coeff_div) / sizeof(coeff_div[0]) - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (coeff_div[mid].lrck == lrck && coeff_div[mid].mclk == mclk) {
+            return mid;
+        }
+        if (coeff_div[mid].lrck < lrck || (coeff_div[mid].lrck == lrck && coeff_div[mid].mclk < mclk)) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
     }
     return -1;
 }
 
-static int es7210_config_sample(audio_codec_es7210_t *codec, int sample_fre)
+static int es7210_config_sample(audio_codec_es7210_t *codec, codec_sample_info_t *fs)
 {
-    int regv;
-    int coeff;
-    int mclk_fre = 0;
-    int ret = 0;
-    mclk_fre = sample_fre * MCLK_DIV_FRE;
-    coeff = get_coeff(mclk_fre, sample_fre);
+    uint32_t sample_fre = fs->sample_rate;
+    /* Use MCLK fed by data interface, else suppose default MCLK multiple */
+    uint32_t mclk_fre = fs->mclk ? fs->mclk : sample_fre * MCLK_DIV_FRE;
+    int coeff = get_coeff(mclk_fre, sample_fre);
     if (coeff < 0) {
         ESP_LOGE(TAG, "Unable to configure sample rate %dHz with %dHz MCLK", sample_fre, mclk_fre);
         return ESP_FAIL;
     }
-    /* Set clock parammeters */
-    if (coeff >= 0) {
-        /* Set adc_div & doubler & dll */
-        ret |= es7210_read_reg(codec, ES7210_MAINCLK_REG02, &regv);
-        regv &= 0x00;
-        regv |= coeff_div[coeff].adc_div;
-        regv |= coeff_div[coeff].doubler << 6;
-        regv |= coeff_div[coeff].dll << 7;
-        ret |= es7210_write_reg(codec, ES7210_MAINCLK_REG02, regv);
-        /* Set osr */
-        regv = coeff_div[coeff].osr;
-        ret |= es7210_write_reg(codec, ES7210_OSR_REG07, regv);
-        /* Set lrck */
-        regv = coeff_div[coeff].lrck_h;
-        ret |= es7210_write_reg(codec, ES7210_LRCK_DIVH_REG04, regv);
-        regv = coeff_div[coeff].lrck_l;
-        ret |= es7210_write_reg(codec, ES7210_LRCK_DIVL_REG05, regv);
-    }
-    return ret;
+    /* Set adc_div & doubler & dll, lrck and osr in one transaction */
+    const codec_reg_val_pair_t clk_regs[] = {
+        {ES7210_MAINCLK_REG02, coeff_div[coeff].mainclk},
+        {ES7210_LRCK_DIVH_REG04, coeff_div[coeff].lrck_h},
+        {ES7210_LRCK_DIVL_REG05, coeff_div[coeff].lrck_l},
+        {ES7210_OSR_REG07, coeff_div[coeff].osr},
+    };
+    return audio_codec_write_regs(codec->ctrl_if, clk_regs, sizeof(clk_regs) / sizeof(clk_regs[0]));
 }
 
 static int es7210_mic_select(audio_codec_es7210_t *codec, es7210_input_mics_t mic)
@@ -367,12 +377,12 @@ void es7210_read_all(const audio_codec_if_t *h)
     if (codec == NULL) {
         return;
     }
-    for (int i = 0; i <= 0x4E; i++) {
-        int reg = 0;
-        if (es7210_read_reg(codec, i, &reg) != CODEC_DEV_OK) {
-            break;
-        }
-        ESP_LOGI(TAG, "REG:%02x, %02x\n", reg, i);
+    uint8_t regs[0x4F];
+    if (audio_codec_read_regs(codec->ctrl_if, 0, regs, sizeof(regs)) != CODEC_DEV_OK) {
+        return;
+    }
+    for (int i = 0; i < sizeof(regs); i++) {
+        ESP_LOGI(TAG, "REG:%02x, %02x\n", regs[i], i);
     }
 }
 
@@ -539,10 +549,9 @@ static int es7210_set_fs(const audio_codec_if_t *h, codec_sample_info_t *fs)
     int ret = 0;
     ESP_LOGI(TAG, "ES7210 set fs");
     ret |= es7210_set_bits(codec, fs->bits_per_sample);
-    ret |= es7210_config_sample(codec, fs->sample_rate);
-    if (fs->channel == 1) {
-        ret |= es7210_config_fmt(codec, ES_I2S_LEFT);
-    } else if (fs->channel == 2) {
+    ret |= es7210_config_sample(codec, fs);
+    // I2S data interface runs in standard I2S format for mono as well, TDM keeps its own format
+    if (fs->channel <= 2) {
         ret |= es7210_config_fmt(codec, ES_I2S_NORMAL);
     }
     return ret == 0 ? CODEC_DEV_OK : CODEC_DEV_WRITE_FAIL;
@@ -27,6 +27,7 @@
 #include "es7243e.h"
 #include "esp_log.h"
 #include "codec_dev_os.h"
+#include "codec_dev_utils.h"
 
 #define TAG "ES7243E"
 typedef struct {
@@ -35,6 +36,12 @@ typedef struct {
     bool                         is_open;
 } audio_codec_es7243e_t;
 
+const codec_reg_cache_desc_t es7243e_reg_cache_desc = {
+    .reg_num = 0x100,
+    .reset_reg = 0x00,
+    .volatile_mask = NULL,
+};
+
 static uint8_t get_db_reg(float db)
 {
     db += 0.5;
@@ -89,6 +96,46 @@ int es7243e_adc_enable(audio_codec_es7243e_t *codec, bool enable)
     return ret;
 }
 
+static const codec_reg_seq_t es7243e_open_seq[] = {
+    CODEC_REG_SEQ_WRITE(0x01, 0x3A),
+    CODEC_REG_SEQ_WRITE(0x00, 0x80),
+    CODEC_REG_SEQ_WRITE(0xF9, 0x00),
+    CODEC_REG_SEQ_WRITE(0x04, 0x02),
+    CODEC_REG_SEQ_WRITE(0x04, 0x01),
+    CODEC_REG_SEQ_WRITE(0xF9, 0x01),
+    CODEC_REG_SEQ_WRITE(0x00, 0x1E),
+    CODEC_REG_SEQ_WRITE(0x01, 0x00),
+
+    CODEC_REG_SEQ_WRITE(0x02, 0x00),
+    CODEC_REG_SEQ_WRITE(0x03, 0x20),
+    CODEC_REG_SEQ_WRITE(0x04, 0x01),
+    CODEC_REG_SEQ_WRITE(0x0D, 0x00),
+    CODEC_REG_SEQ_WRITE(0x05, 0x00),
+    CODEC_REG_SEQ_WRITE(0x06, 0x03), // SCLK=MCLK/4
+    CODEC_REG_SEQ_WRITE(0x07, 0x00), // LRCK=MCLK/256
+    CODEC_REG_SEQ_WRITE(0x08, 0xFF), // LRCK=MCLK/256
+
+    CODEC_REG_SEQ_WRITE(0x09, 0xCA),
+    CODEC_REG_SEQ_WRITE(0x0A, 0x85),
+    CODEC_REG_SEQ_WRITE(0x0B, 0x00),
+    CODEC_REG_SEQ_WRITE(0x0E, 0xBF),
+    CODEC_REG_SEQ_WRITE(0x0F, 0x80),
+    CODEC_REG_SEQ_WRITE(0x14, 0x0C),
+    CODEC_REG_SEQ_WRITE(0x15, 0x0C),
+    CODEC_REG_SEQ_BURST(0x17, 6),
+    CODEC_REG_SEQ_DATA(0x02, 0x26, 0x77, 0xF4),
+    CODEC_REG_SEQ_DATA(0x66, 0x44, 0x00, 0x00),
+    CODEC_REG_SEQ_WRITE(0x1E, 0x00),
+    CODEC_REG_SEQ_WRITE(0x1F, 0x0C),
+    CODEC_REG_SEQ_WRITE(0x20, 0x1A), // PGA gain +30dB
+    CODEC_REG_SEQ_WRITE(0x21, 0x1A), // PGA gain +30dB
+
+    CODEC_REG_SEQ_WRITE(0x00, 0x80), // Slave  Mode
+    CODEC_REG_SEQ_WRITE(0x01, 0x3A),
+    CODEC_REG_SEQ_WRITE(0x16, 0x3F),
+    CODEC_REG_SEQ_WRITE(0x16, 0x00),
+};
+
 static int es7243e_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
 {
     audio_codec_es7243e_t *codec = (audio_codec_es7243e_t *) h;
@@ -98,47 +145,7 @@ static int es7243e_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
     }
     codec->ctrl_if = codec_cfg->ctrl_if;
 
-    int ret = 0;
-    ret |= es7243e_write_reg(codec, 0x01, 0x3A);
-    ret |= es7243e_write_reg(codec, 0x00, 0x80);
-    ret |= es7243e_write_reg(codec, 0xF9, 0x00);
-    ret |= es7243e_write_reg(codec, 0x04, 0x02);
-    ret |= es7243e_write_reg(codec, 0x04, 0x01);
-    ret |= es7243e_write_reg(codec, 0xF9, 0x01);
-    ret |= es7243e_write_reg(codec, 0x00, 0x1E);
-    ret |= es7243e_write_reg(codec, 0x01, 0x00);
-
-    ret |= es7243e_write_reg(codec, 0x02, 0x00);
-    ret |= es7243e_write_reg(codec, 0x03, 0x20);
-    ret |= es7243e_write_reg(codec, 0x04, 0x01);
-    ret |= es7243e_write_reg(codec, 0x0D, 0x00);
-    ret |= es7243e_write_reg(codec, 0x05, 0x00);
-    ret |= es7243e_write_reg(codec, 0x06, 0x03); // SCLK=MCLK/4
-    ret |= es7243e_write_reg(codec, 0x07, 0x00); // LRCK=MCLK/256
-    ret |= es7243e_write_reg(codec, 0x08, 0xFF); // LRCK=MCLK/256
-
-    ret |= es7243e_write_reg(codec, 0x09, 0xCA);
-    ret |= es7243e_write_reg(codec, 0x0A, 0x85);
-    ret |= es7243e_write_reg(codec, 0x0B, 0x00);
-    ret |= es7243e_write_reg(codec, 0x0E, 0xBF);
-    ret |= es7243e_write_reg(codec, 0x0F, 0x80);
-    ret |= es7243e_write_reg(codec, 0x14, 0x0C);
-    ret |= es7243e_write_reg(codec, 0x15, 0x0C);
-    ret |= es7243e_write_reg(codec, 0x17, 0x02);
-    ret |= es7243e_write_reg(codec, 0x18, 0x26);
-    ret |= es7243e_write_reg(codec, 0x19, 0x77);
-    ret |= es7243e_write_reg(codec, 0x1A, 0xF4);
-    ret |= es7243e_write_reg(codec, 0x1B, 0x66);
-    ret |= es7243e_write_reg(codec, 0x1C, 0x44);
-    ret |= es7243e_write_reg(codec, 0x1E, 0x00);
-    ret |= es7243e_write_reg(codec, 0x1F, 0x0C);
-    ret |= es7243e_write_reg(codec, 0x20, 0x1A); // PGA gain +30dB
-    ret |= es7243e_write_reg(codec, 0x21, 0x1A); // PGA gain +30dB
-
-    ret |= es7243e_write_reg(codec, 0x00, 0x80); // Slave  Mode
-    ret |= es7243e_write_reg(codec, 0x01, 0x3A);
-    ret |= es7243e_write_reg(codec, 0x16, 0x3F);
-    ret |= es7243e_write_reg(codec, 0x16, 0x00);
+    int ret = audio_codec_run_reg_seq(codec->ctrl_if, es7243e_open_seq, CODEC_REG_SEQ_NUM(es7243e_open_seq), 0, NULL);
     if (ret != 0) {
         ESP_LOGI(TAG, "Fail to write register");
         return CODEC_DEV_WRITE_FAIL;
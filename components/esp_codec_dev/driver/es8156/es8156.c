@@ -55,6 +55,17 @@ const codec_dev_vol_range_t vol_range = {
     },
 };
 
+static const uint8_t es8156_volatile_regs[0x100 / 8] = {
+    [ES8156_CHIP_STATUS_REG0C >> 3] = (1 << (ES8156_CHIP_STATUS_REG0C & 7)),
+    [ES8156_I2C_PAGESEL_REGFC >> 3] = (1 << (ES8156_I2C_PAGESEL_REGFC & 7)),
+};
+
+const codec_reg_cache_desc_t es8156_reg_cache_desc = {
+    .reg_num = 0x100,
+    .reset_reg = ES8156_RESET_REG00,
+    .volatile_mask = es8156_volatile_regs,
+};
+
 static int es8156_write_reg(audio_codec_es8156_t *codec, int reg, int value)
 {
     return codec->ctrl_if->write_addr(codec->ctrl_if, reg, 1, &value, 1);
@@ -160,6 +171,27 @@ void es8156_pa_power(audio_codec_es8156_t *codec, bool enable)
     ESP_LOGI(TAG, "PA gpio %d enable %d", pa_pin, enable);
 }
 
+static const codec_reg_seq_t es8156_open_seq[] = {
+    CODEC_REG_SEQ_WRITE(0x02, 0x04),
+    CODEC_REG_SEQ_WRITE(0x20, 0x2A),
+    CODEC_REG_SEQ_WRITE(0x21, 0x3C),
+    CODEC_REG_SEQ_WRITE(0x22, 0x00),
+    CODEC_REG_SEQ_WRITE(0x24, 0x07),
+    CODEC_REG_SEQ_WRITE(0x23, 0x00),
+
+    CODEC_REG_SEQ_WRITE(0x0A, 0x01),
+    CODEC_REG_SEQ_WRITE(0x0B, 0x01),
+    CODEC_REG_SEQ_WRITE(0x11, 0x00),
+    CODEC_REG_SEQ_WRITE(0x14, 179), // volume 70%
+
+    CODEC_REG_SEQ_WRITE(0x0D, 0x14),
+    CODEC_REG_SEQ_WRITE(0x18, 0x00),
+    CODEC_REG_SEQ_WRITE(0x08, 0x3F),
+    CODEC_REG_SEQ_WRITE(0x00, 0x02),
+    CODEC_REG_SEQ_WRITE(0x00, 0x03),
+    CODEC_REG_SEQ_WRITE(0x25, 0x20),
+};
+
 int es8156_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
 {
     audio_codec_es8156_t *codec = (audio_codec_es8156_t *) h;
@@ -171,24 +203,7 @@ int es8156_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
     codec->ctrl_if = codec_cfg->ctrl_if;
     codec->pa_pin = codec_cfg->pa_pin;
 
-    ret |= es8156_write_reg(codec, 0x02, 0x04);
-    ret |= es8156_write_reg(codec, 0x20, 0x2A);
-    ret |= es8156_write_reg(codec, 0x21, 0x3C);
-    ret |= es8156_write_reg(codec, 0x22, 0x00);
-    ret |= es8156_write_reg(codec, 0x24, 0x07);
-    ret |= es8156_write_reg(codec, 0x23, 0x00);
-
-    ret |= es8156_write_reg(codec, 0x0A, 0x01);
-    ret |= es8156_write_reg(codec, 0x0B, 0x01);
-    ret |= es8156_write_reg(codec, 0x11, 0x00);
-    ret |= es8156_write_reg(codec, 0x14, 179); // volume 70%
-
-    ret |= es8156_write_reg(codec, 0x0D, 0x14);
-    ret |= es8156_write_reg(codec, 0x18, 0x00);
-    ret |= es8156_write_reg(codec, 0x08, 0x3F);
-    ret |= es8156_write_reg(codec, 0x00, 0x02);
-    ret |= es8156_write_reg(codec, 0x00, 0x03);
-    ret |= es8156_write_reg(codec, 0x25, 0x20);
+    ret = audio_codec_run_reg_seq(codec->ctrl_if, es8156_open_seq, CODEC_REG_SEQ_NUM(es8156_open_seq), 0, NULL);
     if (ret != 0) {
         return CODEC_DEV_WRITE_FAIL;
     }
@@ -43,128 +43,160 @@ typedef struct {
     audio_codec_if_t   base;
     es8311_codec_cfg_t cfg;
     bool               is_open;
-    bool               enabled;
+    codec_dev_type_t   enabled_path;
 } audio_codec_es8311_t;
 
+/* Coefficient table holds REG02 to REG08, REG01 is also updated in the same burst to select MCLK source */
+#define ES8311_CLK_REG_NUM (ES8311_CLK_MANAGER_REG08 - ES8311_CLK_MANAGER_REG02 + 1)
+#define ES8311_MCLK_FROM_SCLK (0x80)
+/* REG37 DAC soft ramp rate 0.25dB per 32 LRCK, ramps DAC volume and mute changes */
+#define ES8311_DAC_RAMP_RATE (0x40)
+#define ES8311_DAC_EQ_BYPASS (0x08)
+
 /*
  * Clock coefficient structer
  */
 struct _coeff_div {
-    uint32_t mclk;      /* mclk frequency */
-    uint32_t rate;      /* sample rate */
-    uint8_t  pre_div;   /* the pre divider with range from 1 to 8 */
-    uint8_t  pre_multi; /* the pre multiplier with x1, x2, x4 and x8 selection */
-    uint8_t  adc_div;   /* adcclk divider */
-    uint8_t  dac_div;   /* dacclk divider */
-    uint8_t  fs_mode;   /* double speed or single speed, =0, ss, =1, ds */
-    uint8_t  lrck_h;    /* adclrck divider and daclrck divider */
-    uint8_t  lrck_l;
-    uint8_t  bclk_div; /* sclk divider */
-    uint8_t  adc_osr;  /* adc osr */
-    uint8_t  dac_osr;  /* dac osr */
+    uint32_t mclk;                        /* mclk frequency */
+    uint32_t rate;                        /* sample rate */
+    uint8_t  clk_reg[ES8311_CLK_REG_NUM]; /* register image of REG02 to REG08 */
 };
 
-/* codec hifi mclk clock divider coefficients */
+#define ES8311_PRE_MULTI_SEL(multi) ((multi) == 8 ? 3 : (multi) == 4 ? 2 : (multi) == 2 ? 1 : 0)
+
+/*
+ * Build register image of one coefficient row at compile time
+ *     pre_div:  the pre divider with range from 1 to 8
+ *     multi:    the pre multiplier with x1, x2, x4 and x8 selection
+ *     adc_div:  adcclk divider
+ *     dac_div:  dacclk divider
+ *     fs:       double speed or single speed, =0, ss, =1, ds
+ *     lrck_h:   adclrck divider and daclrck divider
+ *     bclk_div: sclk divider
+ */
+#define ES8311_COEFF(mclk, rate, pre_div, multi, adc_div, dac_div, fs, lrck_h, lrck_l, bclk_div, adc_osr, dac_osr) \
+    {                                                                                                              \
+        (mclk), (rate),                                                                                            \
+        {                                                                                                          \
+            (((pre_div) - 1) << 5) | (ES8311_PRE_MULTI_SEL(multi) << 3), ((fs) << 6) | (adc_osr), (dac_osr),       \
+            (((adc_div) - 1) << 4) | ((dac_div) - 1), (bclk_div) < 19 ? (bclk_div) - 1 : (bclk_div), (lrck_h),     \
+            (lrck_l),                                                                                              \
+        },                                                                                                         \
+    }
+
+/* Register bits of REG01 to REG08 kept when clock setting changes */
+static const uint8_t es8311_clk_reg_keep[ES8311_CLK_REG_NUM + 1] = {0x7F, 0x07, 0x80, 0x80, 0x00, 0xE0, 0xC0, 0x00};
+
+/*
+ * Codec clock selected for one sample rate
+ */
+typedef struct {
+    int  coeff;     /* index in coeff_div[] table */
+    bool from_sclk; /* use SCLK as internal MCLK instead of MCLK pin */
+    int  multi_sel; /* pre multiplier selection override, -1 to use value in table */
+} es8311_clk_plan_t;
+
+/* codec hifi mclk clock divider coefficients, sorted by rate then mclk for binary search */
 static const struct _coeff_div coeff_div[] = {
   //  mclk     rate   pre_div  mult  adc_div dac_div fs_mode lrch  lrcl  bckdiv osr
   /* 8k */
-    {12288000, 8000,  0x06, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {18432000, 8000,  0x03, 0x02, 0x03, 0x03, 0x00, 0x05, 0xff, 0x18, 0x10, 0x20},
-    {16384000, 8000,  0x08, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {8192000,  8000,  0x04, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {6144000,  8000,  0x03, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {4096000,  8000,  0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {3072000,  8000,  0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {2048000,  8000,  0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {1536000,  8000,  0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {1024000,  8000,  0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
+    ES8311_COEFF(1024000,  8000,  0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(1536000,  8000,  0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(2048000,  8000,  0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(3072000,  8000,  0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(4096000,  8000,  0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(6144000,  8000,  0x03, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(8192000,  8000,  0x04, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(12288000, 8000,  0x06, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(16384000, 8000,  0x08, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(18432000, 8000,  0x03, 0x02, 0x03, 0x03, 0x00, 0x05, 0xff, 0x18, 0x10, 0x20),
 
  /* 11.025k */
-    {11289600, 11025, 0x04, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {5644800,  11025, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {2822400,  11025, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {1411200,  11025, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
+    ES8311_COEFF(1411200,  11025, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(2822400,  11025, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(5644800,  11025, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(11289600, 11025, 0x04, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
 
  /* 12k */
-    {12288000, 12000, 0x04, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {6144000,  12000, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {3072000,  12000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {1536000,  12000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
+    ES8311_COEFF(1536000,  12000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(3072000,  12000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(6144000,  12000, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(12288000, 12000, 0x04, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
 
  /* 16k */
-    {12288000, 16000, 0x03, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {18432000, 16000, 0x03, 0x02, 0x03, 0x03, 0x00, 0x02, 0xff, 0x0c, 0x10, 0x20},
-    {16384000, 16000, 0x04, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {8192000,  16000, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {6144000,  16000, 0x03, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {4096000,  16000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {3072000,  16000, 0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {2048000,  16000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {1536000,  16000, 0x03, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
-    {1024000,  16000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20},
+    ES8311_COEFF(1024000,  16000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(1536000,  16000, 0x03, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(2048000,  16000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(3072000,  16000, 0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(4096000,  16000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(6144000,  16000, 0x03, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(8192000,  16000, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(12288000, 16000, 0x03, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(16384000, 16000, 0x04, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x20),
+    ES8311_COEFF(18432000, 16000, 0x03, 0x02, 0x03, 0x03, 0x00, 0x02, 0xff, 0x0c, 0x10, 0x20),
 
  /* 22.05k */
-    {11289600, 22050, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {5644800,  22050, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {2822400,  22050, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {1411200,  22050, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
+    ES8311_COEFF(1411200,  22050, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(2822400,  22050, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(5644800,  22050, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(11289600, 22050, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
 
  /* 24k */
-    {12288000, 24000, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {18432000, 24000, 0x03, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {6144000,  24000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {3072000,  24000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {1536000,  24000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
+    ES8311_COEFF(1536000,  24000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(3072000,  24000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(6144000,  24000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(12288000, 24000, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(18432000, 24000, 0x03, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
 
  /* 32k */
-    {12288000, 32000, 0x03, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {18432000, 32000, 0x03, 0x04, 0x03, 0x03, 0x00, 0x02, 0xff, 0x0c, 0x10, 0x10},
-    {16384000, 32000, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {8192000,  32000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {6144000,  32000, 0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {4096000,  32000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {3072000,  32000, 0x03, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {2048000,  32000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {1536000,  32000, 0x03, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10},
-    {1024000,  32000, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
+    ES8311_COEFF(1024000,  32000, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(1536000,  32000, 0x03, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10),
+    ES8311_COEFF(2048000,  32000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(3072000,  32000, 0x03, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(4096000,  32000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(6144000,  32000, 0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(8192000,  32000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(12288000, 32000, 0x03, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(16384000, 32000, 0x02, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(18432000, 32000, 0x03, 0x04, 0x03, 0x03, 0x00, 0x02, 0xff, 0x0c, 0x10, 0x10),
 
  /* 44.1k */
-    {11289600, 44100, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {5644800,  44100, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {2822400,  44100, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {1411200,  44100, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
+    ES8311_COEFF(1411200,  44100, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(2822400,  44100, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(5644800,  44100, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(11289600, 44100, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
 
  /* 48k */
-    {12288000, 48000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {18432000, 48000, 0x03, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {6144000,  48000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {3072000,  48000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {1536000,  48000, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
+    ES8311_COEFF(1536000,  48000, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(3072000,  48000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(6144000,  48000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(12288000, 48000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(18432000, 48000, 0x03, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
 
  /* 64k */
-    {12288000, 64000, 0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {18432000, 64000, 0x03, 0x04, 0x03, 0x03, 0x01, 0x01, 0x7f, 0x06, 0x10, 0x10},
-    {16384000, 64000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {8192000,  64000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {6144000,  64000, 0x01, 0x04, 0x03, 0x03, 0x01, 0x01, 0x7f, 0x06, 0x10, 0x10},
-    {4096000,  64000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {3072000,  64000, 0x01, 0x08, 0x03, 0x03, 0x01, 0x01, 0x7f, 0x06, 0x10, 0x10},
-    {2048000,  64000, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {1536000,  64000, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0xbf, 0x03, 0x18, 0x18},
-    {1024000,  64000, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10},
+    ES8311_COEFF(1024000,  64000, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10),
+    ES8311_COEFF(1536000,  64000, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0xbf, 0x03, 0x18, 0x18),
+    ES8311_COEFF(2048000,  64000, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(3072000,  64000, 0x01, 0x08, 0x03, 0x03, 0x01, 0x01, 0x7f, 0x06, 0x10, 0x10),
+    ES8311_COEFF(4096000,  64000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(6144000,  64000, 0x01, 0x04, 0x03, 0x03, 0x01, 0x01, 0x7f, 0x06, 0x10, 0x10),
+    ES8311_COEFF(8192000,  64000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(12288000, 64000, 0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(16384000, 64000, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(18432000, 64000, 0x03, 0x04, 0x03, 0x03, 0x01, 0x01, 0x7f, 0x06, 0x10, 0x10),
 
  /* 88.2k */
-    {11289600, 88200, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {5644800,  88200, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {2822400,  88200, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {1411200,  88200, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10},
+    ES8311_COEFF(1411200,  88200, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10),
+    ES8311_COEFF(2822400,  88200, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(5644800,  88200, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(11289600, 88200, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
 
  /* 96k */
-    {12288000, 96000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {18432000, 96000, 0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {6144000,  96000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {3072000,  96000, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10},
-    {1536000,  96000, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10},
+    ES8311_COEFF(1536000,  96000, 0x01, 0x08, 0x01, 0x01, 0x01, 0x00, 0x7f, 0x02, 0x10, 0x10),
+    ES8311_COEFF(3072000,  96000, 0x01, 0x08, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(6144000,  96000, 0x01, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(12288000, 96000, 0x01, 0x02, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
+    ES8311_COEFF(18432000, 96000, 0x03, 0x04, 0x01, 0x01, 0x00, 0x00, 0xff, 0x04, 0x10, 0x10),
 };
 
 static const codec_dev_vol_range_t vol_range = {
@@ -178,6 +210,16 @@ static const codec_dev_vol_range_t vol_range = {
     },
 };
 
+static const uint8_t es8311_volatile_regs[0x100 / 8] = {
+    [0xFC >> 3] = (1 << (0xFC & 7)),
+};
+
+const codec_reg_cache_desc_t es8311_reg_cache_desc = {
+    .reg_num = 0x100,
+    .reset_reg = ES8311_RESET_REG00,
+    .volatile_mask = es8311_volatile_regs,
+};
+
 static int es8311_write_reg(audio_codec_es8311_t *codec, int reg, int value)
 {
     return codec->cfg.ctrl_if->write_addr(codec->cfg.ctrl_if, reg, 1, &value, 1);
@@ -256,83 +298,180 @@ int es8311_set_bits_per_sample(audio_codec_es8311_t *codec, int bits)
  */
 static int get_coeff(uint32_t mclk, uint32_t rate)
 {
-    for (int i = 0; i < (sizeof(coeff_div) / sizeof(coeff_div[0])); i++) {
-        if (coeff_div[i].rate == rate && coeff_div[i].mclk == mclk)
-            return i;
+    int low = 0;
+    int high = sizeof(coeff_div) / sizeof(coeff_div[0]) - 1;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (coeff_div[mid].rate == rate && coeff_div[mid].mclk == mclk) {
+            return mid;
+        }
+        if (coeff_div[mid].rate < rate || (coeff_div[mid].rate == rate && coeff_div[mid].mclk < mclk)) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
     }
     return CODEC_DEV_NOT_FOUND;
 }
 
+typedef enum {
+    ES8311_PWR_COND_CHIP,     /*!< Shared analog circuitry changes power, first path up or last path down */
+    ES8311_PWR_COND_ADC,      /*!< ADC path changes power */
+    ES8311_PWR_COND_DAC,      /*!< DAC path changes power */
+    ES8311_PWR_COND_ADC_IDLE, /*!< ADC path stays down when chip powers up */
+    ES8311_PWR_COND_DAC_IDLE, /*!< DAC path stays down when chip powers up */
+    ES8311_PWR_COND_DMIC,     /*!< ADC path powers up using digital microphone */
+} es8311_pwr_cond_t;
+
+/*
+ * Power up only the paths being enabled, registers of running path are not touched
+ */
+static const codec_reg_seq_t es8311_power_up_seq[] = {
+    // Serial data port of path not used is tri-stated
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC_IDLE, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_SDPOUT_REG0A, 0x40, 0x40),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DAC_IDLE, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_SDPIN_REG09, 0x40, 0x40),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_SDPOUT_REG0A, 0x40, 0x00),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DAC, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_SDPIN_REG09, 0x40, 0x00),
+
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC, 2),
+    CODEC_REG_SEQ_WRITE(ES8311_ADC_REG17, 0xBF),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG0E, 0x02),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DAC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG12, 0x00),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG14, 0x1A),
+    // PDM digital microphone enable
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DMIC, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_SYSTEM_REG14, 0x40, 0x40),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_CHIP, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG0D, 0x01),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_ADC_REG15, 0x40),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DAC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_DAC_REG37, ES8311_DAC_RAMP_RATE | ES8311_DAC_EQ_BYPASS),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_CHIP, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_GP_REG45, 0x00),
+};
+
+/*
+ * Power down only the paths being disabled, shared analog circuitry goes down with the last path
+ */
+static const codec_reg_seq_t es8311_power_down_seq[] = {
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DAC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_DAC_REG32, 0x00),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC, 2),
+    CODEC_REG_SEQ_WRITE(ES8311_ADC_REG17, 0x00),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG0E, 0xFF),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DAC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG12, 0x02),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG14, 0x00),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_CHIP, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG0D, 0xFA),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_ADC_REG15, 0x00),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DAC, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_DAC_REG37, ES8311_DAC_EQ_BYPASS),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_CHIP, 1),
+    CODEC_REG_SEQ_WRITE(ES8311_GP_REG45, 0x01),
+    // Tri-state serial data port of path powered down
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_ADC, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_SDPOUT_REG0A, 0x40, 0x40),
+    CODEC_REG_SEQ_IF(ES8311_PWR_COND_DAC, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_SDPIN_REG09, 0x40, 0x40),
+};
+
+static codec_dev_type_t es8311_get_mode_path(audio_codec_es8311_t *codec)
+{
+    switch (codec->cfg.codec_mode) {
+        case CODEC_WORK_MODE_ADC:
+            return CODEC_DEV_TYPE_IN;
+        case CODEC_WORK_MODE_DAC:
+            return CODEC_DEV_TYPE_OUT;
+        case CODEC_WORK_MODE_BOTH:
+            return CODEC_DEV_TYPE_IN_OUT;
+        default:
+            return CODEC_DEV_TYPE_NONE;
+    }
+}
+
 /*
- * set es8311 into suspend mode
+ * set es8311 into suspend mode, all paths powered down whatever current state is
  */
 static int es8311_suspend(audio_codec_es8311_t *codec)
 {
     ESP_LOGI(TAG, "Enter into es8311_suspend()");
-    es8311_write_reg(codec, ES8311_DAC_REG32, 0x00);
-    es8311_write_reg(codec, ES8311_ADC_REG17, 0x00);
-    es8311_write_reg(codec, ES8311_SYSTEM_REG0E, 0xFF);
-    es8311_write_reg(codec, ES8311_SYSTEM_REG12, 0x02);
-    es8311_write_reg(codec, ES8311_SYSTEM_REG14, 0x00);
-    es8311_write_reg(codec, ES8311_SYSTEM_REG0D, 0xFA);
-    es8311_write_reg(codec, ES8311_ADC_REG15, 0x00);
-    es8311_write_reg(codec, ES8311_DAC_REG37, 0x08);
-    return es8311_write_reg(codec, ES8311_GP_REG45, 0x01);
+    uint32_t cond = BIT(ES8311_PWR_COND_CHIP) | BIT(ES8311_PWR_COND_ADC) | BIT(ES8311_PWR_COND_DAC);
+    int ret = audio_codec_run_reg_seq(codec->cfg.ctrl_if, es8311_power_down_seq,
+                                      CODEC_REG_SEQ_NUM(es8311_power_down_seq), cond, NULL);
+    codec->enabled_path = CODEC_DEV_TYPE_NONE;
+    return ret;
 }
 
-static int es8311_start(audio_codec_es8311_t *codec)
+/*
+ * Power paths up or down incrementally so that running path is not glitched
+ */
+static int es8311_set_path(audio_codec_es8311_t *codec, codec_dev_type_t path)
 {
-    int ret = CODEC_DEV_OK;
-    int adc_iface = 0, dac_iface = 0;
-
-    ret = es8311_read_reg(codec, ES8311_SDPIN_REG09, &dac_iface);
-    ret |= es8311_read_reg(codec, ES8311_SDPOUT_REG0A, &adc_iface);
-    if (ret != CODEC_DEV_OK) {
-        return ret;
-    }
-    dac_iface &= 0xBF;
-    adc_iface &= 0xBF;
-    adc_iface |= BIT(6);
-    dac_iface |= BIT(6);
-    int codec_mode = codec->cfg.codec_mode;
-    if (codec_mode == CODEC_WORK_MODE_LINE) {
+    codec_dev_type_t mode_path = es8311_get_mode_path(codec);
+    if (mode_path == CODEC_DEV_TYPE_NONE && path != CODEC_DEV_TYPE_NONE) {
         ESP_LOGE(TAG, "The codec es8311 doesn't support ES_MODULE_LINE mode");
         return CODEC_DEV_NOT_SUPPORT;
     }
-    if (codec_mode == CODEC_WORK_MODE_ADC || codec_mode == CODEC_WORK_MODE_BOTH) {
-        adc_iface &= ~(BIT(6));
-    }
-    if (codec_mode == CODEC_WORK_MODE_DAC || codec_mode == CODEC_WORK_MODE_BOTH) {
-        dac_iface &= ~(BIT(6));
-    }
-
-    ret |= es8311_write_reg(codec, ES8311_SDPIN_REG09, dac_iface);
-    ret |= es8311_write_reg(codec, ES8311_SDPOUT_REG0A, adc_iface);
-
-    ret |= es8311_write_reg(codec, ES8311_ADC_REG17, 0xBF);
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG0E, 0x02);
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG12, 0x00);
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG14, 0x1A);
-
-    /*
-     * pdm dmic enable or disable
-     */
-    int regv = 0;
-    if (codec->cfg.digital_mic) {
-        ret |= es8311_read_reg(codec, ES8311_SYSTEM_REG14, &regv);
-        regv |= 0x40;
-        ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG14, regv);
-    } else {
-        ret |= es8311_read_reg(codec, ES8311_SYSTEM_REG14, &regv);
-        regv &= ~(0x40);
-        ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG14, regv);
+    path &= mode_path;
+    codec_dev_type_t old_path = codec->enabled_path;
+    codec_dev_type_t down = old_path & ~path;
+    codec_dev_type_t up = path & ~old_path;
+    int ret = CODEC_DEV_OK;
+    if (down) {
+        uint32_t cond = 0;
+        if (path == CODEC_DEV_TYPE_NONE) {
+            cond |= BIT(ES8311_PWR_COND_CHIP);
+        }
+        if (down & CODEC_DEV_TYPE_IN) {
+            cond |= BIT(ES8311_PWR_COND_ADC);
+        }
+        if (down & CODEC_DEV_TYPE_OUT) {
+            cond |= BIT(ES8311_PWR_COND_DAC);
+        }
+        ret = audio_codec_run_reg_seq(codec->cfg.ctrl_if, es8311_power_down_seq,
+                                      CODEC_REG_SEQ_NUM(es8311_power_down_seq), cond, NULL);
+        if (ret != CODEC_DEV_OK) {
+            return ret;
+        }
+        codec->enabled_path &= ~down;
+    }
+    if (up) {
+        uint32_t cond = 0;
+        if (old_path == CODEC_DEV_TYPE_NONE) {
+            cond |= BIT(ES8311_PWR_COND_CHIP);
+            if ((path & CODEC_DEV_TYPE_IN) == 0) {
+                cond |= BIT(ES8311_PWR_COND_ADC_IDLE);
+            }
+            if ((path & CODEC_DEV_TYPE_OUT) == 0) {
+                cond |= BIT(ES8311_PWR_COND_DAC_IDLE);
+            }
+        }
+        if (up & CODEC_DEV_TYPE_IN) {
+            cond |= BIT(ES8311_PWR_COND_ADC);
+            if (codec->cfg.digital_mic) {
+                cond |= BIT(ES8311_PWR_COND_DMIC);
+            }
+        }
+        if (up & CODEC_DEV_TYPE_OUT) {
+            cond |= BIT(ES8311_PWR_COND_DAC);
+        }
+        ret = audio_codec_run_reg_seq(codec->cfg.ctrl_if, es8311_power_up_seq, CODEC_REG_SEQ_NUM(es8311_power_up_seq),
+                                      cond, NULL);
+        if (ret != CODEC_DEV_OK) {
+            return ret;
+        }
+        codec->enabled_path |= up;
     }
-
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG0D, 0x01);
-    ret |= es8311_write_reg(codec, ES8311_ADC_REG15, 0x40);
-    ret |= es8311_write_reg(codec, ES8311_DAC_REG37, 0x48);
-    ret |= es8311_write_reg(codec, ES8311_GP_REG45, 0x00);
-
     return ret;
 }
 
@@ -358,17 +497,19 @@ int es8311_set_mute(const audio_codec_if_t *h, bool mute)
     }
     int regv;
     ESP_LOGI(TAG, "Enter into es8311_mute(), mute = %d\n", mute);
-    int ret = es8311_read_reg(codec, ES8311_DAC_REG31, &regv);
+    int ret = audio_codec_ctrl_acquire(codec->cfg.ctrl_if, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    ret = es8311_read_reg(codec, ES8311_DAC_REG31, &regv);
     regv &= 0x9f;
+    // Soft ramp set in REG37 fades output, DAC power and volume are kept so that un-mute restores them
     if (mute) {
-        es8311_write_reg(codec, ES8311_SYSTEM_REG12, 0x02);
-        es8311_write_reg(codec, ES8311_DAC_REG31, regv | 0x60);
-        es8311_write_reg(codec, ES8311_DAC_REG32, 0x00);
-        es8311_write_reg(codec, ES8311_DAC_REG37, 0x08);
+        ret |= es8311_write_reg(codec, ES8311_DAC_REG31, regv | 0x60);
     } else {
-        es8311_write_reg(codec, ES8311_DAC_REG31, regv);
-        es8311_write_reg(codec, ES8311_SYSTEM_REG12, 0x00);
+        ret |= es8311_write_reg(codec, ES8311_DAC_REG31, regv);
     }
+    audio_codec_ctrl_acquire(codec->cfg.ctrl_if, false);
     return ret;
 }
 
@@ -442,84 +583,130 @@ void es8311_pa_power(audio_codec_es8311_t *codec, bool enable)
     ESP_LOGI(TAG, "PA gpio %d enable %d", pa_pin, enable);
 }
 
-int es8311_config_sample(audio_codec_es8311_t *codec, int sample_rate)
+/*
+ * Select clock divider for sample rate, prefer MCLK pin when MCLK fed by data interface matches one coefficient
+ * Fall back to SCLK as MCLK in slave mode, SCLK is multiplied to 256 * LRCK when no coefficient matches SCLK directly
+ */
+static int es8311_plan_clock(audio_codec_es8311_t *codec, codec_sample_info_t *fs, es8311_clk_plan_t *plan)
 {
-    int datmp, regv;
-    int mclk_fre = sample_rate * MCLK_DIV_FRE;
-    int coeff = get_coeff(mclk_fre, sample_rate);
-    if (coeff < 0) {
-        ESP_LOGE(TAG, "Unable to configure sample rate %dHz with %dHz MCLK", sample_rate, mclk_fre);
+    uint32_t rate = fs->sample_rate;
+    plan->from_sclk = false;
+    plan->multi_sel = -1;
+    if (codec->cfg.use_mclk) {
+        uint32_t mclk = fs->mclk ? fs->mclk : rate * MCLK_DIV_FRE;
+        plan->coeff = get_coeff(mclk, rate);
+        if (plan->coeff >= 0) {
+            return CODEC_DEV_OK;
+        }
+        if (codec->cfg.master_mode) {
+            ESP_LOGE(TAG, "Unable to configure sample rate %dHz with %dHz MCLK", rate, mclk);
+            return CODEC_DEV_NOT_SUPPORT;
+        }
+        ESP_LOGW(TAG, "No divider for %dHz with %dHz MCLK, use SCLK as MCLK", rate, mclk);
+    } else if (codec->cfg.master_mode) {
+        // Master drives SCLK itself, so it can not take SCLK as clock source
+        ESP_LOGE(TAG, "Master mode needs MCLK to generate %dHz", rate);
         return CODEC_DEV_NOT_SUPPORT;
     }
-    int ret = 0;
-    /*
-     * Set clock parammeters
-     */
-    ret = es8311_read_reg(codec, ES8311_CLK_MANAGER_REG02, &regv);
-    regv &= 0x7;
-    regv |= (coeff_div[coeff].pre_div - 1) << 5;
-    datmp = 0;
-    switch (coeff_div[coeff].pre_multi) {
-        case 1:
-            datmp = 0;
-            break;
-        case 2:
-            datmp = 1;
-            break;
-        case 4:
-            datmp = 2;
-            break;
-        case 8:
-            datmp = 3;
-            break;
-        default:
-            break;
+    uint32_t sclk = rate * (fs->bits_per_sample ? fs->bits_per_sample : 16) * 2;
+    plan->from_sclk = true;
+    plan->coeff = get_coeff(sclk, rate);
+    if (plan->coeff >= 0) {
+        return CODEC_DEV_OK;
     }
+    plan->coeff = get_coeff(rate * MCLK_DIV_FRE, rate);
+    if (plan->coeff >= 0 && coeff_div[plan->coeff].clk_reg[0] == 0) {
+        for (int sel = 0; sel <= 3; sel++) {
+            if ((sclk << sel) == rate * MCLK_DIV_FRE) {
+                plan->multi_sel = sel; /* DIG_MCLK = LRCK * 256 = SCLK * multiplier */
+                return CODEC_DEV_OK;
+            }
+        }
+    }
+    ESP_LOGE(TAG, "Unable to configure sample rate %dHz with %dHz SCLK", rate, sclk);
+    return CODEC_DEV_NOT_SUPPORT;
+}
 
-    if (codec->cfg.master_mode == false) {
-        datmp = 3; /* DIG_MCLK = LRCK * 256 = BCLK * 8 */
-    }
-    regv |= (datmp) << 3;
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG02, regv);
-    // TODO check this logic
-    ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG05, &regv);
-    regv &= 0x00;
-    regv |= (coeff_div[coeff].adc_div - 1) << 4;
-    regv |= (coeff_div[coeff].dac_div - 1) << 0;
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG05, regv);
-
-    ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG03, &regv);
-    regv &= 0x80;
-    regv |= coeff_div[coeff].fs_mode << 6;
-    regv |= coeff_div[coeff].adc_osr << 0;
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG03, regv);
-
-    ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG04, &regv);
-    regv &= 0x80;
-    regv |= coeff_div[coeff].dac_osr << 0;
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG04, regv);
-
-    ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG07, &regv);
-    regv &= 0xC0;
-    regv |= coeff_div[coeff].lrck_h << 0;
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG07, regv);
-    // TODO check this logic
-    ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG08, &regv);
-    regv &= 0x00;
-    regv |= coeff_div[coeff].lrck_l << 0;
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG08, regv);
-
-    ret = es8311_read_reg(codec, ES8311_CLK_MANAGER_REG06, &regv);
-    regv &= 0xE0;
-    if (coeff_div[coeff].bclk_div < 19) {
-        regv |= (coeff_div[coeff].bclk_div - 1) << 0;
-    } else {
-        regv |= (coeff_div[coeff].bclk_div) << 0;
+int es8311_config_sample(audio_codec_es8311_t *codec, codec_sample_info_t *fs)
+{
+    es8311_clk_plan_t plan;
+    int ret = es8311_plan_clock(codec, fs, &plan);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    uint8_t regv[ES8311_CLK_REG_NUM + 1];
+    codec_reg_val_pair_t clk_regs[ES8311_CLK_REG_NUM + 1];
+    ret = audio_codec_ctrl_acquire(codec->cfg.ctrl_if, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    // Read and write all clock registers in one burst, only bits not in coefficient table are kept
+    ret = audio_codec_read_regs(codec->cfg.ctrl_if, ES8311_CLK_MANAGER_REG01, regv, ES8311_CLK_REG_NUM + 1);
+    for (int i = 0; i <= ES8311_CLK_REG_NUM; i++) {
+        clk_regs[i].reg = ES8311_CLK_MANAGER_REG01 + i;
+        clk_regs[i].value = regv[i] & es8311_clk_reg_keep[i];
+        if (i > 0) {
+            clk_regs[i].value |= coeff_div[plan.coeff].clk_reg[i - 1];
+        }
     }
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG06, regv);
+    if (plan.from_sclk) {
+        clk_regs[0].value |= ES8311_MCLK_FROM_SCLK;
+    }
+    if (plan.multi_sel >= 0) {
+        clk_regs[1].value = (clk_regs[1].value & ~0x18) | (plan.multi_sel << 3);
+    }
+    if (ret == CODEC_DEV_OK) {
+        ret = audio_codec_write_regs(codec->cfg.ctrl_if, clk_regs, ES8311_CLK_REG_NUM + 1);
+    }
+    audio_codec_ctrl_acquire(codec->cfg.ctrl_if, false);
     return ret == 0 ? CODEC_DEV_OK : CODEC_DEV_WRITE_FAIL;
 }
 
+typedef enum {
+    ES8311_SEQ_COND_MASTER,      /*!< Codec works as I2S master */
+    ES8311_SEQ_COND_INVERT_MCLK, /*!< MCLK inverted */
+    ES8311_SEQ_COND_INVERT_SCLK, /*!< SCLK inverted */
+    ES8311_SEQ_COND_USE_MCLK,    /*!< MCLK pin used as clock source */
+} es8311_seq_cond_t;
+
+static const codec_reg_seq_t es8311_open_seq[] = {
+    // Initial register settings before reset
+    CODEC_REG_SEQ_WRITE(ES8311_CLK_MANAGER_REG01, 0x30),
+    CODEC_REG_SEQ_WRITE(ES8311_CLK_MANAGER_REG02, 0x00),
+    CODEC_REG_SEQ_WRITE(ES8311_CLK_MANAGER_REG03, 0x10),
+    CODEC_REG_SEQ_WRITE(ES8311_ADC_REG16, 0x24),
+    CODEC_REG_SEQ_WRITE(ES8311_CLK_MANAGER_REG04, 0x10),
+    CODEC_REG_SEQ_WRITE(ES8311_CLK_MANAGER_REG05, 0x00),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG0B, 0x00),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG0C, 0x00),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG10, 0x1F),
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG11, 0x7F),
+    CODEC_REG_SEQ_WRITE(ES8311_RESET_REG00, 0x80),
+    // Set master/slave audio interface
+    CODEC_REG_SEQ_IF(ES8311_SEQ_COND_MASTER, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_RESET_REG00, 0x40, 0x40),
+    CODEC_REG_SEQ_IF_NOT(ES8311_SEQ_COND_MASTER, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_RESET_REG00, 0x40, 0x00),
+    CODEC_REG_SEQ_WRITE(ES8311_CLK_MANAGER_REG01, 0x3F),
+    // Use SCLK as internal MCLK if MCLK pin not used
+    CODEC_REG_SEQ_IF_NOT(ES8311_SEQ_COND_USE_MCLK, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_CLK_MANAGER_REG01, ES8311_MCLK_FROM_SCLK, ES8311_MCLK_FROM_SCLK),
+    // MCLK inverted or not
+    CODEC_REG_SEQ_IF(ES8311_SEQ_COND_INVERT_MCLK, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_CLK_MANAGER_REG01, 0x40, 0x40),
+    CODEC_REG_SEQ_IF_NOT(ES8311_SEQ_COND_INVERT_MCLK, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_CLK_MANAGER_REG01, 0x40, 0x00),
+    // SCLK inverted or not
+    CODEC_REG_SEQ_IF(ES8311_SEQ_COND_INVERT_SCLK, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_CLK_MANAGER_REG06, 0x20, 0x20),
+    CODEC_REG_SEQ_IF_NOT(ES8311_SEQ_COND_INVERT_SCLK, 1),
+    CODEC_REG_SEQ_UPDATE(ES8311_CLK_MANAGER_REG06, 0x20, 0x00),
+
+    CODEC_REG_SEQ_WRITE(ES8311_SYSTEM_REG13, 0x10),
+    CODEC_REG_SEQ_WRITE(ES8311_ADC_REG1B, 0x0A),
+    CODEC_REG_SEQ_WRITE(ES8311_ADC_REG1C, 0x6A),
+};
+
 int es8311_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
 {
     audio_codec_es8311_t *codec = (audio_codec_es8311_t *) h;
@@ -528,72 +715,24 @@ int es8311_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
         return CODEC_DEV_INVALID_ARG;
     }
     memcpy(&codec->cfg, cfg, sizeof(es8311_codec_cfg_t));
-    int regv;
-    int ret = CODEC_DEV_OK;
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG01, 0x30);
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG02, 0x00);
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG03, 0x10);
-    ret |= es8311_write_reg(codec, ES8311_ADC_REG16, 0x24);
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG04, 0x10);
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG05, 0x00);
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG0B, 0x00);
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG0C, 0x00);
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG10, 0x1F);
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG11, 0x7F);
-    ret |= es8311_write_reg(codec, ES8311_RESET_REG00, 0x80);
-    /*
-     * Set Codec into Master or Slave mode
-     */
-    ret = es8311_read_reg(codec, ES8311_RESET_REG00, &regv);
-    /*
-     * Set master/slave audio interface
-     */
+    uint32_t cond = 0;
     if (codec_cfg->master_mode) {
         ESP_LOGI(TAG, "ES8311 in Master mode");
-        regv |= 0x40;
+        cond |= BIT(ES8311_SEQ_COND_MASTER);
     } else {
         ESP_LOGI(TAG, "ES8311 in Slave mode");
-        regv &= 0xBF;
-    }
-    ret |= es8311_write_reg(codec, ES8311_RESET_REG00, regv);
-    ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG01, 0x3F);
-    /*
-     * Select clock source for internal mclk
-     */
-    ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG01, &regv);
-    if (codec_cfg->use_mclk) {
-        regv &= 0x7F;
-    } else {
-        regv |= 0x80;
     }
-    /*
-     * mclk inverted or not
-     */
     if (codec_cfg->invert_mclk) {
-        ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG01, &regv);
-        regv |= 0x40;
-        ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG01, regv);
-    } else {
-        ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG01, &regv);
-        regv &= ~(0x40);
-        ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG01, regv);
+        cond |= BIT(ES8311_SEQ_COND_INVERT_MCLK);
     }
-    /*
-     * sclk inverted or not
-     */
     if (codec_cfg->invert_sclk) {
-        ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG06, &regv);
-        regv |= 0x20;
-        ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG06, regv);
-    } else {
-        ret |= es8311_read_reg(codec, ES8311_CLK_MANAGER_REG06, &regv);
-        regv &= ~(0x20);
-        ret |= es8311_write_reg(codec, ES8311_CLK_MANAGER_REG06, regv);
+        cond |= BIT(ES8311_SEQ_COND_INVERT_SCLK);
     }
-
-    ret |= es8311_write_reg(codec, ES8311_SYSTEM_REG13, 0x10);
-    ret |= es8311_write_reg(codec, ES8311_ADC_REG1B, 0x0A);
-    ret |= es8311_write_reg(codec, ES8311_ADC_REG1C, 0x6A);
+    if (codec_cfg->use_mclk) {
+        cond |= BIT(ES8311_SEQ_COND_USE_MCLK);
+    }
+    int ret =
+        audio_codec_run_reg_seq(codec->cfg.ctrl_if, es8311_open_seq, CODEC_REG_SEQ_NUM(es8311_open_seq), cond, NULL);
     if (ret != 0) {
         return CODEC_DEV_WRITE_FAIL;
     }
@@ -623,18 +762,13 @@ int es8311_set_fs(const audio_codec_if_t *h, codec_sample_info_t *fs)
         return CODEC_DEV_INVALID_ARG;
     }
     es8311_set_bits_per_sample(codec, fs->bits_per_sample);
-    if (fs->channel == 1) {
-        es8311_config_fmt(codec, ES_I2S_LEFT);
-    } else {
-        es8311_config_fmt(codec, ES_I2S_NORMAL);
-    }
-    es8311_config_sample(codec, fs->sample_rate);
-    return CODEC_DEV_OK;
+    // I2S data interface runs in standard I2S format for mono as well
+    es8311_config_fmt(codec, ES_I2S_NORMAL);
+    return es8311_config_sample(codec, fs);
 }
 
 int es8311_enable(const audio_codec_if_t *h, bool enable)
 {
-    int ret = CODEC_DEV_OK;
     audio_codec_es8311_t *codec = (audio_codec_es8311_t *) h;
     if (codec == NULL) {
         return CODEC_DEV_INVALID_ARG;
@@ -642,22 +776,37 @@ int es8311_enable(const audio_codec_if_t *h, bool enable)
     if (codec->is_open == false) {
         return CODEC_DEV_WRONG_STATE;
     }
-    if (enable == codec->enabled) {
-        return CODEC_DEV_OK;
-    }
-    if (enable) {
-        ret = es8311_start(codec);
-        ESP_LOGI(TAG, "Start ret %d", ret);
-    } else {
-        ESP_LOGW(TAG, "The codec is about to stop");
-        ret = es8311_suspend(codec);
+    // Without path information all paths of work mode are enabled
+    int ret = es8311_set_path(codec, enable ? CODEC_DEV_TYPE_IN_OUT : CODEC_DEV_TYPE_NONE);
+    ESP_LOGI(TAG, "Enable %d ret %d", enable, ret);
+    return ret;
+}
+
+static int es8311_enable_path(const audio_codec_if_t *h, codec_dev_type_t dev_type, bool enable)
+{
+    audio_codec_es8311_t *codec = (audio_codec_es8311_t *) h;
+    if (codec == NULL) {
+        return CODEC_DEV_INVALID_ARG;
     }
-    if (ret == CODEC_DEV_OK) {
-        codec->enabled = enable;
+    if (codec->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
     }
+    codec_dev_type_t path = enable ? (codec->enabled_path | dev_type) : (codec->enabled_path & ~dev_type);
+    int ret = es8311_set_path(codec, path);
+    ESP_LOGI(TAG, "Path %d enable %d ret %d", dev_type, enable, ret);
     return ret;
 }
 
+static int es8311_get_caps(const audio_codec_if_t *h, uint32_t *caps)
+{
+    audio_codec_es8311_t *codec = (audio_codec_es8311_t *) h;
+    if (codec == NULL || caps == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    *caps = CODEC_IF_CAP_VOL_RAMP;
+    return CODEC_DEV_OK;
+}
+
 static int es8311_set_reg(const audio_codec_if_t *h, int reg, int value)
 {
     audio_codec_es8311_t *codec = (audio_codec_es8311_t *) h;
@@ -699,6 +848,8 @@ const audio_codec_if_t *es8311_codec_new(es8311_codec_cfg_t *codec_cfg)
     }
     codec->base.open = es8311_open;
     codec->base.enable = es8311_enable;
+    codec->base.enable_path = es8311_enable_path;
+    codec->base.get_caps = es8311_get_caps;
     codec->base.set_fs = es8311_set_fs;
     codec->base.set_vol = es8311_set_vol;
     codec->base.set_mic_gain = es8311_set_mic_gain;
@@ -50,6 +50,12 @@ static const codec_dev_vol_range_t vol_range = {
     },
 };
 
+const codec_reg_cache_desc_t es8374_reg_cache_desc = {
+    .reg_num = 0x100,
+    .reset_reg = 0x00,
+    .volatile_mask = NULL,
+};
+
 static int es8374_write_reg(audio_codec_es8374_t *codec, int reg, int value)
 {
     return codec->cfg.ctrl_if->write_addr(codec->cfg.ctrl_if, reg, 1, &value, 1);
@@ -63,10 +69,10 @@ static int es8374_read_reg(audio_codec_es8374_t *codec, int reg, int *value)
 
 void es8374_read_all(audio_codec_es8374_t *codec)
 {
-    for (int i = 0; i < 50; i++) {
-        int reg = 0;
-        es8374_read_reg(codec, i, &reg);
-        ESP_LOGI(TAG, "%x: %x", i, reg);
+    uint8_t regs[50] = {0};
+    audio_codec_read_regs(codec->cfg.ctrl_if, 0, regs, sizeof(regs));
+    for (int i = 0; i < sizeof(regs); i++) {
+        ESP_LOGI(TAG, "%x: %x", i, regs[i]);
     }
 }
 
@@ -413,32 +419,6 @@ static int es8374_config_fmt(audio_codec_es8374_t *codec, es_i2s_fmt_t fmt)
     return ret;
 }
 
-static int es8374_config_dac_output(audio_codec_es8374_t *codec, es_dac_output_t output)
-{
-    int ret = 0;
-    int reg = 0;
-    ret = es8374_write_reg(codec, 0x1d, 0x02);
-    ret |= es8374_read_reg(codec, 0x1c, &reg); // set spk mixer
-    reg |= 0x80;
-    ret |= es8374_write_reg(codec, 0x1c, reg);
-    ret |= es8374_write_reg(codec, 0x1D, 0x02); // spk set
-    ret |= es8374_write_reg(codec, 0x1F, 0x00); // spk set
-    ret |= es8374_write_reg(codec, 0x1E, 0xA0); // spk on
-    return ret;
-}
-
-static int es8374_config_adc_input(audio_codec_es8374_t *codec, es_adc_input_t input)
-{
-    int ret = 0;
-    int reg = 0;
-    ret |= es8374_read_reg(codec, 0x21, &reg);
-    if (ret == 0) {
-        reg = (reg & 0xcf) | 0x14;
-        ret |= es8374_write_reg(codec, 0x21, reg);
-    }
-    return ret;
-}
-
 static int es8374_set_adc_dac_volume(audio_codec_es8374_t *codec, codec_work_mode_t mode, float db_value)
 {
     int reg = audio_codec_calc_vol_db(&vol_range, db_value);
@@ -452,73 +432,99 @@ static int es8374_set_adc_dac_volume(audio_codec_es8374_t *codec, codec_work_mod
     return ret;
 }
 
-static int es8374_init_reg(audio_codec_es8374_t *codec, es_i2s_fmt_t fmt, es_i2s_clock_t cfg,
-                           es_dac_output_t out_channel, es_adc_input_t in_channel)
-{
-    int ret = 0;
-    int reg = 0;
+typedef enum {
+    ES8374_SEQ_COND_MASTER, /*!< Codec works as I2S master */
+    ES8374_SEQ_COND_ADC,    /*!< ADC is used */
+    ES8374_SEQ_COND_DAC,    /*!< DAC is used */
+} es8374_seq_cond_t;
+
+static const codec_reg_seq_t es8374_reset_seq[] = {
+    CODEC_REG_SEQ_WRITE(0x00, 0x3F), // IC Rst start
+    CODEC_REG_SEQ_WRITE(0x00, 0x03), // IC Rst stop
+    CODEC_REG_SEQ_WRITE(0x01, 0x7F), // IC clk on
+    CODEC_REG_SEQ_IF(ES8374_SEQ_COND_MASTER, 1),
+    CODEC_REG_SEQ_UPDATE(0x0F, 0x80, 0x80),
+    CODEC_REG_SEQ_IF_NOT(ES8374_SEQ_COND_MASTER, 1),
+    CODEC_REG_SEQ_UPDATE(0x0F, 0x80, 0x00), // CODEC IN I2S SLAVE MODE
+
+    CODEC_REG_SEQ_WRITE(0x6F, 0xA0), // pll set:mode enable
+    CODEC_REG_SEQ_WRITE(0x72, 0x41), // pll set:mode set
+    CODEC_REG_SEQ_WRITE(0x09, 0x01), // pll set:reset on ,set start
+    CODEC_REG_SEQ_WRITE(0x0C, 0x22), // pll set:k
+    CODEC_REG_SEQ_WRITE(0x0D, 0x2E), // pll set:k
+    CODEC_REG_SEQ_WRITE(0x0E, 0xC6), // pll set:k
+    CODEC_REG_SEQ_WRITE(0x0A, 0x3A), // pll set:
+    CODEC_REG_SEQ_WRITE(0x0B, 0x07), // pll set:n
+    CODEC_REG_SEQ_WRITE(0x09, 0x41), // pll set:reset off ,set stop
+};
 
-    ret |= es8374_write_reg(codec, 0x00, 0x3F); // IC Rst start
-    ret |= es8374_write_reg(codec, 0x00, 0x03); // IC Rst stop
-    ret |= es8374_write_reg(codec, 0x01, 0x7F); // IC clk on
-
-    ret |= es8374_read_reg(codec, 0x0F, &reg);
-    reg &= 0x7f;
-
-    reg |= (codec->cfg.master_mode << 7);
-    ret |= es8374_write_reg(codec, 0x0f, reg); // CODEC IN I2S SLAVE MODE
-
-    ret |= es8374_write_reg(codec, 0x6F, 0xA0); // pll set:mode enable
-    ret |= es8374_write_reg(codec, 0x72, 0x41); // pll set:mode set
-    ret |= es8374_write_reg(codec, 0x09, 0x01); // pll set:reset on ,set start
-    ret |= es8374_write_reg(codec, 0x0C, 0x22); // pll set:k
-    ret |= es8374_write_reg(codec, 0x0D, 0x2E); // pll set:k
-    ret |= es8374_write_reg(codec, 0x0E, 0xC6); // pll set:k
-    ret |= es8374_write_reg(codec, 0x0A, 0x3A); // pll set:
-    ret |= es8374_write_reg(codec, 0x0B, 0x07); // pll set:n
-    ret |= es8374_write_reg(codec, 0x09, 0x41); // pll set:reset off ,set stop
-
-    ret |= es8374_i2s_config_clock(codec, cfg);
-
-    ret |= es8374_write_reg(codec, 0x24, 0x08); // adc set
-    ret |= es8374_write_reg(codec, 0x36, 0x00); // dac set
-    ret |= es8374_write_reg(codec, 0x12, 0x30); // timming set
-    ret |= es8374_write_reg(codec, 0x13, 0x20); // timming set
-
-    ret |= es8374_config_fmt(codec, fmt);
-
-    ret |= es8374_write_reg(codec, 0x21, 0x50); // adc set: SEL LIN1 CH+PGAGAIN=0DB
-    ret |= es8374_write_reg(codec, 0x22, 0xFF); // adc set: PGA GAIN=0DB
-    ret |= es8374_write_reg(codec, 0x21, 0x14); // adc set: SEL LIN1 CH+PGAGAIN=18DB
-    ret |= es8374_write_reg(codec, 0x22, 0x55); // pga = +15db
-    ret |= es8374_write_reg(codec, 0x08,
-                            0x21); // set class d divider = 33, to avoid the high frequency tone on laudspeaker
-    ret |= es8374_write_reg(codec, 0x00, 0x80); // IC START
-
-    ret |= es8374_set_adc_dac_volume(codec, CODEC_WORK_MODE_ADC, 0.0); // 0db
-
-    ret |= es8374_write_reg(codec, 0x14, 0x8A); // IC START
-    ret |= es8374_write_reg(codec, 0x15, 0x40); // IC START
-    ret |= es8374_write_reg(codec, 0x1A, 0xA0); // monoout set
-    ret |= es8374_write_reg(codec, 0x1B, 0x19); // monoout set
-    ret |= es8374_write_reg(codec, 0x1C, 0x90); // spk set
-    ret |= es8374_write_reg(codec, 0x1D, 0x01); // spk set
-    ret |= es8374_write_reg(codec, 0x1F, 0x00); // spk set
-    ret |= es8374_write_reg(codec, 0x1E, 0x20); // spk on
-    ret |= es8374_write_reg(codec, 0x28, 0x00); // alc set
-    ret |= es8374_write_reg(codec, 0x25, 0x00); // ADCVOLUME on
-    ret |= es8374_write_reg(codec, 0x38, 0x00); // DACVOLUME on
-    ret |= es8374_write_reg(codec, 0x37, 0x30); // dac set
-    ret |= es8374_write_reg(codec, 0x6D, 0x60); // SEL:GPIO1=DMIC CLK OUT+SEL:GPIO2=PLL CLK OUT
-    ret |= es8374_write_reg(codec, 0x71, 0x05); // for automute setting
-    ret |= es8374_write_reg(codec, 0x73, 0x70);
-
-    ret |= es8374_config_dac_output(codec, out_channel); // 0x3c Enable DAC and Enable Lout/Rout/1/2
-    ret |= es8374_config_adc_input(
-        codec,
-        in_channel); // 0x00 LINSEL & RINSEL, LIN1/RIN1 as ADC Input; DSSEL,use one DS Reg11; DSR, LINPUT1-RINPUT1
-    ret |= es8374_set_adc_dac_volume(codec, CODEC_WORK_MODE_DAC, -96.0);
-    ret |= es8374_write_reg(codec, 0x37, 0x00); // dac set
+static const codec_reg_seq_t es8374_init_seq[] = {
+    CODEC_REG_SEQ_WRITE(0x24, 0x08), // adc set
+    CODEC_REG_SEQ_WRITE(0x36, 0x00), // dac set
+    CODEC_REG_SEQ_WRITE(0x12, 0x30), // timming set
+    CODEC_REG_SEQ_WRITE(0x13, 0x20), // timming set
+    // I2S normal format
+    CODEC_REG_SEQ_IF(ES8374_SEQ_COND_ADC, 1),
+    CODEC_REG_SEQ_UPDATE(0x10, 0x03, ES_I2S_NORMAL),
+    CODEC_REG_SEQ_IF(ES8374_SEQ_COND_DAC, 1),
+    CODEC_REG_SEQ_UPDATE(0x11, 0x03, ES_I2S_NORMAL),
+
+    CODEC_REG_SEQ_WRITE(0x21, 0x50), // adc set: SEL LIN1 CH+PGAGAIN=0DB
+    CODEC_REG_SEQ_WRITE(0x22, 0xFF), // adc set: PGA GAIN=0DB
+    CODEC_REG_SEQ_WRITE(0x21, 0x14), // adc set: SEL LIN1 CH+PGAGAIN=18DB
+    CODEC_REG_SEQ_WRITE(0x22, 0x55), // pga = +15db
+    CODEC_REG_SEQ_WRITE(0x08, 0x21), // set class d divider = 33, to avoid the high frequency tone on laudspeaker
+    CODEC_REG_SEQ_WRITE(0x00, 0x80), // IC START
+    CODEC_REG_SEQ_WRITE(0x25, 0x00), // ADC volume 0db
+
+    CODEC_REG_SEQ_WRITE(0x14, 0x8A), // IC START
+    CODEC_REG_SEQ_WRITE(0x15, 0x40), // IC START
+    CODEC_REG_SEQ_WRITE(0x1A, 0xA0), // monoout set
+    CODEC_REG_SEQ_WRITE(0x1B, 0x19), // monoout set
+    CODEC_REG_SEQ_WRITE(0x1C, 0x90), // spk set
+    CODEC_REG_SEQ_WRITE(0x1D, 0x01), // spk set
+    CODEC_REG_SEQ_WRITE(0x1F, 0x00), // spk set
+    CODEC_REG_SEQ_WRITE(0x1E, 0x20), // spk on
+    CODEC_REG_SEQ_WRITE(0x28, 0x00), // alc set
+    CODEC_REG_SEQ_WRITE(0x25, 0x00), // ADCVOLUME on
+    CODEC_REG_SEQ_WRITE(0x38, 0x00), // DACVOLUME on
+    CODEC_REG_SEQ_WRITE(0x37, 0x30), // dac set
+    CODEC_REG_SEQ_WRITE(0x6D, 0x60), // SEL:GPIO1=DMIC CLK OUT+SEL:GPIO2=PLL CLK OUT
+    CODEC_REG_SEQ_WRITE(0x71, 0x05), // for automute setting
+    CODEC_REG_SEQ_WRITE(0x73, 0x70),
+
+    // DAC output: enable DAC and Lout/Rout/1/2
+    CODEC_REG_SEQ_WRITE(0x1D, 0x02),
+    CODEC_REG_SEQ_UPDATE(0x1C, 0x80, 0x80), // set spk mixer
+    CODEC_REG_SEQ_WRITE(0x1D, 0x02),        // spk set
+    CODEC_REG_SEQ_WRITE(0x1F, 0x00),        // spk set
+    CODEC_REG_SEQ_WRITE(0x1E, 0xA0),        // spk on
+    // ADC input: LIN1/RIN1 as ADC Input; DSSEL,use one DS Reg11; DSR, LINPUT1-RINPUT1
+    CODEC_REG_SEQ_UPDATE(0x21, 0x34, 0x14),
+    CODEC_REG_SEQ_WRITE(0x38, 0x00), // DAC volume
+    CODEC_REG_SEQ_WRITE(0x37, 0x00), // dac set
+};
+
+static int es8374_init_reg(audio_codec_es8374_t *codec, es_i2s_clock_t cfg)
+{
+    uint32_t cond = 0;
+    if (codec->cfg.master_mode) {
+        cond |= BIT(ES8374_SEQ_COND_MASTER);
+    }
+    if (codec->cfg.codec_mode & CODEC_WORK_MODE_ADC) {
+        cond |= BIT(ES8374_SEQ_COND_ADC);
+    }
+    if (codec->cfg.codec_mode & CODEC_WORK_MODE_DAC) {
+        cond |= BIT(ES8374_SEQ_COND_DAC);
+    }
+    const audio_codec_ctrl_if_t *ctrl_if = codec->cfg.ctrl_if;
+    int ret = audio_codec_run_reg_seq(ctrl_if, es8374_reset_seq, CODEC_REG_SEQ_NUM(es8374_reset_seq), cond, NULL);
+    if (ret == CODEC_DEV_OK) {
+        ret = es8374_i2s_config_clock(codec, cfg);
+    }
+    if (ret == CODEC_DEV_OK) {
+        ret = audio_codec_run_reg_seq(ctrl_if, es8374_init_seq, CODEC_REG_SEQ_NUM(es8374_init_seq), cond, NULL);
+    }
     return ret;
 }
 
@@ -674,8 +680,7 @@ static int es8374_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
     clkdiv.lclk_div = LCLK_DIV_256;
     clkdiv.sclk_div = MCLK_DIV_4;
     ret |= es8374_stop(codec);
-    ret |= es8374_init_reg(codec, (BIT_LENGTH_16BITS << 4) | ES_I2S_NORMAL, clkdiv, DAC_OUTPUT_ALL,
-                           ADC_INPUT_LINPUT1_RINPUT1);
+    ret |= es8374_init_reg(codec, clkdiv);
     ret |= _set_mic_gain(codec, 15);
     ret |= es8374_set_d2se_pga(codec, D2SE_PGA_GAIN_EN);
     ret |= es8374_config_fmt(codec, ES_I2S_NORMAL);
@@ -709,11 +714,8 @@ int es8374_set_fs(const audio_codec_if_t *h, codec_sample_info_t *fs)
         return CODEC_DEV_INVALID_ARG;
     }
     int ret = 0;
-    es_i2s_fmt_t fmt = ES_I2S_NORMAL;
-    if (fs->channel == 1) {
-        fmt = ES_I2S_LEFT;
-    }
-    ret |= es8374_config_fmt(codec, fmt);
+    // I2S data interface runs in standard I2S format for mono as well
+    ret |= es8374_config_fmt(codec, ES_I2S_NORMAL);
     ret |= es8374_set_bits_per_sample(codec, fs->bits_per_sample);
     return CODEC_DEV_OK;
 }
@@ -38,6 +38,12 @@
 
 #define TAG "ES8388"
 
+/* DACCONTROL3 bits, soft ramp fades DAC digital volume and mute by 0.5dB per 4 LRCK */
+#define ES8388_DAC_SOFT_RAMP (0x20)
+#define ES8388_DAC_MUTE      (0x04)
+/* LOUT1 and ROUT1 volume of 0dB, output level is controlled by DAC digital volume */
+#define ES8388_OUT_VOL_0DB (0x1E)
+
 typedef struct {
     audio_codec_if_t             base;
     const audio_codec_ctrl_if_t *ctrl_if;
@@ -57,6 +63,12 @@ static const codec_dev_vol_range_t vol_range = {
     },
 };
 
+const codec_reg_cache_desc_t es8388_reg_cache_desc = {
+    .reg_num = 0x35,
+    .reset_reg = ES8388_CONTROL1,
+    .volatile_mask = NULL,
+};
+
 static int es8388_write_reg(audio_codec_es8388_t *codec, int reg, int value)
 {
     return codec->ctrl_if->write_addr(codec->ctrl_if, reg, 1, &value, 1);
@@ -70,36 +82,13 @@ static int es8388_read_reg(audio_codec_es8388_t *codec, int reg, int *value)
 
 void es8388_read_all(audio_codec_es8388_t *codec)
 {
-    for (uint8_t i = 0; i < 50; i++) {
-        int reg = 0;
-        es8388_read_reg(codec, i, &reg);
-        ets_printf("%x: %x\n", i, reg);
+    uint8_t regs[50] = {0};
+    audio_codec_read_regs(codec->ctrl_if, 0, regs, sizeof(regs));
+    for (uint8_t i = 0; i < sizeof(regs); i++) {
+        ets_printf("%x: %x\n", i, regs[i]);
     }
 }
 
-static int es8388_set_adc_dac_volume(audio_codec_es8388_t *codec, codec_work_mode_t mode, int volume, int dot)
-{
-    int res = 0;
-    if (volume < -96 || volume > 0) {
-        ESP_LOGW(TAG, "Warning: volume < -96! or > 0!\n");
-        if (volume < -96)
-            volume = -96;
-        else
-            volume = 0;
-    }
-    dot = (dot >= 5 ? 1 : 0);
-    volume = (-volume << 1) + dot;
-    if (mode & CODEC_WORK_MODE_ADC) {
-        res |= es8388_write_reg(codec, ES8388_ADCCONTROL8, volume);
-        res |= es8388_write_reg(codec, ES8388_ADCCONTROL9, volume); // ADC Right Volume=0db
-    }
-    if (mode & CODEC_WORK_MODE_DAC) {
-        res |= es8388_write_reg(codec, ES8388_DACCONTROL5, volume);
-        res |= es8388_write_reg(codec, ES8388_DACCONTROL4, volume);
-    }
-    return res;
-}
-
 /**
  * @brief Configure ES8388 DAC mute or not. Basically you can use this function to mute the output or unmute
  *
@@ -250,22 +239,19 @@ static int es8388_config_fmt(audio_codec_es8388_t *codec, codec_work_mode_t mode
 }
 
 /**
- *
+ * @brief Get DAC digital volume set by `set_vol`
  * @return
- *           volume
+ *           volume in decibel
  */
-int es8388_get_voice_volume(audio_codec_es8388_t *codec, int *volume)
+int es8388_get_voice_volume(audio_codec_es8388_t *codec, float *volume)
 {
     int res = 0;
     int reg = 0;
-    res = es8388_read_reg(codec, ES8388_DACCONTROL24, &reg);
+    res = es8388_read_reg(codec, ES8388_DACCONTROL4, &reg);
     if (res != 0) {
         *volume = 0;
     } else {
-        *volume = reg;
-        *volume *= 3;
-        if (*volume == 99)
-            *volume = 100;
+        *volume = audio_codec_calc_vol_db(&vol_range, reg);
     }
     return res;
 }
@@ -390,80 +376,74 @@ static void es8388_pa_power(audio_codec_es8388_t *codec, bool enable)
     ESP_LOGI(TAG, "PA gpio %d enable %d", pa_pin, enable);
 }
 
-static int es8388_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
-{
-    audio_codec_es8388_t *codec = (audio_codec_es8388_t *) h;
-    es8388_codec_cfg_t *codec_cfg = (es8388_codec_cfg_t *) cfg;
-    if (codec == NULL || codec_cfg->ctrl_if == NULL || cfg_size != sizeof(es8388_codec_cfg_t)) {
-        return CODEC_DEV_INVALID_ARG;
-    }
-    int res = CODEC_DEV_OK;
-    codec->ctrl_if = codec_cfg->ctrl_if;
-    codec->pa_pin = codec_cfg->pa_pin;
-    codec->codec_mode = codec_cfg->codec_mode;
+typedef enum {
+    ES8388_SEQ_COND_MASTER, /*!< Codec works as I2S master */
+} es8388_seq_cond_t;
 
-    // 0x04 mute/0x00 unmute&ramp;DAC unmute and  disabled digital volume control soft ramp
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL3, 0x04);
+static const codec_reg_seq_t es8388_open_seq[] = {
+    // DAC mute with digital volume control soft ramp enabled
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL3, ES8388_DAC_SOFT_RAMP | ES8388_DAC_MUTE),
     /* Chip Control and Power Management */
-    res |= es8388_write_reg(codec, ES8388_CONTROL2, 0x50);
-    res |= es8388_write_reg(codec, ES8388_CHIPPOWER, 0x00); // normal all and power up all
+    CODEC_REG_SEQ_WRITE(ES8388_CONTROL2, 0x50),
+    CODEC_REG_SEQ_WRITE(ES8388_CHIPPOWER, 0x00), // normal all and power up all
 
     // Disable the internal DLL to improve 8K sample rate
-    res |= es8388_write_reg(codec, 0x35, 0xA0);
-    res |= es8388_write_reg(codec, 0x37, 0xD0);
-    res |= es8388_write_reg(codec, 0x39, 0xD0);
+    CODEC_REG_SEQ_WRITE(0x35, 0xA0),
+    CODEC_REG_SEQ_WRITE(0x37, 0xD0),
+    CODEC_REG_SEQ_WRITE(0x39, 0xD0),
 
-    res |= es8388_write_reg(codec, ES8388_MASTERMODE, codec_cfg->master_mode); // CODEC IN I2S SLAVE MODE
+    CODEC_REG_SEQ_IF(ES8388_SEQ_COND_MASTER, 1),
+    CODEC_REG_SEQ_WRITE(ES8388_MASTERMODE, 0x01),
+    CODEC_REG_SEQ_IF_NOT(ES8388_SEQ_COND_MASTER, 1),
+    CODEC_REG_SEQ_WRITE(ES8388_MASTERMODE, 0x00), // CODEC IN I2S SLAVE MODE
 
     /* dac */
-    res |= es8388_write_reg(codec, ES8388_DACPOWER, 0xC0); // disable DAC and disable Lout/Rout/1/2
-    res |= es8388_write_reg(codec, ES8388_CONTROL1, 0x12); // Enfr=0,Play&Record Mode,(0x17-both of mic&paly)
-    //    res |= es8388_write_reg(codec, ES8388_CONTROL2, 0);  //LPVrefBuf=0,Pdn_ana=0
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL1, 0x18);  // 1a 0x18:16bit iis , 0x00:24
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL2, 0x02);  // DACFsMode,SINGLE SPEED; DACFsRatio,256
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL16, 0x00); // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL17, 0x90); // only left DAC to left mixer enable 0db
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL20, 0x90); // only right DAC to right mixer enable 0db
+    CODEC_REG_SEQ_WRITE(ES8388_DACPOWER, 0xC0),     // disable DAC and disable Lout/Rout/1/2
+    CODEC_REG_SEQ_WRITE(ES8388_CONTROL1, 0x12),     // Enfr=0,Play&Record Mode,(0x17-both of mic&paly)
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL1, 0x18),  // 1a 0x18:16bit iis , 0x00:24
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL2, 0x02),  // DACFsMode,SINGLE SPEED; DACFsRatio,256
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL16, 0x00), // 0x00 audio on LIN1&RIN1,  0x09 LIN2&RIN2
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL17, 0x90), // only left DAC to left mixer enable 0db
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL20, 0x90), // only right DAC to right mixer enable 0db
     // set internal ADC and DAC use the same LRCK clock, ADC LRCK as internal LRCK
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL21, 0x80);
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL23, 0x00);    // vroi=0
-    res |= es8388_set_adc_dac_volume(codec, ES_MODULE_DAC, 0, 0); // 0db
-    // TODO default use DAC_ALL
-#if 0
-    if (AUDIO_HAL_DAC_OUTPUT_LINE2 == dac_output) {
-        tmp = DAC_OUTPUT_LOUT1 | DAC_OUTPUT_ROUT1;
-    } else if (AUDIO_HAL_DAC_OUTPUT_LINE1 == dac_output) {
-        tmp = DAC_OUTPUT_LOUT2 | DAC_OUTPUT_ROUT2;
-    } else {
-        tmp = DAC_OUTPUT_LOUT1 | DAC_OUTPUT_LOUT2 | DAC_OUTPUT_ROUT1 | DAC_OUTPUT_ROUT2;
-    }
-#endif
-    int tmp = DAC_OUTPUT_LOUT1 | DAC_OUTPUT_LOUT2 | DAC_OUTPUT_ROUT1 | DAC_OUTPUT_ROUT2;
-    res |= es8388_write_reg(codec, ES8388_DACPOWER, tmp); // 0x3c Enable DAC and Enable Lout/Rout/1/2
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL21, 0x80),
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL23, 0x00), // vroi=0
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL5, 0x00),  // 0db
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL4, 0x00),
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL24, ES8388_OUT_VOL_0DB),
+    CODEC_REG_SEQ_WRITE(ES8388_DACCONTROL25, ES8388_OUT_VOL_0DB),
+    // TODO default use DAC_ALL, 0x3c Enable DAC and Enable Lout/Rout/1/2
+    CODEC_REG_SEQ_WRITE(ES8388_DACPOWER, DAC_OUTPUT_LOUT1 | DAC_OUTPUT_LOUT2 | DAC_OUTPUT_ROUT1 | DAC_OUTPUT_ROUT2),
     /* adc */
-    res |= es8388_write_reg(codec, ES8388_ADCPOWER, 0xFF);
-    res |= es8388_write_reg(codec, ES8388_ADCCONTROL1, 0xbb); // MIC Left and Right channel PGA gain
-    tmp = 0;
+    CODEC_REG_SEQ_WRITE(ES8388_ADCPOWER, 0xFF),
+    CODEC_REG_SEQ_WRITE(ES8388_ADCCONTROL1, 0xbb), // MIC Left and Right channel PGA gain
     // TODO default use ADC LINE1
-#if 0
-    es_adc_input_t adc_input = AUDIO_HAL_ADC_INPUT_LINE1;
-    if (AUDIO_HAL_ADC_INPUT_LINE1 == adc_input) {
-        tmp = ADC_INPUT_LINPUT1_RINPUT1;
-    } else if (AUDIO_HAL_ADC_INPUT_LINE2 == adc_input) {
-        tmp = ADC_INPUT_LINPUT2_RINPUT2;
-    } else {
-        tmp = ADC_INPUT_DIFFERENCE;
-    }
-#endif
     // 0x00 LINSEL & RINSEL, LIN1/RIN1 as ADC Input; DSSEL,use one DS Reg11; DSR, LINPUT1-RINPUT1
-    res |= es8388_write_reg(codec, ES8388_ADCCONTROL2, ADC_INPUT_LINPUT1_RINPUT1);
-    res |= es8388_write_reg(codec, ES8388_ADCCONTROL3, 0x02);
-    res |= es8388_write_reg(codec, ES8388_ADCCONTROL4, 0x0c); // 16 Bits length and I2S serial audio data format
-    res |= es8388_write_reg(codec, ES8388_ADCCONTROL5, 0x02); // ADCFsMode,singel SPEED,RATIO=256
+    CODEC_REG_SEQ_WRITE(ES8388_ADCCONTROL2, ADC_INPUT_LINPUT1_RINPUT1),
+    CODEC_REG_SEQ_WRITE(ES8388_ADCCONTROL3, 0x02),
+    CODEC_REG_SEQ_WRITE(ES8388_ADCCONTROL4, 0x0c), // 16 Bits length and I2S serial audio data format
+    CODEC_REG_SEQ_WRITE(ES8388_ADCCONTROL5, 0x02), // ADCFsMode,singel SPEED,RATIO=256
     // ALC for Microphone
-    res |= es8388_set_adc_dac_volume(codec, CODEC_WORK_MODE_ADC, 0, 0); // 0db
-    res |= es8388_write_reg(codec, ES8388_ADCPOWER,
-                            0x09); // Power on ADC, Enable LIN&RIN, Power off MICBIAS, set int1lp to low power mode
+    CODEC_REG_SEQ_WRITE(ES8388_ADCCONTROL8, 0x00), // 0db
+    CODEC_REG_SEQ_WRITE(ES8388_ADCCONTROL9, 0x00), // ADC Right Volume=0db
+    // Power on ADC, Enable LIN&RIN, Power off MICBIAS, set int1lp to low power mode
+    CODEC_REG_SEQ_WRITE(ES8388_ADCPOWER, 0x09),
+};
+
+static int es8388_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
+{
+    audio_codec_es8388_t *codec = (audio_codec_es8388_t *) h;
+    es8388_codec_cfg_t *codec_cfg = (es8388_codec_cfg_t *) cfg;
+    if (codec == NULL || codec_cfg->ctrl_if == NULL || cfg_size != sizeof(es8388_codec_cfg_t)) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    int res = CODEC_DEV_OK;
+    codec->ctrl_if = codec_cfg->ctrl_if;
+    codec->pa_pin = codec_cfg->pa_pin;
+    codec->codec_mode = codec_cfg->codec_mode;
+
+    uint32_t cond = codec_cfg->master_mode ? BIT(ES8388_SEQ_COND_MASTER) : 0;
+    res = audio_codec_run_reg_seq(codec->ctrl_if, es8388_open_seq, CODEC_REG_SEQ_NUM(es8388_open_seq), cond, NULL);
     if (res != 0) {
         ESP_LOGI(TAG, "Fail to write register");
         return CODEC_DEV_WRITE_FAIL;
@@ -518,13 +498,22 @@ static int es8388_set_vol(const audio_codec_if_t *h, float db_value)
     }
     int volume = audio_codec_calc_vol_reg(&vol_range, db_value);
     ESP_LOGI(TAG, "SET: volume:%x db:%f", volume, db_value);
-    int res = es8388_write_reg(codec, ES8388_DACCONTROL24, volume);
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL25, volume);
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL26, 0);
-    res |= es8388_write_reg(codec, ES8388_DACCONTROL27, 0);
+    // Use DAC digital volume which matches `vol_range` and is ramped by hardware
+    int res = es8388_write_reg(codec, ES8388_DACCONTROL4, volume);
+    res |= es8388_write_reg(codec, ES8388_DACCONTROL5, volume);
     return res ? CODEC_DEV_WRITE_FAIL : CODEC_DEV_OK;
 }
 
+static int es8388_get_caps(const audio_codec_if_t *h, uint32_t *caps)
+{
+    audio_codec_es8388_t *codec = (audio_codec_es8388_t *) h;
+    if (codec == NULL || caps == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    *caps = CODEC_IF_CAP_VOL_RAMP;
+    return CODEC_DEV_OK;
+}
+
 static int es8388_set_fs(const audio_codec_if_t *h, codec_sample_info_t *fs)
 {
     audio_codec_es8388_t *codec = (audio_codec_es8388_t *) h;
@@ -535,12 +524,8 @@ static int es8388_set_fs(const audio_codec_if_t *h, codec_sample_info_t *fs)
         return CODEC_DEV_WRONG_STATE;
     }
     int res = 0;
-    // TODO force to use normal i2s mode
-    es_i2s_fmt_t fmt = ES_I2S_NORMAL;
-    if (fs->channel == 1) {
-        fmt = ES_I2S_LEFT;
-    }
-    res |= es8388_config_fmt(codec, CODEC_WORK_MODE_BOTH, fmt);
+    // I2S data interface runs in standard I2S format for mono as well
+    res |= es8388_config_fmt(codec, CODEC_WORK_MODE_BOTH, ES_I2S_NORMAL);
     res |= es8388_set_bits_per_sample(codec, CODEC_WORK_MODE_BOTH, fs->bits_per_sample);
     return res;
 }
@@ -594,6 +579,7 @@ const audio_codec_if_t *es8388_codec_new(es8388_codec_cfg_t *codec_cfg)
     codec->base.mute = es8388_mute;
     codec->base.set_mic_gain = es8388_set_gain;
     codec->base.close = es8388_close;
+    codec->base.get_caps = es8388_get_caps;
     do {
         int ret = codec->base.open(&codec->base, codec_cfg, sizeof(es8388_codec_cfg_t));
         if (ret != 0) {
@@ -47,6 +47,12 @@ typedef struct {
     uint8_t                      mic_selected; /*!< Selected microphone */
 } es7210_codec_cfg_t;
 
+/**
+ * @brief ES7210 register cache description
+ *        Use it to create cache control interface by `audio_codec_new_cache_ctrl_if`
+ */
+extern const codec_reg_cache_desc_t es7210_reg_cache_desc;
+
 /**
  * @brief         New ES7210 codec interface
  * @param         codec_cfg: ES7210 codec configuration
@@ -41,6 +41,12 @@ typedef struct {
     const audio_codec_ctrl_if_t *ctrl_if;  /*!< Codec Control interface */
 } es7243e_codec_cfg_t;
 
+/**
+ * @brief ES7243E register cache description
+ *        Use it to create cache control interface by `audio_codec_new_cache_ctrl_if`
+ */
+extern const codec_reg_cache_desc_t es7243e_reg_cache_desc;
+
 /**
  * @brief         New ES7243E codec interface
  * @param         codec_cfg: ES7243E codec configuration
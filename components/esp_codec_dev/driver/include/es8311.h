@@ -41,12 +41,18 @@ typedef struct {
     codec_work_mode_t            codec_mode;  /*!< Codec work mode: ADC or DAC */
     int16_t                      pa_pin;      /*!< PA chip power pin */
     bool                         master_mode; /*!< Whether codec works as I2S master or not */
-    bool                         use_mclk;    /*!< Whether use MCLK clock */
+    bool                         use_mclk;    /*!< Whether use MCLK clock, required in master mode */
     bool                         digital_mic; /*!< Whether use digital microphone */
     bool                         invert_mclk; /*!< MCLK clock signal inverted or not */
     bool                         invert_sclk; /*!< SCLK clock signal inverted or not */
 } es8311_codec_cfg_t;
 
+/**
+ * @brief ES8311 register cache description
+ *        Use it to create cache control interface by `audio_codec_new_cache_ctrl_if`
+ */
+extern const codec_reg_cache_desc_t es8311_reg_cache_desc;
+
 /**
  * @brief         New ES8311 codec interface
  * @param         codec_cfg: ES8311 codec configuration
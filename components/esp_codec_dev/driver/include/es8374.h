@@ -45,6 +45,12 @@ typedef struct {
     int16_t                      pa_pin;      /*!< PA chip power pin */
 } es8374_codec_cfg_t;
 
+/**
+ * @brief ES8374 register cache description
+ *        Use it to create cache control interface by `audio_codec_new_cache_ctrl_if`
+ */
+extern const codec_reg_cache_desc_t es8374_reg_cache_desc;
+
 /**
  * @brief         New ES8374 codec interface
  * @param         codec_cfg: ES8374 codec configuration
@@ -47,6 +47,12 @@ typedef struct {
     int16_t                      pa_pin;      /*!< PA chip power pin */
 } es8388_codec_cfg_t;
 
+/**
+ * @brief ES8388 register cache description
+ *        Use it to create cache control interface by `audio_codec_new_cache_ctrl_if`
+ */
+extern const codec_reg_cache_desc_t es8388_reg_cache_desc;
+
 /**
  * @brief         New ES8388 codec interface
  * @param         codec_cfg: ES8388 codec configuration
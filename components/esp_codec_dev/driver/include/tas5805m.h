@@ -34,6 +34,16 @@
 extern "C" {
 #endif
 
+/**
+ * @brief TAS5805M power state (CTRL_STATE of register 0x03)
+ */
+typedef enum {
+    TAS5805M_POWER_DEEP_SLEEP = 0, /*!< Lowest power, only I2C works, registers retained */
+    TAS5805M_POWER_SLEEP = 1,      /*!< DSP and PLL stopped, output stage off */
+    TAS5805M_POWER_HIZ = 2,        /*!< DSP running, output stage in Hi-Z */
+    TAS5805M_POWER_PLAY = 3,       /*!< Output stage switching */
+} tas5805m_power_state_t;
+
 /**
  * @brief TAS5805M codec configuration
  */
@@ -42,8 +52,51 @@ typedef struct {
     codec_work_mode_t            codec_mode;  /*!< Codec work mode: ADC or DAC */
     bool                         master_mode; /*!< Whether codec works as I2S master or not */
     int16_t                      reset_pin;   /*!< Reset pin */
+    tas5805m_power_state_t       idle_state;  /*!< Power state when codec disabled or closed (default deep sleep) */
 } tas5805m_codec_cfg_t;
 
+#define TAS5805M_BIQUAD_PER_CHANNEL (15) /*!< Number of EQ biquads of each channel */
+
+/**
+ * @brief Convert float to DSP coefficient of Q5.27 format (used by biquads)
+ */
+#define TAS5805M_Q5_27(v)           ((int32_t) ((v) * (float) (1 << 27)))
+
+/**
+ * @brief Convert float to DSP coefficient of Q9.23 format (used by mixer gains)
+ */
+#define TAS5805M_Q9_23(v)           ((int32_t) ((v) * (float) (1 << 23)))
+
+/**
+ * @brief TAS5805M DSP channel
+ */
+typedef enum {
+    TAS5805M_CHANNEL_LEFT,  /*!< Left channel */
+    TAS5805M_CHANNEL_RIGHT, /*!< Right channel */
+} tas5805m_channel_t;
+
+/**
+ * @brief TAS5805M biquad coefficients in Q5.27 format
+ *        Order and sign follow TI PPC3 output, a1 and a2 are already negated
+ */
+typedef struct {
+    int32_t b0; /*!< Coefficient b0 */
+    int32_t b1; /*!< Coefficient b1 */
+    int32_t b2; /*!< Coefficient b2 */
+    int32_t a1; /*!< Coefficient a1 (negated) */
+    int32_t a2; /*!< Coefficient a2 (negated) */
+} tas5805m_biquad_t;
+
+/**
+ * @brief TAS5805M input mixer gains in Q9.23 format
+ */
+typedef struct {
+    int32_t left_to_left;   /*!< Gain of left input into left channel */
+    int32_t right_to_left;  /*!< Gain of right input into left channel */
+    int32_t left_to_right;  /*!< Gain of left input into right channel */
+    int32_t right_to_right; /*!< Gain of right input into right channel */
+} tas5805m_mixer_t;
+
 /**
  * @brief         New TAS5805M codec interface
  * @param         codec_cfg: TAS5805M codec configuration
@@ -52,6 +105,42 @@ typedef struct {
  */
 const audio_codec_if_t *tas5805m_codec_new(tas5805m_codec_cfg_t *codec_cfg);
 
+/**
+ * @brief         Load biquad chain of one channel into TAS5805M DSP
+ *                Coefficients are sent by burst writes across DSP pages
+ * @param         h: TAS5805M codec interface
+ * @param         channel: DSP channel
+ * @param         start: Index of the first biquad to load (0 ~ TAS5805M_BIQUAD_PER_CHANNEL - 1)
+ * @param         biquad: Biquad coefficients to load
+ * @param         num: Number of biquads
+ * @return        CODEC_DEV_OK: Load success
+ *                CODEC_DEV_INVALID_ARG: Invalid argument
+ *                CODEC_DEV_WRONG_STATE: Codec not open yet
+ *                CODEC_DEV_WRITE_FAIL: Fail to write to device
+ */
+int tas5805m_set_biquads(const audio_codec_if_t *h, tas5805m_channel_t channel, int start,
+                         const tas5805m_biquad_t *biquad, int num);
+
+/**
+ * @brief         Load input mixer gains into TAS5805M DSP
+ * @param         h: TAS5805M codec interface
+ * @param         mixer: Mixer gains
+ * @return        CODEC_DEV_OK: Load success
+ *                CODEC_DEV_INVALID_ARG: Invalid argument
+ *                CODEC_DEV_WRONG_STATE: Codec not open yet
+ *                CODEC_DEV_WRITE_FAIL: Fail to write to device
+ */
+int tas5805m_set_mixer(const audio_codec_if_t *h, const tas5805m_mixer_t *mixer);
+
+/**
+ * @brief         Get TAS5805M latency of last transition from Hi-Z to play
+ * @param         h: TAS5805M codec interface
+ * @param         latency_us: Time in microseconds until device reports play state
+ * @return        CODEC_DEV_OK: Get success
+ *                CODEC_DEV_INVALID_ARG: Invalid argument
+ */
+int tas5805m_get_play_latency(const audio_codec_if_t *h, uint32_t *latency_us);
+
 #ifdef __cplusplus
 }
 #endif
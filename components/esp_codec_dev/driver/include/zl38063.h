@@ -43,8 +43,23 @@ typedef struct {
     codec_work_mode_t            codec_mode; /*!< Codec work mode: ADC or DAC */
     int16_t                      pa_pin;     /*!< PA chip power pin */
     int16_t                      reset_pin;  /*!< Reset pin */
+    int16_t                      irq_pin;    /*!< Interrupt pin, used to wake command completion wait early
+                                                  Set to -1 if not connected */
+    bool                         flash_boot; /*!< Managed flash boot: start firmware and config saved in ZL38063 flash,
+                                                  reload and save them only when flash image not match built-in one */
 } zl38063_codec_cfg_t;
 
+/**
+ * @brief ZL38063 host command latency statistics
+ */
+typedef struct {
+    uint32_t cmd_count;     /*!< Number of host commands issued */
+    uint32_t timeout_count; /*!< Number of commands not completed in time */
+    uint32_t poll_count;    /*!< Number of status register reads while waiting */
+    uint32_t max_wait_us;   /*!< Maximum command latency (unit us) */
+    uint64_t total_wait_us; /*!< Sum of command latency (unit us) */
+} zl38063_cmd_stats_t;
+
 /**
  * @brief         New ZL38063 codec interface
  * @param         codec_cfg: ZL38063 codec configuration
@@ -53,6 +68,16 @@ typedef struct {
  */
 const audio_codec_if_t *zl38063_codec_new(zl38063_codec_cfg_t *codec_cfg);
 
+/**
+ * @brief         Get ZL38063 host command latency statistics
+ * @param         h: ZL38063 codec interface
+ * @param         stats: Statistics to store
+ * @param         reset: Whether clear statistics after read
+ * @return        CODEC_DEV_OK: Get success
+ *                CODEC_DEV_INVALID_ARG: Invalid argument
+ */
+int zl38063_get_cmd_stats(const audio_codec_if_t *h, zl38063_cmd_stats_t *stats, bool reset);
+
 #ifdef __cplusplus
 }
 #endif
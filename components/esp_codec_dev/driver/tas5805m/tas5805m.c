@@ -25,7 +25,7 @@
 #include "esp_log.h"
 #include "tas5805m.h"
 #include "tas5805m_reg.h"
-#include "tas5805m_reg_cfg.h"
+#include "tas5805m_reg_program.h"
 #include "codec_dev_defaults.h"
 #include "codec_dev_err.h"
 #include "codec_dev_gpio.h"
@@ -34,10 +34,37 @@
 
 #define TAG "TAS5805M"
 
+#define TAS5805M_SIG_BLOCK_LEN    (8)
+#define TAS5805M_STATE_POLL_US    (200)
+#define TAS5805M_STATE_POLL_NUM   (250)
+
+typedef struct {
+    uint8_t book;
+    uint8_t page;
+    uint8_t reg;
+} tas5805m_sig_block_t;
+
+typedef struct {
+    uint8_t dev_state;
+    uint8_t coef[2][TAS5805M_SIG_BLOCK_LEN];
+} tas5805m_signature_t;
+
+/* DSP coefficient registers sampled to verify that register program is still loaded
+ * Biquads and mixer are left out since they can be tuned at runtime
+ */
+static const tas5805m_sig_block_t tas5805m_sig_blocks[] = {
+    {TAS5805M_BOOK_8C, TAS5805M_PAGE_2B, 0x34           },
+    {TAS5805M_BOOK_8C, TAS5805M_PAGE_2A, TAS5805M_REG_24},
+};
+
 typedef struct {
-    audio_codec_if_t     base;
-    tas5805m_codec_cfg_t cfg;
-    bool                 is_open;
+    audio_codec_if_t       base;
+    tas5805m_codec_cfg_t   cfg;
+    bool                   is_open;
+    bool                   muted;
+    tas5805m_power_state_t state;
+    int                    fade_ms;
+    uint32_t               play_latency_us;
 } audio_codec_tas5805m_t;
 
 static const codec_dev_vol_range_t vol_range = {
@@ -71,7 +98,7 @@ static int tas5805m_transmit_registers(audio_codec_tas5805m_t *codec, const tas5
 {
     int i = 0;
     int ret = 0;
-    while (i < size) {
+    while (i < size && ret == CODEC_DEV_OK) {
         switch (conf_buf[i].offset) {
             case CFG_META_SWITCH:
                 // Used in legacy applications.  Ignored here.
@@ -104,6 +131,7 @@ static int tas5805m_transmit_registers(audio_codec_tas5805m_t *codec, const tas5
 
 static int tas5805m_set_mute_fade(audio_codec_tas5805m_t *codec, int value)
 {
+    static const int fade_ms[] = {12, 53, 107, 267, 535, 1065, 2665, 5330};
     int ret = 0;
     uint8_t fade_reg = 0;
     /* Time for register value
@@ -133,12 +161,183 @@ static int tas5805m_set_mute_fade(audio_codec_tas5805m_t *codec, int value)
     } else {
         fade_reg = 7;
     }
+    codec->fade_ms = fade_ms[fade_reg];
     fade_reg |= (fade_reg << 4);
     ret |= tas5805m_write_reg(codec, MUTE_TIME_REG_ADDR, fade_reg);
     ESP_LOGI(TAG, "Set mute fade, value:%d, 0x%x", value, fade_reg);
     return ret == 0 ? CODEC_DEV_OK : CODEC_DEV_WRITE_FAIL;
 }
 
+static int tas5805m_set_vol_ramp(audio_codec_tas5805m_t *codec)
+{
+    // Digital volume changes step towards target in hardware instead of jumping
+    int ret = tas5805m_write_reg(codec, DIG_VOL_CTRL_REG_ADDR, TAS5805M_DIG_VOL_RAMP);
+    return ret == 0 ? CODEC_DEV_OK : CODEC_DEV_WRITE_FAIL;
+}
+
+static int tas5805m_select_book_page(audio_codec_tas5805m_t *codec, uint8_t book, uint8_t page)
+{
+    int ret = tas5805m_write_reg(codec, TAS5805M_REG_00, TAS5805M_PAGE_00);
+    ret |= tas5805m_write_reg(codec, TAS5805M_REG_7F, book);
+    ret |= tas5805m_write_reg(codec, TAS5805M_REG_00, page);
+    return ret;
+}
+
+/* Get the signature which register program leaves in device */
+static void tas5805m_get_program_signature(tas5805m_signature_t *sig)
+{
+    const tas5805m_cfg_reg_t *conf_buf = tas5805m_reg_program;
+    int size = sizeof(tas5805m_reg_program) / sizeof(tas5805m_reg_program[0]);
+    uint8_t book = 0, page = 0;
+    memset(sig, 0, sizeof(tas5805m_signature_t));
+    for (int i = 0; i < size; i++) {
+        int reg = conf_buf[i].offset;
+        const uint8_t *data = &conf_buf[i].value;
+        int len = 1;
+        if (reg == CFG_META_DELAY || reg == CFG_META_SWITCH) {
+            continue;
+        }
+        if (reg == CFG_META_BURST) {
+            len = conf_buf[i].value;
+            reg = conf_buf[i + 1].offset;
+            data = &conf_buf[i + 1].value;
+            i += (len / 2) + 1;
+        }
+        for (int k = 0; k < len; k++, reg++) {
+            if (reg == TAS5805M_REG_00) {
+                page = data[k];
+            } else if (reg == TAS5805M_REG_7F && page == TAS5805M_PAGE_00) {
+                book = data[k];
+            } else if (book == TAS5805M_BOOK_00 && page == TAS5805M_PAGE_00 && reg == TAS5805M_REG_03) {
+                sig->dev_state = data[k];
+            } else {
+                for (int j = 0; j < sizeof(tas5805m_sig_blocks) / sizeof(tas5805m_sig_blocks[0]); j++) {
+                    const tas5805m_sig_block_t *blk = &tas5805m_sig_blocks[j];
+                    if (blk->book == book && blk->page == page && reg >= blk->reg &&
+                        reg < blk->reg + TAS5805M_SIG_BLOCK_LEN) {
+                        sig->coef[j][reg - blk->reg] = data[k];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Read the signature from device, leave book 0 page 0 selected
+ * Bus is held so that other control access can not land on coefficient book
+ */
+static int tas5805m_read_signature(audio_codec_tas5805m_t *codec, tas5805m_signature_t *sig)
+{
+    int ret = audio_codec_ctrl_acquire(codec->cfg.ctrl_if, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    for (int j = 0; j < sizeof(tas5805m_sig_blocks) / sizeof(tas5805m_sig_blocks[0]) && ret == 0; j++) {
+        const tas5805m_sig_block_t *blk = &tas5805m_sig_blocks[j];
+        ret = tas5805m_select_book_page(codec, blk->book, blk->page);
+        if (ret == 0) {
+            ret = codec->cfg.ctrl_if->read_addr(codec->cfg.ctrl_if, blk->reg, 1, sig->coef[j], TAS5805M_SIG_BLOCK_LEN);
+        }
+    }
+    ret |= tas5805m_select_book_page(codec, TAS5805M_BOOK_00, TAS5805M_PAGE_00);
+    if (ret == 0) {
+        int value = 0;
+        ret = tas5805m_read_reg(codec, TAS5805M_REG_03, &value);
+        sig->dev_state = (uint8_t) value;
+    }
+    audio_codec_ctrl_acquire(codec->cfg.ctrl_if, false);
+    return ret;
+}
+
+/* Check whether device still holds the register program so that reset and reload can be skipped */
+static bool tas5805m_is_configured(audio_codec_tas5805m_t *codec)
+{
+    tas5805m_signature_t expect, actual;
+    const audio_codec_gpio_if_t *gpio_if = audio_codec_get_gpio_if();
+    if (codec->cfg.reset_pin > 0 && gpio_if) {
+        // Keep amplifier out of reset without toggling
+        gpio_if->setup(codec->cfg.reset_pin, AUDIO_GPIO_DIR_OUT, AUDIO_GPIO_MODE_FLOAT);
+        gpio_if->set(codec->cfg.reset_pin, 1);
+    }
+    if (tas5805m_read_signature(codec, &actual) != 0) {
+        return false;
+    }
+    tas5805m_get_program_signature(&expect);
+    codec->state = (tas5805m_power_state_t) (actual.dev_state & TAS5805M_CTRL_STATE_MASK);
+    // Mute and power state are changed after program loaded
+    actual.dev_state &= ~(TAS5805M_CTRL_MUTE | TAS5805M_CTRL_STATE_MASK);
+    expect.dev_state &= ~(TAS5805M_CTRL_MUTE | TAS5805M_CTRL_STATE_MASK);
+    return memcmp(&expect, &actual, sizeof(tas5805m_signature_t)) == 0;
+}
+
+static int tas5805m_write_ctrl_state(audio_codec_tas5805m_t *codec, tas5805m_power_state_t state, bool mute)
+{
+    int value = 0;
+    int ret = tas5805m_read_reg(codec, TAS5805M_REG_03, &value);
+    value &= ~(TAS5805M_CTRL_STATE_MASK | TAS5805M_CTRL_MUTE);
+    value |= state | (mute ? TAS5805M_CTRL_MUTE : 0);
+    ret |= tas5805m_write_reg(codec, TAS5805M_REG_03, value);
+    if (ret == 0) {
+        codec->state = state;
+    }
+    return ret;
+}
+
+static int tas5805m_wait_power_state(audio_codec_tas5805m_t *codec, tas5805m_power_state_t state)
+{
+    int value = 0;
+    // Poll in short steps so that play latency is not quantized by tick, wait 50ms at most
+    for (int i = 0; i < TAS5805M_STATE_POLL_NUM; i++) {
+        if (tas5805m_read_reg(codec, TAS5805M_REG_68, &value) != 0) {
+            break;
+        }
+        if ((value & TAS5805M_CTRL_STATE_MASK) == state) {
+            return CODEC_DEV_OK;
+        }
+        codec_dev_delay_us(TAS5805M_STATE_POLL_US);
+    }
+    ESP_LOGE(TAG, "Wait for power state %d timeout, current %d", state, value);
+    return CODEC_DEV_DRV_ERR;
+}
+
+/* Power state machine using CTRL_STATE of register 0x03
+ * Output is always muted before leaving play and when entering play, so that device mute fade
+ * ramps the output without pop. Low power states are left through Hi-Z.
+ */
+static int tas5805m_set_power_state(audio_codec_tas5805m_t *codec, tas5805m_power_state_t state)
+{
+    int ret = 0;
+    if (codec->state == state) {
+        return CODEC_DEV_OK;
+    }
+    if (state == TAS5805M_POWER_PLAY) {
+        if (codec->state != TAS5805M_POWER_HIZ) {
+            ret = tas5805m_write_ctrl_state(codec, TAS5805M_POWER_HIZ, true);
+        }
+        uint64_t start = codec_dev_get_time_us();
+        ret |= tas5805m_write_ctrl_state(codec, TAS5805M_POWER_PLAY, true);
+        ret |= tas5805m_wait_power_state(codec, TAS5805M_POWER_PLAY);
+        codec->play_latency_us = (uint32_t) (codec_dev_get_time_us() - start);
+        ESP_LOGD(TAG, "Hi-Z to play takes %dus", (int) codec->play_latency_us);
+        if (ret == 0 && codec->muted == false) {
+            // Fade in is done by device, no need to wait
+            ret = tas5805m_write_ctrl_state(codec, TAS5805M_POWER_PLAY, false);
+        }
+    } else {
+        if (codec->state == TAS5805M_POWER_PLAY) {
+            ret = tas5805m_write_ctrl_state(codec, TAS5805M_POWER_PLAY, true);
+            if (codec->muted == false) {
+                codec_dev_sleep(codec->fade_ms);
+            }
+            ret |= tas5805m_write_ctrl_state(codec, TAS5805M_POWER_HIZ, true);
+        }
+        if (state != TAS5805M_POWER_HIZ) {
+            ret |= tas5805m_write_ctrl_state(codec, state, true);
+        }
+    }
+    return ret == 0 ? CODEC_DEV_OK : CODEC_DEV_WRITE_FAIL;
+}
+
 static void tas5805m_reset(audio_codec_tas5805m_t *codec, int16_t reset_pin)
 {
     const audio_codec_gpio_if_t *gpio_if = audio_codec_get_gpio_if();
@@ -160,14 +359,30 @@ static int tas5805m_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
         return CODEC_DEV_INVALID_ARG;
     }
     memcpy(&codec->cfg, codec_cfg, sizeof(tas5805m_codec_cfg_t));
+    codec->muted = false;
+    if (tas5805m_is_configured(codec)) {
+        // Amplifier kept powered since last open, only restore the play state
+        int ret = tas5805m_set_mute_fade(codec, 50);
+        ret |= tas5805m_set_vol_ramp(codec);
+        ret |= tas5805m_set_power_state(codec, TAS5805M_POWER_PLAY);
+        if (ret == CODEC_DEV_OK) {
+            ESP_LOGI(TAG, "Register program already loaded, skip reset and reload");
+            codec->is_open = true;
+            return ret;
+        }
+    }
     tas5805m_reset(codec, codec_cfg->reset_pin);
-    int ret = tas5805m_transmit_registers(codec, tas5805m_registers,
-                                          sizeof(tas5805m_registers) / sizeof(tas5805m_registers[0]));
+    // Use register program compiled from tas5805m_registers by tools/tas5805m_reg_compile.py
+    int ret = tas5805m_transmit_registers(codec, tas5805m_reg_program,
+                                          sizeof(tas5805m_reg_program) / sizeof(tas5805m_reg_program[0]));
     if (ret != CODEC_DEV_OK) {
         ESP_LOGE(TAG, "Fail write register group");
     } else {
+        // Register program ends in play state
+        codec->state = TAS5805M_POWER_PLAY;
         codec->is_open = true;
         tas5805m_set_mute_fade(codec, 50);
+        tas5805m_set_vol_ramp(codec);
     }
     return ret;
 }
@@ -208,17 +423,25 @@ static int tas5805m_set_mute(const audio_codec_if_t *h, bool enable)
     if (codec->is_open == false) {
         return CODEC_DEV_WRONG_STATE;
     }
-    int mute_reg = 0;
-    tas5805m_read_reg(codec, TAS5805M_REG_03, &mute_reg);
-    if (enable) {
-        mute_reg |= 0x8;
-    } else {
-        mute_reg &= (~0x08);
+    codec->muted = enable;
+    // Output stays muted out of play state, mute setting is applied when enter play
+    if (codec->state != TAS5805M_POWER_PLAY) {
+        return CODEC_DEV_OK;
     }
-    int ret = tas5805m_write_reg(codec, TAS5805M_REG_03, mute_reg);
+    int ret = tas5805m_write_ctrl_state(codec, TAS5805M_POWER_PLAY, enable);
     return ret == 0 ? CODEC_DEV_OK : CODEC_DEV_WRITE_FAIL;
 }
 
+static int tas5805m_get_caps(const audio_codec_if_t *h, uint32_t *caps)
+{
+    audio_codec_tas5805m_t *codec = (audio_codec_tas5805m_t *) h;
+    if (codec == NULL || caps == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    *caps = CODEC_IF_CAP_VOL_RAMP;
+    return CODEC_DEV_OK;
+}
+
 static int tas5805m_set_reg(const audio_codec_if_t *h, int reg, int value)
 {
     audio_codec_tas5805m_t *codec = (audio_codec_tas5805m_t *) h;
@@ -243,12 +466,121 @@ static int tas5805m_get_reg(const audio_codec_if_t *h, int reg, int *value)
     return tas5805m_read_reg(codec, reg, value);
 }
 
+static void tas5805m_pack_coef(uint8_t *data, int32_t coef)
+{
+    data[0] = (uint8_t) (coef >> 24);
+    data[1] = (uint8_t) (coef >> 16);
+    data[2] = (uint8_t) (coef >> 8);
+    data[3] = (uint8_t) coef;
+}
+
+/* Write DSP coefficients starting from book/page/reg, continue on next page when reach page end
+ * Bus is held so that other control access can not land on coefficient book
+ */
+static int tas5805m_write_coef(audio_codec_tas5805m_t *codec, uint8_t book, uint8_t page, uint8_t reg, uint8_t *data,
+                               int size)
+{
+    int ret = audio_codec_ctrl_acquire(codec->cfg.ctrl_if, true);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    ret = tas5805m_select_book_page(codec, book, page);
+    while (ret == 0 && size > 0) {
+        int len = TAS5805M_COEF_REG_END - reg;
+        if (len > size) {
+            len = size;
+        }
+        ret = tas5805m_write_data(codec, reg, data, len);
+        data += len;
+        size -= len;
+        if (ret == 0 && size > 0) {
+            ret = tas5805m_write_reg(codec, TAS5805M_REG_00, ++page);
+            reg = TAS5805M_COEF_REG_START;
+        }
+    }
+    // Other settings are all in book 0 page 0
+    ret |= tas5805m_select_book_page(codec, TAS5805M_BOOK_00, TAS5805M_PAGE_00);
+    audio_codec_ctrl_acquire(codec->cfg.ctrl_if, false);
+    return ret == 0 ? CODEC_DEV_OK : CODEC_DEV_WRITE_FAIL;
+}
+
+int tas5805m_set_biquads(const audio_codec_if_t *h, tas5805m_channel_t channel, int start,
+                         const tas5805m_biquad_t *biquad, int num)
+{
+    audio_codec_tas5805m_t *codec = (audio_codec_tas5805m_t *) h;
+    if (codec == NULL || biquad == NULL || channel < TAS5805M_CHANNEL_LEFT || channel > TAS5805M_CHANNEL_RIGHT ||
+        start < 0 || num <= 0 || start + num > TAS5805M_BIQUAD_PER_CHANNEL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (codec->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    uint8_t data[TAS5805M_BIQUAD_PER_CHANNEL * sizeof(tas5805m_biquad_t)];
+    for (int i = 0; i < num; i++) {
+        uint8_t *bq = data + i * sizeof(tas5805m_biquad_t);
+        tas5805m_pack_coef(bq, biquad[i].b0);
+        tas5805m_pack_coef(bq + 4, biquad[i].b1);
+        tas5805m_pack_coef(bq + 8, biquad[i].b2);
+        tas5805m_pack_coef(bq + 12, biquad[i].a1);
+        tas5805m_pack_coef(bq + 16, biquad[i].a2);
+    }
+    // Biquads are continuous from the start register, locate page and register of the first one
+    int offset = (TAS5805M_BIQUAD_REG - TAS5805M_COEF_REG_START) +
+                 (channel * TAS5805M_BIQUAD_PER_CHANNEL + start) * (int) sizeof(tas5805m_biquad_t);
+    uint8_t page = TAS5805M_BIQUAD_PAGE + offset / TAS5805M_COEF_PAGE_SIZE;
+    uint8_t reg = TAS5805M_COEF_REG_START + offset % TAS5805M_COEF_PAGE_SIZE;
+    return tas5805m_write_coef(codec, TAS5805M_BIQUAD_BOOK, page, reg, data, num * sizeof(tas5805m_biquad_t));
+}
+
+int tas5805m_set_mixer(const audio_codec_if_t *h, const tas5805m_mixer_t *mixer)
+{
+    audio_codec_tas5805m_t *codec = (audio_codec_tas5805m_t *) h;
+    if (codec == NULL || mixer == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (codec->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    uint8_t data[sizeof(tas5805m_mixer_t)];
+    tas5805m_pack_coef(data, mixer->left_to_left);
+    tas5805m_pack_coef(data + 4, mixer->right_to_left);
+    tas5805m_pack_coef(data + 8, mixer->left_to_right);
+    tas5805m_pack_coef(data + 12, mixer->right_to_right);
+    return tas5805m_write_coef(codec, TAS5805M_MIXER_BOOK, TAS5805M_MIXER_PAGE, TAS5805M_MIXER_REG, data, sizeof(data));
+}
+
+static int tas5805m_enable(const audio_codec_if_t *h, bool enable)
+{
+    audio_codec_tas5805m_t *codec = (audio_codec_tas5805m_t *) h;
+    if (codec == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (codec->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    return tas5805m_set_power_state(codec, enable ? TAS5805M_POWER_PLAY : codec->cfg.idle_state);
+}
+
+int tas5805m_get_play_latency(const audio_codec_if_t *h, uint32_t *latency_us)
+{
+    audio_codec_tas5805m_t *codec = (audio_codec_tas5805m_t *) h;
+    if (codec == NULL || latency_us == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    *latency_us = codec->play_latency_us;
+    return CODEC_DEV_OK;
+}
+
 static int tas5805m_close(const audio_codec_if_t *h)
 {
     audio_codec_tas5805m_t *codec = (audio_codec_tas5805m_t *) h;
     if (codec == NULL) {
         return CODEC_DEV_INVALID_ARG;
     }
+    if (codec->is_open) {
+        // Keep program loaded in lowest power state so that next open can skip reload
+        tas5805m_set_power_state(codec, codec->cfg.idle_state);
+    }
     codec->is_open = false;
     return 0;
 }
@@ -271,9 +603,11 @@ const audio_codec_if_t *tas5805m_codec_new(tas5805m_codec_cfg_t *codec_cfg)
     codec->base.open = tas5805m_open;
     codec->base.set_vol = tas5805m_set_volume;
     codec->base.mute = tas5805m_set_mute;
+    codec->base.enable = tas5805m_enable;
     codec->base.set_reg = tas5805m_set_reg;
     codec->base.get_reg = tas5805m_get_reg;
     codec->base.close = tas5805m_close;
+    codec->base.get_caps = tas5805m_get_caps;
     do {
         int ret = codec->base.open(&codec->base, codec_cfg, sizeof(tas5805m_codec_cfg_t));
         if (ret != 0) {
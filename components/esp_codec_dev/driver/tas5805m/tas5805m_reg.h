@@ -41,17 +41,45 @@ extern "C" {
 #define TAS5805M_REG_2A         0x2a
 #define TAS5805M_REG_2B         0x2b
 #define TAS5805M_REG_35         0x35
+#define TAS5805M_REG_68         0x68 /* POWER_STATE, read only */
 #define TAS5805M_REG_7E         0x7e
 #define TAS5805M_REG_7F         0x7f
 
 #define TAS5805M_PAGE_00        0x00
+#define TAS5805M_PAGE_24        0x24
+#define TAS5805M_PAGE_29        0x29
 #define TAS5805M_PAGE_2A        0x2a
+#define TAS5805M_PAGE_2B        0x2b
 
 #define TAS5805M_BOOK_00        0x00
 #define TAS5805M_BOOK_8C        0x8c
+#define TAS5805M_BOOK_AA        0xaa
+
+/* DSP coefficients use registers 0x08 ~ 0x7f of each page, 32 bits big endian */
+#define TAS5805M_COEF_REG_START 0x08
+#define TAS5805M_COEF_REG_END   0x80
+#define TAS5805M_COEF_PAGE_SIZE (TAS5805M_COEF_REG_END - TAS5805M_COEF_REG_START)
+
+/* Biquads of left then right channel, continuous across pages (book 0xaa) */
+#define TAS5805M_BIQUAD_BOOK    TAS5805M_BOOK_AA
+#define TAS5805M_BIQUAD_PAGE    TAS5805M_PAGE_24
+#define TAS5805M_BIQUAD_REG     0x18
+
+/* Input mixer gains: left to left, right to left, left to right, right to right (book 0x8c) */
+#define TAS5805M_MIXER_BOOK     TAS5805M_BOOK_8C
+#define TAS5805M_MIXER_PAGE     TAS5805M_PAGE_29
+#define TAS5805M_MIXER_REG      0x18
 
 #define MASTER_VOL_REG_ADDR     0X4C
 #define MUTE_TIME_REG_ADDR      0X51
+#define DIG_VOL_CTRL_REG_ADDR   0X4E
+
+/* Register 0x4E DIG_VOL_CTRL, ramp down and up by 0.5dB every 4 FS */
+#define TAS5805M_DIG_VOL_RAMP 0xBB
+
+/* Register 0x03 DEVICE_CTRL_2 */
+#define TAS5805M_CTRL_STATE_MASK 0x03
+#define TAS5805M_CTRL_MUTE       0x08
 
 #define TAS5805M_DAMP_MODE_BTL  0x0
 #define TAS5805M_DAMP_MODE_PBTL 0x04
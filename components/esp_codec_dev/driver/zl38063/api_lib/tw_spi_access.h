@@ -4,7 +4,10 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include "vproc_common.h"
 
-int tw_upload_dsp_firmware(int mode);
+int tw_upload_dsp_firmware(VprocDev *dev, int mode);
+
+int tw_boot_dsp_firmware_from_flash(VprocDev *dev);
 
 #endif
@@ -26,6 +26,9 @@
 #define HBI_CL_BROADCAST ((uint16) 0xFEFF)
 #define HBI_NO_OP        ((uint16) 0xFFFF)
 
+/*Maximum data words carried by one HBI write command*/
+#define HBI_MAX_BURST_WORDS 126
+
 #ifndef USING_MICROSEMI_LINUX_KERNEL_DRIVER
 /*TWOLF REGisters*/
 #define HOST_CMD_REG              0x0032 /*Host Command register*/
@@ -71,35 +74,99 @@
 #define TWOLF_MBCMDREG_SPINWAIT      10000
 #define TWOLF_MAILBOX_SPINWAIT       1000
 
-/*--------------------------------------------------------------------*/
-/* VprocTwolfMailboxAcquire(): use this function to
- *   check for the availability of the mailbox
+/*Adaptive polling: a few fast reads first, then exponential back off*/
+#define TWOLF_POLL_FAST_COUNT       8     /*number of fast polls*/
+#define TWOLF_POLL_FAST_INTERVAL_US 50    /*interval between fast polls*/
+#define TWOLF_POLL_MAX_INTERVAL_US  10000 /*back off limit, same as the former fixed poll period*/
+#define TWOLF_POLL_IRQ_CHECK_US     100   /*interval to check interrupt pin while busy waiting*/
+#define TWOLF_POLL_PERIOD_MS        10    /*timeout arguments count in units of this former poll period*/
+
+/* VprocTwolfBackOff(): wait for next poll, return early once the
+ * device interrupt pin is asserted if it is used
+ * Only sub-millisecond waits are busy waits, longer ones sleep so that
+ * other tasks can run (sleep is rounded up to at least one OS tick)
+ */
+static void VprocTwolfBackOff(VprocDev *dev, uint32 interval_us)
+{
+    if (VprocHALIrqAsserted(dev) < 0) {
+        if (interval_us >= 1000) {
+            Vproc_msDelay(interval_us / 1000);
+        } else {
+            VprocWaitUs(interval_us);
+        }
+        return;
+    }
+    uint64_t start = VprocGetTimeUs();
+    while (VprocHALIrqAsserted(dev) == 0) {
+        uint64_t elapsed = VprocGetTimeUs() - start;
+        if (elapsed >= interval_us) {
+            break;
+        }
+        uint32 left = interval_us - (uint32) elapsed;
+        if (left >= 1000) {
+            Vproc_msDelay(1);
+        } else {
+            VprocWaitUs(left > TWOLF_POLL_IRQ_CHECK_US ? TWOLF_POLL_IRQ_CHECK_US : left);
+        }
+    }
+}
+
+/* VprocTwolfWaitReg(): poll reg until (reg & mask) == expect
  *
- * Input Argument: None
+ * Input Argument: timeout - in units of TWOLF_POLL_PERIOD_MS
  * Return: (VprocStatusType) type error code (0 = success, else= fail)
+ *         pVal - the last value read
  */
-static VprocStatusType VprocTwolfMailboxAcquire(uint16 flag, uint16 timeout)
+static VprocStatusType VprocTwolfWaitReg(VprocDev *dev, uint16 reg, uint16 mask, uint16 expect, uint16 timeout,
+                                         uint16 *pVal)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
-    /*Check whether the host owns the command register*/
-    uint16 i = 0, temp = 0x0BAD;
-    for (i = 0; i < timeout; i++) {
-        status = VprocTwolfHbiRead(HOST_SW_FLAGS_REG, 1, &temp);
+    uint64_t start = VprocGetTimeUs();
+    uint64_t timeout_us = (uint64_t) timeout * TWOLF_POLL_PERIOD_MS * 1000;
+    uint32 interval = TWOLF_POLL_FAST_INTERVAL_US;
+    int i;
+    for (i = 0;; i++) {
+        status = VprocTwolfHbiRead(dev, reg, 1, pVal);
+        dev->cmd_stats.poll_count++;
         if ((status != VPROC_STATUS_SUCCESS)) {
             DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
             return status;
         }
-        if (!(temp & flag)) {
+        if ((*pVal & mask) == expect) {
             break;
         }
-        Vproc_msDelay(10); /*wait for reset to complete*/
+        if (VprocGetTimeUs() - start >= timeout_us) {
+            DEBUG_LOGD(TAG_SPI, "timeout count = %d, reg 0x%04x = 0x%04x: \n", i, reg, *pVal);
+            return VPROC_STATUS_FAILURE;
+        }
+        if (i >= TWOLF_POLL_FAST_COUNT && interval < TWOLF_POLL_MAX_INTERVAL_US) {
+            interval <<= 1;
+            if (interval > TWOLF_POLL_MAX_INTERVAL_US) {
+                interval = TWOLF_POLL_MAX_INTERVAL_US;
+            }
+        }
+        VprocTwolfBackOff(dev, interval);
     }
-    DEBUG_LOGD(TAG_SPI, "timeout count = %d: \n", i);
-    if ((i >= timeout) && (temp & flag)) {
+    DEBUG_LOGD(TAG_SPI, "poll count = %d, reg 0x%04x = 0x%04x: \n", i, reg, *pVal);
+    return VPROC_STATUS_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+/* VprocTwolfMailboxAcquire(): use this function to
+ *   check for the availability of the mailbox
+ *
+ * Input Argument: None
+ * Return: (VprocStatusType) type error code (0 = success, else= fail)
+ */
+static VprocStatusType VprocTwolfMailboxAcquire(VprocDev *dev, uint16 flag, uint16 timeout)
+{
+    /*Check whether the host owns the command register*/
+    uint16 temp = 0x0BAD;
+    VprocStatusType status = VprocTwolfWaitReg(dev, HOST_SW_FLAGS_REG, flag, 0, timeout, &temp);
+    if (status == VPROC_STATUS_FAILURE) {
         return VPROC_STATUS_MAILBOX_BUSY;
     }
-    /*read the Host Command register*/
-    return VPROC_STATUS_SUCCESS;
+    return status;
 }
 
 /* VprocTwolfcmdRegAcquire(): use this function to
@@ -108,27 +175,45 @@ static VprocStatusType VprocTwolfMailboxAcquire(uint16 flag, uint16 timeout)
  * Input Argument: None
  * Return: (VprocStatusType) type error code (0 = success, else= fail)
  */
-static VprocStatusType VprocTwolfcmdRegAcquire(uint16 flag, uint16 timeout)
+static VprocStatusType VprocTwolfcmdRegAcquire(VprocDev *dev, uint16 flag, uint16 timeout)
 {
-    VprocStatusType status = VPROC_STATUS_SUCCESS;
     /*Check whether the host owns the command register*/
-    uint16 i = 0, temp = 0x0BAD;
-    for (i = 0; i < timeout; i++) {
-        status = VprocTwolfHbiRead(HOST_CMD_REG, 1, &temp);
-        if ((status != VPROC_STATUS_SUCCESS)) {
-            DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
-            return status;
-        }
-        if (temp == flag) {
-            break;
-        }
-        Vproc_msDelay(10); /*wait*/
-    }
-    DEBUG_LOGD(TAG_SPI, "timeout count = %d, cmdReg = 0x%04x: \n", i, temp);
-    if ((i >= timeout) && (temp != flag)) {
+    uint16 temp = 0x0BAD;
+    VprocStatusType status = VprocTwolfWaitReg(dev, HOST_CMD_REG, 0xFFFF, flag, timeout, &temp);
+    if (status == VPROC_STATUS_FAILURE) {
         return VPROC_STATUS_CMDREG_BUSY;
     }
-    /*read the Host Command register*/
+    return status;
+}
+
+static void VprocTwolfCmdStatsUpdate(VprocDev *dev, uint64_t start, VprocStatusType status)
+{
+    uint32 wait_us = (uint32) (VprocGetTimeUs() - start);
+    dev->cmd_stats.cmd_count++;
+    if (status != VPROC_STATUS_SUCCESS) {
+        dev->cmd_stats.timeout_count++;
+    }
+    dev->cmd_stats.total_wait_us += wait_us;
+    if (wait_us > dev->cmd_stats.max_wait_us) {
+        dev->cmd_stats.max_wait_us = wait_us;
+    }
+}
+
+/* VprocTwolfGetCmdStats(): use this function to get the latency statistics of
+ *   host commands issued through the command register
+ *
+ * Input Argument: reset - clear the statistics after read
+ * Return: (VprocStatusType) type error code (0 = success, else= fail)
+ */
+VprocStatusType VprocTwolfGetCmdStats(VprocDev *dev, VprocCmdStats *stats, int reset)
+{
+    if (stats == NULL) {
+        return VPROC_STATUS_INVALID_ARG;
+    }
+    *stats = dev->cmd_stats;
+    if (reset) {
+        memset(&dev->cmd_stats, 0, sizeof(dev->cmd_stats));
+    }
     return VPROC_STATUS_SUCCESS;
 }
 
@@ -138,19 +223,21 @@ static VprocStatusType VprocTwolfcmdRegAcquire(uint16 flag, uint16 timeout)
  * Input Argument: cmd - the command to send
  * Return: (VprocStatusType) type error code (0 = success, else= fail)
  */
-static VprocStatusType VprocTwolfcmdRegWr(unsigned short cmd)
+static VprocStatusType VprocTwolfcmdRegWr(VprocDev *dev, unsigned short cmd)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short flag = 0x0BAD;
+    uint64_t start = VprocGetTimeUs();
     /*Check whether the host owns the command register*/
 
-    status = VprocTwolfMailboxAcquire(HOST_SW_FLAGS_CMD, TWOLF_MAILBOX_SPINWAIT);
+    status = VprocTwolfMailboxAcquire(dev, HOST_SW_FLAGS_CMD, TWOLF_MAILBOX_SPINWAIT);
     if ((status != VPROC_STATUS_SUCCESS)) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
+        VprocTwolfCmdStatsUpdate(dev, start, status);
         return status;
     }
     /*write the command into the Host Command register*/
-    status = VprocTwolfHbiWrite(HOST_CMD_REG, 1, &cmd);
+    status = VprocTwolfHbiWrite(dev, HOST_CMD_REG, 1, &cmd);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -158,13 +245,14 @@ static VprocStatusType VprocTwolfcmdRegWr(unsigned short cmd)
     /*Release the command reg*/
     /*read the Host Command register*/
     flag = HOST_SW_FLAGS_CMD;
-    status = VprocTwolfHbiWrite(HOST_SW_FLAGS_REG, 1, &flag);
+    status = VprocTwolfHbiWrite(dev, HOST_SW_FLAGS_REG, 1, &flag);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
     }
     /*Wait for the command to complete*/
-    status = VprocTwolfcmdRegAcquire(HOST_CMD_IDLE, TWOLF_MAILBOX_SPINWAIT);
+    status = VprocTwolfcmdRegAcquire(dev, HOST_CMD_IDLE, TWOLF_MAILBOX_SPINWAIT);
+    VprocTwolfCmdStatsUpdate(dev, start, status);
     if ((status != VPROC_STATUS_SUCCESS)) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: CMD_REG - Operation is not complete\n", status);
         return status;
@@ -172,11 +260,11 @@ static VprocStatusType VprocTwolfcmdRegWr(unsigned short cmd)
     return VPROC_STATUS_SUCCESS;
 }
 
-static VprocStatusType VprocTwolfCheckCmdResult(void)
+static VprocStatusType VprocTwolfCheckCmdResult(VprocDev *dev)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short buf;
-    status = VprocTwolfHbiRead(HOST_CMD_PARAM_RESULT_REG, 1, &buf);
+    status = VprocTwolfHbiRead(dev, HOST_CMD_PARAM_RESULT_REG, 1, &buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -189,119 +277,38 @@ static VprocStatusType VprocTwolfCheckCmdResult(void)
     return VPROC_STATUS_SUCCESS;
 }
 
-/* spis_tw_hbi_rd16()- Decode the 16-bit T-WOLF Regs Host address into
- * page, offset and build the 16-bit command acordingly to the access type.
- * then read the 16-bit word data and store it in pdata
- *  \param[in]
- *  .addr     the 16-bit HBI address
- *
- *  return ::status
- */
-static int spis_tw_hbi_rd16(uint16 *pdata)
-{
-    /*perform the HBI access*/
-    if (VprocHALRead(pdata) != 0) {
-        return VPROC_STATUS_ERR_HBI;
-    }
-    return 0;
-}
-
-/* spis_tw_hbi_wr16_cmd()- this function is used for single word access
- * It decodes the 16-bit T-WOLF Regs Host address into
- * page, offset and build the 16-bit command acordingly to the access type.
- * then write the command to the device
+/* spis_tw_hbi_cmd()- Decode the 16-bit T-WOLF Regs Host address into
+ * page, offset and build the 16-bit command words acordingly to the access type.
+ * Paged access is preceded by the page select command, so that both command
+ * words can be sent together with the data words in one transfer
  *  \param[in]
  *                .addr      the 16-bit HBI address
+ *                .numwords  number of data words to access
+ *                .write     build write command if not 0, else read command
+ *  \param[out]
+ *                .pcmd      command words, at most 2
  *
- *  return ::status
- */
-static int spis_tw_hbi_wr16_cmd(uint16 addr, uint8 numwords)
-{
-    uint16 cmd;
-    int status = 0;
-    uint8 page;
-    uint8 offset;
-
-    page = addr >> 8;
-    offset = (addr & 0xFF) / 2;
-
-    if (page == 0) {                                  /*Direct page access*/
-        cmd = HBI_DIRECT_WRITE(offset, numwords - 1); /*build the cmd*/
-    } else {
-        /*indirect page access*/
-        if (page != 0xFF) {
-            page -= 1;
-        }
-        cmd = HBI_SELECT_PAGE(page);
-        /*select the page*/
-        if (VprocHALWrite(cmd) != 0) {
-            return status;
-        }
-        cmd = HBI_PAGED_WRITE(offset, numwords - 1); /*build the cmd*/
-    }
-    /*perform the HBI access*/
-    if (VprocHALWrite(cmd) != 0) { /*write the register address*/
-        return status;
-    }
-    return 0;
-}
-
-/* spis_tw_hbi_rd16()- Decode the 16-bit T-WOLF Regs Host address into
- * page, offset and build the 16-bit command acordingly to the access type.
- * then read the 16-bit word data and store it in pdata
- *  \param[in]
- *                .addr     the 16-bit HBI address
- *
- *  return ::status
+ *  return number of command words
  */
-static int spis_tw_hbi_rd16_cmd(uint16 addr, uint8 numwords)
+static int spis_tw_hbi_cmd(uint16 addr, uint8 numwords, int write, uint16 *pcmd)
 {
-    uint16 cmd;
-    int status = 0;
     uint8 page;
     uint8 offset;
 
     page = addr >> 8;
     offset = (addr & 0xFF) / 2;
 
-    if (page == 0) {
-        /*Direct page access*/
-        cmd = HBI_DIRECT_READ(offset, numwords - 1); /*build the cmd*/
-    } else {
-        /*Indirect page access*/
-        if (page != 0xFF) {
-            page -= 1;
-        }
-        cmd = HBI_SELECT_PAGE(page);
-        /*select the page*/
-        if (VprocHALWrite(cmd) != 0) {
-            return status;
-        }
-        cmd = HBI_PAGED_READ(offset, numwords - 1); /*build the cmd*/
-    }
-
-    /*perform the HBI access*/
-    if (VprocHALWrite(cmd) != 0) { /*write the register address*/
-        return status;
+    if (page == 0) { /*Direct page access*/
+        pcmd[0] = write ? HBI_DIRECT_WRITE(offset, numwords - 1) : HBI_DIRECT_READ(offset, numwords - 1);
+        return 1;
     }
-    return 0;
-}
-
-/* spis_tw_hbi_wr16()- this function is used for single word access by the
- * ioctl read. It decodes the 16-bit T-WOLF Regs Host address into
- * page, offset and build the 16-bit command acordingly to the access type.
- * then write the command and data to the device
- *  \param[in]
- *                .addr      the 16-bit HBI address
- *
- *  return ::status
- */
-static int spis_tw_hbi_wr16_data(uint16 data)
-{
-    if (VprocHALWrite(data) != 0) {
-        return VPROC_STATUS_ERR_HBI;
+    /*indirect page access*/
+    if (page != 0xFF) {
+        page -= 1;
     }
-    return 0;
+    pcmd[0] = HBI_SELECT_PAGE(page);
+    pcmd[1] = write ? HBI_PAGED_WRITE(offset, numwords - 1) : HBI_PAGED_READ(offset, numwords - 1);
+    return 2;
 }
 
 /******************************************************************************
@@ -317,11 +324,11 @@ static int spis_tw_hbi_wr16_data(uint16 data)
  * \retval ::VP_STATUS_SUCCESS
  * \retval ::VP_STATUS_ERR_HBI
  ******************************************************************************/
-static VprocStatusType TwolfHbiPage255Write(unsigned char page, unsigned char offset, unsigned char numWords,
-                                            unsigned short *pDdata)
+static VprocStatusType TwolfHbiPage255Write(VprocDev *dev, unsigned char page, unsigned char offset,
+                                            unsigned char numWords, unsigned short *pDdata)
 {
     uint16 cmdWrd = (uint16) (page << 8) | (uint16) offset;
-    if (VprocTwolfHbiWrite(cmdWrd, numWords, pDdata) != VPROC_STATUS_SUCCESS) {
+    if (VprocTwolfHbiWrite(dev, cmdWrd, numWords, pDdata) != VPROC_STATUS_SUCCESS) {
         return VPROC_STATUS_ERR_HBI;
     }
     return VPROC_STATUS_SUCCESS;
@@ -340,13 +347,13 @@ static VprocStatusType TwolfHbiPage255Write(unsigned char page, unsigned char of
  * \retval ::VPROC_STATUS_ERR_HBI
  */
 
-VprocStatusType VprocTwolfHbiInit(void)
+VprocStatusType VprocTwolfHbiInit(VprocDev *dev)
 {
     unsigned short buf = HBI_CONFIG_REG | HBI_CONFIG_VAL;
-    if (VprocHALInit() != 0) {
+    if (VprocHALInit(dev) != 0) {
         return VPROC_STATUS_INIT_FAILED;
     }
-    return VprocHALWrite(buf);
+    return VprocHALWrite(dev, buf);
 }
 
 /*VprocTwolfHbiCleanup - To close any open communication path to
@@ -355,12 +362,13 @@ VprocStatusType VprocTwolfHbiInit(void)
  * \retval ::VPROC_STATUS_SUCCESS
  * \retval ::VPROC_STATUS_ERR_HBI
  */
-VprocStatusType VprocTwolfHbiCleanup(void)
+VprocStatusType VprocTwolfHbiCleanup(VprocDev *dev)
 {
-    VprocHALcleanup();
+    VprocHALcleanup(dev);
     return VPROC_STATUS_SUCCESS;
 }
 /*VprocTwolfHbiRead - use this function to read up to 254 words from the device
+ * The command words and data words are transferred in one transaction
  * \param[in] cmd of the requested device register to read from
  * \param[in] numWords Number of words to read starting from the offset
  * \param[in] pData Pointer to the data read
@@ -368,33 +376,25 @@ VprocStatusType VprocTwolfHbiCleanup(void)
  * \retval ::VPROC_STATUS_SUCCESS
  * \retval ::VPROC_STATUS_ERR_HBI
  */
-VprocStatusType VprocTwolfHbiRead(unsigned short cmd, /*register to read from*/
+VprocStatusType VprocTwolfHbiRead(VprocDev *dev, unsigned short cmd, /*register to read from*/
                                   unsigned char numwords, unsigned short *pData)
 {
-    VprocStatusType status = VPROC_STATUS_SUCCESS;
-    unsigned short tempBuf = 0x0BAD;
-    unsigned char i = 0;
+    uint16 hbiCmd[2];
 
+    if (numwords == 0) {
+        return VPROC_STATUS_INVALID_ARG;
+    }
     // DEBUG_LOGE(TAG_SPI, "cmd = 0x%04x\n", cmd);
-    status = spis_tw_hbi_rd16_cmd(cmd, numwords);
-    if (status != VPROC_STATUS_SUCCESS) {
+    int cmdNum = spis_tw_hbi_cmd(cmd, numwords, 0, hbiCmd);
+    if (VprocHALReadCmd(dev, hbiCmd, cmdNum, pData, numwords) != 0) {
         DEBUG_LOGE(TAG_SPI, "ERROR: VPROC_STATUS_RD_FAILED,CMD:0x%04x\n", cmd);
-        return VPROC_STATUS_WR_FAILED;
-    }
-
-    for (i = 0; i < numwords; i++) {
-        status = spis_tw_hbi_rd16(&tempBuf);
-        pData[i] = tempBuf;
-        // DEBUG_LOGE(TAG_SPI, "pData[%d] = 0x%04x\n", i, pData[i]);
-        if (status != VPROC_STATUS_SUCCESS) {
-            DEBUG_LOGE(TAG_SPI, "ERROR: VPROC_STATUS_RD_FAILED,CMD:0x%04x\n", cmd);
-            return VPROC_STATUS_RD_FAILED;
-        }
+        return VPROC_STATUS_RD_FAILED;
     }
-    return status;
+    return VPROC_STATUS_SUCCESS;
 }
 
-/*VprocTwolfHbiWrite - use this function to write up to 252 words to the device
+/*VprocTwolfHbiWrite - use this function to write up to 126 words to the device
+ * The command words and data words are sent in one transaction
  * \param[in] cmd of the requested device register to write to
  * \param[in] numWords Number of words to write starting from the offset
  * \param[in] pData Pointer to the data to write
@@ -402,29 +402,23 @@ VprocStatusType VprocTwolfHbiRead(unsigned short cmd, /*register to read from*/
  * \retval ::VPROC_STATUS_SUCCESS
  * \retval ::VPROC_STATUS_ERR_HBI
  */
-VprocStatusType VprocTwolfHbiWrite(unsigned short cmd, /*register to read from*/
+VprocStatusType VprocTwolfHbiWrite(VprocDev *dev, unsigned short cmd, /*register to read from*/
                                    unsigned char numwords, unsigned short *pData)
 {
-    VprocStatusType status = VPROC_STATUS_SUCCESS;
-    unsigned char i = 0;
+    uint16 hbiCmd[2];
+    uint16 burst[HBI_MAX_BURST_WORDS];
 
-    if ((numwords == 0) || (numwords > 126)) {
-        DEBUG_LOGE(TAG_SPI, "number of words is out of range. Maximum is 126\n");
+    if ((numwords == 0) || (numwords > HBI_MAX_BURST_WORDS)) {
+        DEBUG_LOGE(TAG_SPI, "number of words is out of range. Maximum is %d\n", HBI_MAX_BURST_WORDS);
         return VPROC_STATUS_INVALID_ARG;
     }
-    /*16-bit SPI access mode - Send only 1 word within the same CS*/
-    status = spis_tw_hbi_wr16_cmd(cmd, numwords);
-    if (status != VPROC_STATUS_SUCCESS) {
-        DEBUG_LOGE(TAG_SPI, "ERROR: VPROC_STATUS_WR_FAILED\n");
+    int cmdNum = spis_tw_hbi_cmd(cmd, numwords, 1, hbiCmd);
+    /* Data is converted into bus byte order by HAL, keep caller buffer untouched */
+    memcpy(burst, pData, numwords * sizeof(uint16));
+    if (VprocHALWriteCmd(dev, hbiCmd, cmdNum, burst, numwords) != 0) {
+        DEBUG_LOGE(TAG_SPI, "ERROR: VPROC_STATUS_WR_FAILED,CMD:0x%04x\n", cmd);
         return VPROC_STATUS_WR_FAILED;
     }
-    for (i = 0; i < numwords; i++) {
-        status = spis_tw_hbi_wr16_data(pData[i]);
-        if (status != VPROC_STATUS_SUCCESS) {
-            DEBUG_LOGE(TAG_SPI, "ERROR: VPROC_STATUS_WR_FAILED\n");
-            return VPROC_STATUS_WR_FAILED;
-        }
-    }
     return VPROC_STATUS_SUCCESS;
 }
 
@@ -433,7 +427,7 @@ VprocStatusType VprocTwolfHbiWrite(unsigned short cmd, /*register to read from*/
  * \retval ::VPROC_STATUS_SUCCESS
  * \retval ::VPROC_STATUS_ERR_HBI
  */
-VprocStatusType VprocTwolfLoadConfig(dataArr *pCr2Buf, unsigned short numElements)
+VprocStatusType VprocTwolfLoadConfig(VprocDev *dev, dataArr *pCr2Buf, unsigned short numElements)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short i, buf;
@@ -442,7 +436,7 @@ VprocStatusType VprocTwolfLoadConfig(dataArr *pCr2Buf, unsigned short numElement
     /*send the config to the device RAM*/
     for (i = 0; i < numElements; i++) {
         buf = pCr2Buf[i].value;
-        status = VprocTwolfHbiWrite(pCr2Buf[i].reg, 1, &buf);
+        status = VprocTwolfHbiWrite(dev, pCr2Buf[i].reg, 1, &buf);
         if (status != VPROC_STATUS_SUCCESS) {
             return VPROC_STATUS_ERR_HBI;
         }
@@ -454,7 +448,7 @@ VprocStatusType VprocTwolfLoadConfig(dataArr *pCr2Buf, unsigned short numElement
 /* HbiSrecBoot_alt() Use this alternate method to load the st_twFirmware.c
  *(converted *.s3 to c code) to the device
  */
-static VprocStatusType HbiSrecBoot_alt(twFirmware *st_firmware)
+static VprocStatusType HbiSrecBoot_alt(VprocDev *dev, twFirmware *st_firmware)
 {
     uint16 index = 0;
     uint16 gTargetAddr[2] = {0, 0};
@@ -473,7 +467,7 @@ static VprocStatusType HbiSrecBoot_alt(twFirmware *st_firmware)
         /* write the data to the device */
         if (st_firmware->st_Fwr[index].numWords != 0) {
             if (st_firmware->st_Fwr[index].useTargetAddr) {
-                status = VprocTwolfHbiWrite(PAGE_255_BASE_HI_REG, 2, gTargetAddr);
+                status = VprocTwolfHbiWrite(dev, PAGE_255_BASE_HI_REG, 2, gTargetAddr);
                 if (status != VPROC_STATUS_SUCCESS) {
                     DEBUG_LOGE(TAG_SPI,
                                "Unable to set gTargetAddr[0] = 0x%04x,"
@@ -482,7 +476,7 @@ static VprocStatusType HbiSrecBoot_alt(twFirmware *st_firmware)
                     return VPROC_STATUS_ERR_HBI;
                 }
             }
-            status = TwolfHbiPage255Write(0xFF, (uint8) ((gTargetAddr[1] & 0x00FF)),
+            status = TwolfHbiPage255Write(dev, 0xFF, (uint8) ((gTargetAddr[1] & 0x00FF)),
                                           st_firmware->st_Fwr[index].numWords, st_firmware->st_Fwr[index].buf);
             if (status != VPROC_STATUS_SUCCESS) {
                 DEBUG_LOGE(TAG_SPI, "status = %d, numWords = %d: \n", status, st_firmware->st_Fwr[index].numWords);
@@ -505,7 +499,7 @@ static VprocStatusType HbiSrecBoot_alt(twFirmware *st_firmware)
     /* program the program's execution start register */
     gTargetAddr[0] = (uint16) ((st_firmware->execAddr & 0xFFFF0000) >> 16);
     gTargetAddr[1] = (uint16) (st_firmware->execAddr & 0x0000FFFF);
-    status = VprocTwolfHbiWrite(0x12C, 2, gTargetAddr);
+    status = VprocTwolfHbiWrite(dev, 0x12C, 2, gTargetAddr);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, " unable to program page 1 execution address\n");
         return status;
@@ -518,15 +512,10 @@ static VprocStatusType HbiSrecBoot_alt(twFirmware *st_firmware)
     return VPROC_STATUS_SUCCESS;
 }
 
-/*VprocTwolfHbiBoot_alt - use this function to bootload the firmware
- * into the device
- * \param[in] pointer to image data structure
- *
- * \retval ::VPROC_STATUS_SUCCESS
- * \retval ::VPROC_STATUS_ERR_HBI
- * \retval ::VPROC_STATUS_MAILBOX_BUSY
+/* TwolfHbiBootEnter() stop the current firmware and put the device into
+ * the Boot Rom mode ready to receive a new image
  */
-VprocStatusType VprocTwolfHbiBoot_alt(twFirmware *st_firmware)
+static VprocStatusType TwolfHbiBootEnter(VprocDev *dev)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short buf[2] = {0, 0};
@@ -535,14 +524,14 @@ VprocStatusType VprocTwolfHbiBoot_alt(twFirmware *st_firmware)
      * to stop current firmware, reset the device into the Boot Rom mode.
      */
     buf[0] = 1; // TWOLF_CLK_STATUS_HBI_BOOT;
-    status = VprocTwolfHbiWrite(CLK_STATUS_REG, 1, buf);
+    status = VprocTwolfHbiWrite(dev, CLK_STATUS_REG, 1, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         return VPROC_STATUS_ERR_HBI;
     }
     Vproc_msDelay(300); /*wait for reset to complete*/
 
     buf[0] = buf[1] = 0;
-    status = VprocTwolfHbiRead(HOST_CMD_PARAM_RESULT_REG, 1, buf);
+    status = VprocTwolfHbiRead(dev, HOST_CMD_PARAM_RESULT_REG, 1, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -552,30 +541,113 @@ VprocStatusType VprocTwolfHbiBoot_alt(twFirmware *st_firmware)
         DEBUG_LOGE(TAG_SPI, "ERROR: HBI is not accessible\n");
         return VPROC_STATUS_ERR_HBI;
     }
-    /*Transfer the image*/
-    status = HbiSrecBoot_alt(st_firmware);
-    if (status != VPROC_STATUS_SUCCESS) {
-        DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
-        return status;
-    }
+    return VPROC_STATUS_SUCCESS;
+}
 
+/* TwolfHbiBootComplete() tell the device that the image is loaded and
+ * check the result
+ */
+static VprocStatusType TwolfHbiBootComplete(VprocDev *dev)
+{
     /*tell Twolf that the firmware loading is complete*/
-    buf[0] = HOST_CMD_HOST_LOAD_CMP;
-    status = VprocTwolfcmdRegWr(buf[0]);
+    VprocStatusType status = VprocTwolfcmdRegWr(dev, HOST_CMD_HOST_LOAD_CMP);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
     }
 
     /*Verify whether the boot loading is successful*/
-    if (VprocTwolfCheckCmdResult() != VPROC_STATUS_SUCCESS) {
+    if (VprocTwolfCheckCmdResult(dev) != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR: Failed to load the Firmware...\n");
         return VPROC_STATUS_FW_LOAD_FAILED;
     }
-
     return VPROC_STATUS_SUCCESS;
 }
 
+/*VprocTwolfHbiBoot_alt - use this function to bootload the firmware
+ * into the device
+ * \param[in] pointer to image data structure
+ *
+ * \retval ::VPROC_STATUS_SUCCESS
+ * \retval ::VPROC_STATUS_ERR_HBI
+ * \retval ::VPROC_STATUS_MAILBOX_BUSY
+ */
+VprocStatusType VprocTwolfHbiBoot_alt(VprocDev *dev, twFirmware *st_firmware)
+{
+    VprocStatusType status = TwolfHbiBootEnter(dev);
+    if (status != VPROC_STATUS_SUCCESS) {
+        return status;
+    }
+    /*Transfer the image*/
+    status = HbiSrecBoot_alt(dev, st_firmware);
+    if (status != VPROC_STATUS_SUCCESS) {
+        DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
+        return status;
+    }
+    return TwolfHbiBootComplete(dev);
+}
+
+/*VprocTwolfHbiBootStream - use this function to bootload a compressed
+ * firmware image into the device. The image is decompressed block by block
+ * straight into the HBI burst, so neither the whole image nor the record
+ * array is needed in host memory
+ * \param[in] firmware stream opened by VprocFwStreamOpen()
+ *
+ * \retval ::VPROC_STATUS_SUCCESS
+ * \retval ::VPROC_STATUS_ERR_HBI
+ * \retval ::VPROC_STATUS_ERR_IMAGE
+ */
+VprocStatusType VprocTwolfHbiBootStream(VprocDev *dev, VprocFwStream *fw)
+{
+    uint16 buf[HBI_MAX_BURST_WORDS];
+    uint16 targetAddr[2];
+    uint32 addr = 0;
+    uint32 page = 0xFFFFFFFF;
+    unsigned char numwords = 0;
+    VprocStatusType status = TwolfHbiBootEnter(dev);
+    if (status != VPROC_STATUS_SUCCESS) {
+        return status;
+    }
+    VprocFwStreamRewind(fw);
+    while (1) {
+        status = VprocFwStreamRead(fw, &addr, buf, HBI_MAX_BURST_WORDS, &numwords);
+        if (status != VPROC_STATUS_SUCCESS) {
+            return status;
+        }
+        if (numwords == 0) {
+            break;
+        }
+        /*only move the page 255 window when the block is out of it*/
+        if ((addr >> 8) != page) {
+            page = addr >> 8;
+            targetAddr[0] = (uint16) ((addr & 0xFFFF0000) >> 16);
+            targetAddr[1] = (uint16) (addr & 0x0000FFFF);
+            status = VprocTwolfHbiWrite(dev, PAGE_255_BASE_HI_REG, 2, targetAddr);
+            if (status != VPROC_STATUS_SUCCESS) {
+                DEBUG_LOGE(TAG_SPI, "Unable to set target address 0x%08x\n", (unsigned) addr);
+                return VPROC_STATUS_ERR_HBI;
+            }
+        }
+        status = TwolfHbiPage255Write(dev, 0xFF, (uint8) (addr & 0x00FF), numwords, buf);
+        if (status != VPROC_STATUS_SUCCESS) {
+            DEBUG_LOGE(TAG_SPI, "status = %d, numWords = %d: \n", status, numwords);
+            return status;
+        }
+    }
+
+    /* program the program's execution start register */
+    targetAddr[0] = (uint16) ((fw->execAddr & 0xFFFF0000) >> 16);
+    targetAddr[1] = (uint16) (fw->execAddr & 0x0000FFFF);
+    status = VprocTwolfHbiWrite(dev, 0x12C, 2, targetAddr);
+    if (status != VPROC_STATUS_SUCCESS) {
+        DEBUG_LOGE(TAG_SPI, " unable to program page 1 execution address\n");
+        return status;
+    }
+    DEBUG_LOGI(TAG_SPI, "prgmBase 0x%08x\n", (unsigned) fw->prgmBase);
+    DEBUG_LOGI(TAG_SPI, "execAddr 0x%08x\n", (unsigned) fw->execAddr);
+    return TwolfHbiBootComplete(dev);
+}
+
 /*The following 3 functions provide a mean to loading the *.s3 firmare into
  * the device
  * - Call sequence:
@@ -587,7 +659,7 @@ VprocStatusType VprocTwolfHbiBoot_alt(twFirmware *st_firmware)
  * 3- Call VprocTwolfHbiBootConclude() once the whole data is transferred suc-
  * cessfully
  */
-VprocStatusType VprocTwolfHbiBootPrepare(void)
+VprocStatusType VprocTwolfHbiBootPrepare(VprocDev *dev)
 {
     unsigned short buf[2] = {0, 0};
     VprocStatusType status = VPROC_STATUS_SUCCESS;
@@ -595,14 +667,14 @@ VprocStatusType VprocTwolfHbiBootPrepare(void)
      * to stop current firmware, reset the device into the Boot Rom mode.
      */
     buf[0] = 1; // TWOLF_CLK_STATUS_HBI_BOOT;
-    status = VprocTwolfHbiWrite(CLK_STATUS_REG, 1, buf);
+    status = VprocTwolfHbiWrite(dev, CLK_STATUS_REG, 1, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         return VPROC_STATUS_ERR_HBI;
     }
     Vproc_msDelay(300); /*wait for reset to complete*/
 
     buf[0] = buf[1] = 0;
-    status = VprocTwolfHbiRead(HOST_CMD_PARAM_RESULT_REG, 1, buf);
+    status = VprocTwolfHbiRead(dev, HOST_CMD_PARAM_RESULT_REG, 1, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -643,7 +715,7 @@ static unsigned int AsciiHexToHex(const char *str, unsigned char len)
     }
     return val;
 }
-static int spisTwBootWrite(char *blockOfFwrData) /*0: HBI; 1:FLASH*/
+static int spisTwBootWrite(VprocDev *dev, char *blockOfFwrData) /*0: HBI; 1:FLASH*/
 {
     /*Use this method to load the actual *.s3 file line by line*/
     int status = 0;
@@ -695,7 +767,7 @@ static int spisTwBootWrite(char *blockOfFwrData) /*0: HBI; 1:FLASH*/
         DEBUG_LOGI(TAG_SPI, "execAddr = 0x%08lx\n", address);
         /* program the program's execution start register */
         // status = spis_tw_hbi_multi_wr8(0x012C, 4, buf);
-        status = VprocTwolfHbiWrite(0x12C, 2, gTargetAddr);
+        status = VprocTwolfHbiWrite(dev, 0x12C, 2, gTargetAddr);
 
         if (status != 0) {
             DEBUG_LOGE(TAG_SPI, " unable to program page 1 execution address\n");
@@ -708,7 +780,7 @@ static int spisTwBootWrite(char *blockOfFwrData) /*0: HBI; 1:FLASH*/
     /* put the address into our global target addr */
 
     // DEBUG_LOGE(TAG_SPI, "gTargetAddr = 0x%08lx: \n", address);
-    status = VprocTwolfHbiWrite(PAGE_255_BASE_HI_REG, 2, gTargetAddr);
+    status = VprocTwolfHbiWrite(dev, PAGE_255_BASE_HI_REG, 2, gTargetAddr);
     // status = spis_tw_hbi_multi_wr8(PAGE_255_BASE_HI_REG, 4, buf);
     if (status != 0) {
         DEBUG_LOGE(TAG_SPI, "gTargetAddr = 0x%08lx: \n", address);
@@ -725,7 +797,7 @@ static int spisTwBootWrite(char *blockOfFwrData) /*0: HBI; 1:FLASH*/
     }
     /* write the data to the device */
     cmd = (uint16) (0xFF << 8) | (uint16) page255Offset;
-    status = VprocTwolfHbiWrite(cmd, numdataWordPerLine, dataBuf);
+    status = VprocTwolfHbiWrite(dev, cmd, numdataWordPerLine, dataBuf);
     if (status != 0) {
         return status;
     }
@@ -734,27 +806,27 @@ static int spisTwBootWrite(char *blockOfFwrData) /*0: HBI; 1:FLASH*/
     return TWOLF_STATUS_NEED_MORE_DATA; /*REQUEST STATUS_MORE_DATA*/
 }
 
-VprocStatusType VprocTwolfHbiBootMoreData(char *dataBlock)
+VprocStatusType VprocTwolfHbiBootMoreData(VprocDev *dev, char *dataBlock)
 {
     // return ioctl(twolf_fd, TWOLF_BOOT_SEND_MORE_DATA, dataBlock);
-    return spisTwBootWrite(dataBlock);
+    return spisTwBootWrite(dev, dataBlock);
 }
 
-VprocStatusType VprocTwolfHbiBootConclude(void)
+VprocStatusType VprocTwolfHbiBootConclude(VprocDev *dev)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short buf;
 
     /*tell Twolf that the firmware loading is complete*/
     buf = HOST_CMD_HOST_LOAD_CMP;
-    status = VprocTwolfcmdRegWr(buf);
+    status = VprocTwolfcmdRegWr(dev, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
     }
 
     /*Verify whether the boot loading is successful*/
-    if (VprocTwolfCheckCmdResult() != VPROC_STATUS_SUCCESS) {
+    if (VprocTwolfCheckCmdResult(dev) != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR: Failed to load the Firmware...\n");
         return VPROC_STATUS_FW_LOAD_FAILED;
     }
@@ -763,13 +835,13 @@ VprocStatusType VprocTwolfHbiBootConclude(void)
 }
 
 /*USe this function to erase a slave flash device controlled by the Twolf*/
-VprocStatusType VprocTwolfEraseFlash(void)
+VprocStatusType VprocTwolfEraseFlash(VprocDev *dev)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short buf;
     /*Save firmware to flash*/
 
-    status = VprocTwolfReset(VPROC_RST_HARDWARE_RAM);
+    status = VprocTwolfReset(dev, VPROC_RST_HARDWARE_RAM);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -777,14 +849,14 @@ VprocStatusType VprocTwolfEraseFlash(void)
 
     buf = HOST_CMD_HOST_FLASH_INIT;
     /*if there is a flash on board initialize it*/
-    status = VprocTwolfcmdRegWr(buf);
+    status = VprocTwolfcmdRegWr(dev, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
     }
 
     buf = 0xAA55;
-    status = VprocTwolfHbiWrite(HOST_CMD_PARAM_RESULT_REG, 1, &buf);
+    status = VprocTwolfHbiWrite(dev, HOST_CMD_PARAM_RESULT_REG, 1, &buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "Unable to set command reg = 0x%04x: \n", buf);
         return VPROC_STATUS_ERR_HBI;
@@ -792,7 +864,7 @@ VprocStatusType VprocTwolfEraseFlash(void)
 
     buf = 0x0009;
     /*delete all applications on flash*/
-    status = VprocTwolfcmdRegWr(buf);
+    status = VprocTwolfcmdRegWr(dev, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -807,7 +879,7 @@ VprocStatusType VprocTwolfEraseFlash(void)
  *         VPROC_RST_HARDWARE_ROM, VPROC_RST_SOFT, VPROC_RST_AEC)
  * Return: (VprocStatusType) type error code (0 = success, else= fail)
  */
-VprocStatusType VprocTwolfReset(VprocResetMode mode)
+VprocStatusType VprocTwolfReset(VprocDev *dev, VprocResetMode mode)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short buf;
@@ -815,7 +887,7 @@ VprocStatusType VprocTwolfReset(VprocResetMode mode)
     if (mode == VPROC_RST_HARDWARE_RAM) { /*hard reset*/
         /*hard reset*/
         buf = 0x05;
-        status = VprocTwolfHbiWrite(0x014, 1, &buf);
+        status = VprocTwolfHbiWrite(dev, 0x014, 1, &buf);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
             return status;
@@ -823,21 +895,21 @@ VprocStatusType VprocTwolfReset(VprocResetMode mode)
     } else if (mode == VPROC_RST_HARDWARE_ROM) { /*power on reset*/
         /*hard reset*/
         buf = 0x09;
-        status = VprocTwolfHbiWrite(0x014, 1, &buf);
+        status = VprocTwolfHbiWrite(dev, 0x014, 1, &buf);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
             return status;
         }
     } else if (mode == VPROC_RST_AEC) { /*AEC method*/
         buf = 0x01;
-        status = VprocTwolfHbiWrite(0x0300, 1, &buf);
+        status = VprocTwolfHbiWrite(dev, 0x0300, 1, &buf);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
             return status;
         }
     } else if (mode == VPROC_RST_SOFTWARE) { /*soft reset*/
         buf = 0x02;
-        status = VprocTwolfHbiWrite(0x006, 1, &buf);
+        status = VprocTwolfHbiWrite(dev, 0x006, 1, &buf);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
             return status;
@@ -850,18 +922,18 @@ VprocStatusType VprocTwolfReset(VprocResetMode mode)
     return VPROC_STATUS_SUCCESS;
 }
 
-VprocStatusType VprocTwolfSetVolume(uint8 vol)
+VprocStatusType VprocTwolfSetVolume(VprocDev *dev, uint8 vol)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short buf = vol;         // Gain A
     buf += (unsigned short) vol << 8; // Gain B
-    VprocHALInit();
-    status = VprocTwolfHbiWrite(0x238, 1, &buf);
+    VprocHALInit(dev);
+    status = VprocTwolfHbiWrite(dev, 0x238, 1, &buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
     }
-    status = VprocTwolfHbiWrite(0x23A, 1, &buf);
+    status = VprocTwolfHbiWrite(dev, 0x23A, 1, &buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -869,12 +941,12 @@ VprocStatusType VprocTwolfSetVolume(uint8 vol)
     return status;
 }
 
-VprocStatusType VprocTwolfGetVolume(int8_t *vol)
+VprocStatusType VprocTwolfGetVolume(VprocDev *dev, int8_t *vol)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     unsigned short buf = 0;
-    VprocHALInit();
-    status = VprocTwolfHbiRead(0x238, 1, &buf);
+    VprocHALInit(dev);
+    status = VprocTwolfHbiRead(dev, 0x238, 1, &buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -883,12 +955,12 @@ VprocStatusType VprocTwolfGetVolume(int8_t *vol)
     return status;
 }
 
-VprocStatusType VprocTwolfGetAppStatus(uint16 *status)
+VprocStatusType VprocTwolfGetAppStatus(VprocDev *dev, uint16 *status)
 {
     VprocStatusType ret = VPROC_STATUS_SUCCESS;
     unsigned short buf = 0;
-    VprocHALInit();
-    ret = VprocTwolfHbiRead(0x030, 1, &buf);
+    VprocHALInit(dev);
+    ret = VprocTwolfHbiRead(dev, 0x030, 1, &buf);
     if (ret != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", ret);
         return ret;
@@ -913,7 +985,7 @@ VprocStatusType VprocTwolfGetAppStatus(uint16 *status)
  * Input Argument: None
  * Return: (VprocStatusType) type error code (0 = success, else= fail)
  */
-VprocStatusType VprocTwolfSaveImgToFlash(void)
+VprocStatusType VprocTwolfSaveImgToFlash(VprocDev *dev)
 {
     unsigned short buf;
     VprocStatusType status = VPROC_STATUS_SUCCESS;
@@ -921,14 +993,14 @@ VprocStatusType VprocTwolfSaveImgToFlash(void)
 
     buf = HOST_CMD_HOST_FLASH_INIT;
     /*if there is a flash on board initialize it*/
-    status = VprocTwolfcmdRegWr(buf);
+    status = VprocTwolfcmdRegWr(dev, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
     }
 
     buf = 0xAA55;
-    status = VprocTwolfHbiWrite(HOST_CMD_PARAM_RESULT_REG, 1, &buf);
+    status = VprocTwolfHbiWrite(dev, HOST_CMD_PARAM_RESULT_REG, 1, &buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "Unable to set command reg = 0x%04x: \n", buf);
         return VPROC_STATUS_ERR_HBI;
@@ -936,7 +1008,7 @@ VprocStatusType VprocTwolfSaveImgToFlash(void)
 
     buf = 0x0009;
     /*delete all applications on flash*/
-    status = VprocTwolfcmdRegWr(buf);
+    status = VprocTwolfcmdRegWr(dev, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -944,13 +1016,13 @@ VprocStatusType VprocTwolfSaveImgToFlash(void)
 
     buf = HOST_CMD_IMG_CFG_SAVE;
     /*save the   image to flash*/
-    status = VprocTwolfcmdRegWr(buf);
+    status = VprocTwolfcmdRegWr(dev, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "Save firmware to flash failed... reg = 0x%04x: \n", buf);
         return VPROC_STATUS_ERR_HBI;
     }
     /*check whethe the actions above were performed successfully*/
-    return VprocTwolfCheckCmdResult();
+    return VprocTwolfCheckCmdResult(dev);
 }
 
 /* VprocTwolfSaveCfgToFlash(): use this function to
@@ -963,7 +1035,7 @@ VprocStatusType VprocTwolfSaveImgToFlash(void)
  * The firmware must be stopped first with VprocTwolfFirmwareStop()
  */
 
-VprocStatusType VprocTwolfSaveCfgToFlash(void)
+VprocStatusType VprocTwolfSaveCfgToFlash(VprocDev *dev)
 {
     unsigned short buf;
     VprocStatusType status = VPROC_STATUS_SUCCESS;
@@ -978,14 +1050,14 @@ VprocStatusType VprocTwolfSaveCfgToFlash(void)
     buf = HOST_CMD_HOST_FLASH_INIT;
 
     /*if there is a flash on the board initialize it*/
-    status = VprocTwolfcmdRegWr(buf);
+    status = VprocTwolfcmdRegWr(dev, buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
     }
 
     /*Check if there is a flash device and an image already saved to it - load it to RAM*/
-    status = VprocTwolfHbiRead(0x026, 1, &buf);
+    status = VprocTwolfHbiRead(dev, 0x026, 1, &buf);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
         return status;
@@ -993,13 +1065,13 @@ VprocStatusType VprocTwolfSaveCfgToFlash(void)
     if ((buf > 0)) {
         /*load the corresponding image/cr from flash*/
         buf = 0x0001;
-        status = VprocTwolfHbiWrite(HOST_CMD_PARAM_RESULT_REG, 1, &buf);
+        status = VprocTwolfHbiWrite(dev, HOST_CMD_PARAM_RESULT_REG, 1, &buf);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "Unable to set command reg = 0x%04x: \n", buf);
             return VPROC_STATUS_ERR_HBI;
         }
         buf = 0x8002;
-        status = VprocTwolfHbiWrite(HOST_CMD_REG, 1, &buf);
+        status = VprocTwolfHbiWrite(dev, HOST_CMD_REG, 1, &buf);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "Unable to set command reg = 0x%04x: \n", buf);
             return VPROC_STATUS_ERR_HBI;
@@ -1008,20 +1080,20 @@ VprocStatusType VprocTwolfSaveCfgToFlash(void)
         /*Release the command reg*/
         /*read the Host Command register*/
         buf = 0x0004;
-        status = VprocTwolfHbiWrite(HOST_SW_FLAGS_REG, 1, &buf);
+        status = VprocTwolfHbiWrite(dev, HOST_SW_FLAGS_REG, 1, &buf);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
             return status;
         }
 
-        status = VprocTwolfcmdRegAcquire(HOST_CMD_IDLE, TWOLF_MAILBOX_SPINWAIT);
+        status = VprocTwolfcmdRegAcquire(dev, HOST_CMD_IDLE, TWOLF_MAILBOX_SPINWAIT);
         if ((status != VPROC_STATUS_SUCCESS)) {
             DEBUG_LOGE(TAG_SPI, "ERROR %d: CMD_REG - Operation is not complete\n", status);
             return status;
         }
 
         /*Verify wheter the operation completed sucessfully*/
-        status = VprocTwolfCheckCmdResult();
+        status = VprocTwolfCheckCmdResult(dev);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "Error %d: Unable to verify result-param: \n", status);
             return status;
@@ -1031,6 +1103,71 @@ VprocStatusType VprocTwolfSaveCfgToFlash(void)
     return VPROC_STATUS_SUCCESS;
 }
 
+/* VprocTwolfReadRam(): use this function to read words from the device RAM
+ *     through the page 255 window, e.g. to verify a loaded firmware block
+ *
+ * Input Argument: addr - the RAM address as used in the firmware records
+ *                 numwords - the number of words to read
+ * Return: (VprocStatusType) type error code (0 = success, else= fail)
+ */
+VprocStatusType VprocTwolfReadRam(VprocDev *dev, uint32 addr, unsigned char numwords, unsigned short *pData)
+{
+    uint16 targetAddr[2];
+    VprocStatusType status;
+    targetAddr[0] = (uint16) ((addr & 0xFFFF0000) >> 16);
+    targetAddr[1] = (uint16) (addr & 0x0000FFFF);
+    status = VprocTwolfHbiWrite(dev, PAGE_255_BASE_HI_REG, 2, targetAddr);
+    if (status != VPROC_STATUS_SUCCESS) {
+        return status;
+    }
+    return VprocTwolfHbiRead(dev, (uint16) (0xFF << 8) | (targetAddr[1] & 0x00FF), numwords, pData);
+}
+
+/* VprocTwolfLoadFwrCfgFromFlash(): use this function to
+ *     load a firmware image and its config record previously saved to the
+ *     slave flash into the device RAM. The device must be in boot mode.
+ *
+ * Input Argument: image_number - the index (1 based) of the image in flash
+ * Return: (VprocStatusType) type error code (0 = success, else= fail)
+ */
+VprocStatusType VprocTwolfLoadFwrCfgFromFlash(VprocDev *dev, uint16 image_number)
+{
+    unsigned short buf;
+    VprocStatusType status = VPROC_STATUS_SUCCESS;
+
+    /*if there is a flash on the board initialize it*/
+    status = VprocTwolfcmdRegWr(dev, HOST_CMD_HOST_FLASH_INIT);
+    if (status != VPROC_STATUS_SUCCESS) {
+        DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
+        return status;
+    }
+    /*number of images saved in flash*/
+    status = VprocTwolfHbiRead(dev, 0x026, 1, &buf);
+    if (status != VPROC_STATUS_SUCCESS) {
+        DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
+        return status;
+    }
+    if ((image_number == 0) || (buf < image_number)) {
+        DEBUG_LOGI(TAG_SPI, "No image %d in flash, total %d\n", image_number, buf);
+        return VPROC_STATUS_FW_LOAD_FAILED;
+    }
+    status = VprocTwolfHbiWrite(dev, HOST_CMD_PARAM_RESULT_REG, 1, &image_number);
+    if (status != VPROC_STATUS_SUCCESS) {
+        DEBUG_LOGE(TAG_SPI, "Unable to set command param = 0x%04x: \n", image_number);
+        return VPROC_STATUS_ERR_HBI;
+    }
+    status = VprocTwolfcmdRegWr(dev, HOST_CMD_IMG_CFG_LOAD);
+    if (status != VPROC_STATUS_SUCCESS) {
+        DEBUG_LOGE(TAG_SPI, "ERROR %d: \n", status);
+        return status;
+    }
+    if (VprocTwolfCheckCmdResult(dev) != VPROC_STATUS_SUCCESS) {
+        DEBUG_LOGE(TAG_SPI, "ERROR: Failed to load image %d from flash\n", image_number);
+        return VPROC_STATUS_FW_LOAD_FAILED;
+    }
+    return VPROC_STATUS_SUCCESS;
+}
+
 /*VprocTwolfFirmwareStart - use this function to start/restart the firmware
  * previously stopped with VprocTwolfFirmwareStop()
  * \param[in] none
@@ -1038,13 +1175,13 @@ VprocStatusType VprocTwolfSaveCfgToFlash(void)
  * \retval ::VPROC_STATUS_SUCCESS
  * \retval ::VPROC_STATUS_ERR_HBI
  */
-VprocStatusType VprocTwolfFirmwareStart(void)
+VprocStatusType VprocTwolfFirmwareStart(VprocDev *dev)
 {
     unsigned short buf;
 
     /*Start firmware*/
     buf = HOST_CMD_FWR_GO;
-    return VprocTwolfcmdRegWr(buf);
+    return VprocTwolfcmdRegWr(dev, buf);
 }
 
 /*VprocTwolfFirmwareStop - use this function to stop the firmware currently running
@@ -1054,11 +1191,11 @@ VprocStatusType VprocTwolfFirmwareStart(void)
  * \retval ::VPROC_STATUS_SUCCESS
  * \retval ::VPROC_STATUS_ERR_HBI
  */
-VprocStatusType VprocTwolfFirmwareStop(void)
+VprocStatusType VprocTwolfFirmwareStop(VprocDev *dev)
 {
     unsigned short buf;
 
     /*Stop firmware*/
     buf = HOST_CMD_FWR_STOP;
-    return VprocTwolfcmdRegWr(buf);
+    return VprocTwolfcmdRegWr(dev, buf);
 }
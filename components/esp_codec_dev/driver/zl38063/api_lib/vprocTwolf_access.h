@@ -29,6 +29,7 @@
 #define VPROC_TWOLFACCESS_H
 
 #include "vproc_common.h"
+#include "vproc_fw_stream.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,17 +46,19 @@ typedef struct hbiCmdInfo {
 
 /* external function prototypes */
 
-VprocStatusType VprocTwolfHbiInit(void); /*Use this function to initialize the HBI bus*/
+VprocStatusType VprocTwolfHbiInit(VprocDev *dev); /*Use this function to initialize the HBI bus*/
 
-VprocStatusType VprocTwolfHbiRead(unsigned short cmd,     /*the 16-bit register to read from*/
+VprocStatusType VprocTwolfHbiRead(VprocDev *dev,         /*the device context*/
+                                  unsigned short cmd,     /*the 16-bit register to read from*/
                                   unsigned char numwords, /* The number of 16-bit words to read*/
                                   unsigned short *pData); /* Pointer to the read data buffer*/
 
-VprocStatusType VprocTwolfHbiWrite(unsigned short cmd,     /*the 16-bit register to write to*/
+VprocStatusType VprocTwolfHbiWrite(VprocDev *dev,         /*the device context*/
+                                   unsigned short cmd,     /*the 16-bit register to write to*/
                                    unsigned char numwords, /* The number of 16-bit words to write*/
                                    unsigned short *pData); /*the words (0-255) to write*/
 
-VprocStatusType TwolfHbiNoOp(                         /*send no-op command to the device*/
+VprocStatusType TwolfHbiNoOp(VprocDev *dev,           /*send no-op command to the device*/
                              unsigned char numWords); /* The number of no-op (0-255) to write*/
 
 /*An alternative method to loading the firmware into the device
@@ -64,24 +67,33 @@ VprocStatusType TwolfHbiNoOp(                         /*send no-op command to th
  */
 VprocStatusType
 VprocTwolfHbiBoot_alt(/*use this function to boot load the firmware (*.c) from the host to the device RAM*/
+                      VprocDev *dev,            /*the device context*/
                       twFirmware *st_firmware); /*Pointer to the firmware image in host RAM*/
 
-VprocStatusType VprocTwolfLoadConfig(dataArr *pCr2Buf, unsigned short numElements);
+/*Boot load a compressed firmware image (see tools/zl38063_fw_pack.py), decompressing
+ * it straight into the HBI bursts
+ */
+VprocStatusType VprocTwolfHbiBootStream(VprocDev *dev,      /*the device context*/
+                                        VprocFwStream *fw); /*opened firmware stream*/
+
+VprocStatusType VprocTwolfLoadConfig(VprocDev *dev, dataArr *pCr2Buf, unsigned short numElements);
 
-VprocStatusType VprocTwolfHbiCleanup(void);
-VprocStatusType VprocTwolfHbiBootPrepare(void);
-VprocStatusType VprocTwolfHbiBootMoreData(char *dataBlock);
-VprocStatusType VprocTwolfHbiBootConclude(void);
-VprocStatusType VprocTwolfFirmwareStop(void);   /*Use this function to halt the currently running firmware*/
-VprocStatusType VprocTwolfFirmwareStart(void);  /*Use this function to start/restart the firmware currently in RAM*/
-VprocStatusType VprocTwolfSaveImgToFlash(void); /*Save current loaded firmware from device RAM to FLASH*/
-VprocStatusType VprocTwolfSaveCfgToFlash(void); /*Save current device config from device RAM to FLASH*/
-VprocStatusType VprocTwolfReset(VprocResetMode mode);
-VprocStatusType VprocTwolfEraseFlash(void);
-VprocStatusType VprocTwolfLoadFwrCfgFromFlash(uint16 image_number);
-VprocStatusType VprocTwolfSetVolume(uint8 vol);
-VprocStatusType VprocTwolfGetVolume(int8_t *vol);
-VprocStatusType VprocTwolfGetAppStatus(uint16 *status);
+VprocStatusType VprocTwolfHbiCleanup(VprocDev *dev);
+VprocStatusType VprocTwolfHbiBootPrepare(VprocDev *dev);
+VprocStatusType VprocTwolfHbiBootMoreData(VprocDev *dev, char *dataBlock);
+VprocStatusType VprocTwolfHbiBootConclude(VprocDev *dev);
+VprocStatusType VprocTwolfFirmwareStop(VprocDev *dev);   /*Use this function to halt the currently running firmware*/
+VprocStatusType VprocTwolfFirmwareStart(VprocDev *dev);  /*Use this function to start/restart the firmware in RAM*/
+VprocStatusType VprocTwolfSaveImgToFlash(VprocDev *dev); /*Save current loaded firmware from device RAM to FLASH*/
+VprocStatusType VprocTwolfSaveCfgToFlash(VprocDev *dev); /*Save current device config from device RAM to FLASH*/
+VprocStatusType VprocTwolfReset(VprocDev *dev, VprocResetMode mode);
+VprocStatusType VprocTwolfEraseFlash(VprocDev *dev);
+VprocStatusType VprocTwolfLoadFwrCfgFromFlash(VprocDev *dev, uint16 image_number);
+VprocStatusType VprocTwolfReadRam(VprocDev *dev, uint32 addr, unsigned char numwords, unsigned short *pData);
+VprocStatusType VprocTwolfSetVolume(VprocDev *dev, uint8 vol);
+VprocStatusType VprocTwolfGetVolume(VprocDev *dev, int8_t *vol);
+VprocStatusType VprocTwolfGetAppStatus(VprocDev *dev, uint16 *status);
+VprocStatusType VprocTwolfGetCmdStats(VprocDev *dev, VprocCmdStats *stats, int reset);
 
 #ifdef __cplusplus
 }
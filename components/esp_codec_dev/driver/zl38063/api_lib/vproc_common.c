@@ -12,16 +12,16 @@
 #include "vproc_common.h"
 #include "codec_dev_os.h"
 #include "audio_codec_ctrl_if.h"
+#include "codec_dev_utils.h"
+#include "codec_dev_gpio.h"
 
 /*Note - These functions are PLATFORM SPECIFIC- They must be modified
  *       accordingly
  **********************************************************************/
 
-static audio_codec_ctrl_if_t *vproc_ctrl_if;
-
-void VprocSetCtrlIf(void *ctrl_if)
+void VprocSetCtrlIf(VprocDev *dev, const void *ctrl_if)
 {
-    vproc_ctrl_if = (audio_codec_ctrl_if_t *) ctrl_if;
+    dev->ctrl_if = (const audio_codec_ctrl_if_t *) ctrl_if;
 }
 
 static uint16_t convert_edian(uint16_t v)
@@ -29,13 +29,13 @@ static uint16_t convert_edian(uint16_t v)
     return (v >> 8) | ((v & 0xFF) << 8);
 }
 
-void VprocHALcleanup(void)
+void VprocHALcleanup(VprocDev *dev)
 {
 }
 
-int VprocHALInit(void)
+int VprocHALInit(VprocDev *dev)
 {
-    if (vproc_ctrl_if) {
+    if (dev->ctrl_if) {
         return 0;
     }
     return -1;
@@ -57,29 +57,102 @@ void VprocWait(unsigned long int time)
     codec_dev_sleep(time);
 }
 
+/* VprocWaitUs(): busy wait for short polling interval in micro-seconds
+ */
+void VprocWaitUs(unsigned int time)
+{
+    codec_dev_delay_us((int) time);
+}
+
+/* VprocGetTimeUs(): get current time in micro-seconds for latency measurement
+ */
+uint64_t VprocGetTimeUs(void)
+{
+    return codec_dev_get_time_us();
+}
+
+/* Set the host GPIO connected to the device interrupt pin (active low)
+ * Set to -1 if the interrupt pin is not connected
+ */
+void VprocSetIrqPin(VprocDev *dev, int16_t pin)
+{
+    const audio_codec_gpio_if_t *gpio_if = audio_codec_get_gpio_if();
+    dev->irq_pin = -1;
+    if (pin >= 0 && gpio_if) {
+        gpio_if->setup(pin, AUDIO_GPIO_DIR_IN, AUDIO_GPIO_MODE_PULL_UP);
+        dev->irq_pin = pin;
+    }
+}
+
+/* Check the device interrupt pin without bus access
+ * Return: 1 - asserted, 0 - not asserted, -1 - interrupt pin not used
+ */
+int VprocHALIrqAsserted(VprocDev *dev)
+{
+    const audio_codec_gpio_if_t *gpio_if = audio_codec_get_gpio_if();
+    if (dev->irq_pin < 0 || gpio_if == NULL) {
+        return -1;
+    }
+    return gpio_if->get(dev->irq_pin) ? 0 : 1;
+}
+
 /* This is the platform dependent low level spi
  * function to write 16-bit data to the ZL380xx device
  */
-int VprocHALWrite(unsigned short val)
+int VprocHALWrite(VprocDev *dev, unsigned short val)
 {
     int ret = 0;
-    if (vproc_ctrl_if) {
+    if (dev->ctrl_if) {
         val = convert_edian(val);
-        ret = vproc_ctrl_if->write_addr(vproc_ctrl_if, 0, 0, &val, sizeof(val));
+        ret = dev->ctrl_if->write_addr(dev->ctrl_if, 0, 0, &val, sizeof(val));
+    }
+    return ret;
+}
+
+/* Pack HBI command words into address of control interface
+ * First word goes out in command phase and second one in address phase
+ */
+static int VprocHALPackCmd(const unsigned short *pCmd, int cmdNum)
+{
+    int addr = 0;
+    unsigned short *words = (unsigned short *) &addr;
+    for (int i = 0; i < cmdNum; i++) {
+        words[i] = convert_edian(pCmd[i]);
+    }
+    return addr;
+}
+
+/* This is the platform dependent low level spi
+ * function to write up to 2 HBI command words followed by 16-bit data words
+ * to the ZL380xx device in one transaction
+ * The words in pVal are converted into bus byte order in place
+ */
+int VprocHALWriteCmd(VprocDev *dev, const unsigned short *pCmd, int cmdNum, unsigned short *pVal, int num)
+{
+    int ret = 0;
+    if (dev->ctrl_if) {
+        for (int i = 0; i < num; i++) {
+            pVal[i] = convert_edian(pVal[i]);
+        }
+        ret = dev->ctrl_if->write_addr(dev->ctrl_if, VprocHALPackCmd(pCmd, cmdNum), cmdNum * sizeof(unsigned short),
+                                       pVal, num * sizeof(unsigned short));
     }
     return ret;
 }
 
 /* This is the platform dependent low level spi
- * function to read 16-bit data from the ZL380xx device
+ * function to write up to 2 HBI command words and read 16-bit data words
+ * from the ZL380xx device in one transaction
  */
-int VprocHALRead(unsigned short *pVal)
+int VprocHALReadCmd(VprocDev *dev, const unsigned short *pCmd, int cmdNum, unsigned short *pVal, int num)
 {
-    unsigned short data = 0;
     int ret = 0;
-    if (vproc_ctrl_if) {
-        ret = vproc_ctrl_if->read_addr(vproc_ctrl_if, 0, 0, &data, sizeof(data));
-        *pVal = convert_edian(data);
+    if (dev->ctrl_if) {
+        ret = dev->ctrl_if->read_addr(dev->ctrl_if, VprocHALPackCmd(pCmd, cmdNum), cmdNum * sizeof(unsigned short),
+                                      pVal, num * sizeof(unsigned short));
+        for (int i = 0; i < num; i++) {
+            pVal[i] = convert_edian(pVal[i]);
+        }
     }
     return ret;
 }
@@ -15,7 +15,9 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include "esp_log.h"
+#include "audio_codec_ctrl_if.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -109,13 +111,34 @@ typedef enum vProcDeviceType {
     VPROC_DEV_TIMBERWOLF = 2 /*Timberwolf: ZL38040*/
 } VprocDeviceType;
 
-extern void VprocSetCtrlIf(void *ctrl_if);
-extern void VprocHALcleanup(void);
-extern int VprocHALInit(void);
+/*host command latency statistics*/
+typedef struct VprocCmdStats {
+    uint32_t cmd_count;     /*number of host commands issued*/
+    uint32_t timeout_count; /*number of commands not completed in time*/
+    uint32_t poll_count;    /*number of status register reads while waiting*/
+    uint32_t max_wait_us;   /*maximum command latency*/
+    uint64_t total_wait_us; /*sum of command latency*/
+} VprocCmdStats;
+
+/*device context, one per device so that several devices can be driven concurrently*/
+typedef struct VprocDev {
+    const audio_codec_ctrl_if_t *ctrl_if;   /*control interface to access the device*/
+    int16_t                      irq_pin;   /*host GPIO connected to the device interrupt pin, -1 if not used*/
+    VprocCmdStats                cmd_stats; /*host command latency statistics*/
+} VprocDev;
+
+extern void VprocSetCtrlIf(VprocDev *dev, const void *ctrl_if);
+extern void VprocHALcleanup(VprocDev *dev);
+extern int VprocHALInit(VprocDev *dev);
 extern void Vproc_msDelay(unsigned short time);
 extern void VprocWait(unsigned long int time);
-extern int VprocHALWrite(unsigned short val);
-extern int VprocHALRead(unsigned short *pVal);
+extern void VprocWaitUs(unsigned int time);
+extern uint64_t VprocGetTimeUs(void);
+extern void VprocSetIrqPin(VprocDev *dev, int16_t pin);
+extern int VprocHALIrqAsserted(VprocDev *dev);
+extern int VprocHALWrite(VprocDev *dev, unsigned short val);
+extern int VprocHALWriteCmd(VprocDev *dev, const unsigned short *pCmd, int cmdNum, unsigned short *pVal, int num);
+extern int VprocHALReadCmd(VprocDev *dev, const unsigned short *pCmd, int cmdNum, unsigned short *pVal, int num);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,226 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include "vproc_fw_stream.h"
+
+#define FW_STREAM_MAGIC       "ZLFZ"
+#define FW_STREAM_VERSION     1
+#define FW_STREAM_HEADER_SIZE 32
+#define FW_STREAM_MIN_MATCH   4
+#define FW_STREAM_SEG_HDR     6   /*u32 target address + u16 number of words*/
+#define FW_STREAM_PAGE_SIZE   256 /*bytes accessible through the page 255 window*/
+
+#define GET_LE16(p)           ((uint16) ((p)[0] | ((p)[1] << 8)))
+#define GET_LE32(p)           ((uint32) ((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32) (p)[3] << 24)))
+
+/*CRC32 (IEEE 802.3, same as zlib) using a 16 entries table*/
+static const uint32 crc32_nibble_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+static uint32 fw_stream_crc_byte(uint32 crc, uint8 c)
+{
+    crc ^= c;
+    crc = (crc >> 4) ^ crc32_nibble_table[crc & 0x0F];
+    crc = (crc >> 4) ^ crc32_nibble_table[crc & 0x0F];
+    return crc;
+}
+
+static VprocStatusType fw_stream_src_byte(VprocFwStream *s, uint8 *c)
+{
+    if (s->srcPos >= s->srcLen) {
+        DEBUG_LOGE(TAG_SPI, "Firmware image truncated at %d\n", (int) s->srcPos);
+        return VPROC_STATUS_ERR_IMAGE;
+    }
+    *c = s->src[s->srcPos++];
+    return VPROC_STATUS_SUCCESS;
+}
+
+/*read the extension bytes of a literal or match length*/
+static VprocStatusType fw_stream_src_length(VprocFwStream *s, uint32 *len)
+{
+    uint8 c;
+    do {
+        if (fw_stream_src_byte(s, &c) != VPROC_STATUS_SUCCESS) {
+            return VPROC_STATUS_ERR_IMAGE;
+        }
+        *len += c;
+    } while (c == 255);
+    return VPROC_STATUS_SUCCESS;
+}
+
+/*parse the next token or match offset until there are bytes to output*/
+static VprocStatusType fw_stream_next_sequence(VprocFwStream *s)
+{
+    uint8 c[2];
+    while (s->litLeft == 0 && s->matchLeft == 0) {
+        if (s->matchPending) {
+            if (fw_stream_src_byte(s, &c[0]) != VPROC_STATUS_SUCCESS ||
+                fw_stream_src_byte(s, &c[1]) != VPROC_STATUS_SUCCESS) {
+                return VPROC_STATUS_ERR_IMAGE;
+            }
+            s->matchOff = GET_LE16(c);
+            s->matchLeft = s->token & 0x0F;
+            if (s->matchLeft == 15 && fw_stream_src_length(s, &s->matchLeft) != VPROC_STATUS_SUCCESS) {
+                return VPROC_STATUS_ERR_IMAGE;
+            }
+            s->matchLeft += FW_STREAM_MIN_MATCH;
+            s->matchPending = 0;
+            if (s->matchOff == 0 || s->matchOff > s->windowMask + 1 || s->matchOff > s->rawPos) {
+                DEBUG_LOGE(TAG_SPI, "Bad match offset %d at %d\n", (int) s->matchOff, (int) s->rawPos);
+                return VPROC_STATUS_ERR_IMAGE;
+            }
+        } else {
+            if (fw_stream_src_byte(s, &s->token) != VPROC_STATUS_SUCCESS) {
+                return VPROC_STATUS_ERR_IMAGE;
+            }
+            s->litLeft = s->token >> 4;
+            if (s->litLeft == 15 && fw_stream_src_length(s, &s->litLeft) != VPROC_STATUS_SUCCESS) {
+                return VPROC_STATUS_ERR_IMAGE;
+            }
+            s->matchPending = 1;
+        }
+    }
+    return VPROC_STATUS_SUCCESS;
+}
+
+/*decompress len bytes of the raw stream into dst*/
+static VprocStatusType fw_stream_get(VprocFwStream *s, uint8 *dst, uint32 len)
+{
+    uint8 c;
+    while (len--) {
+        if (s->rawPos >= s->rawSize) {
+            DEBUG_LOGE(TAG_SPI, "Firmware stream overrun\n");
+            return VPROC_STATUS_ERR_IMAGE;
+        }
+        if (fw_stream_next_sequence(s) != VPROC_STATUS_SUCCESS) {
+            return VPROC_STATUS_ERR_IMAGE;
+        }
+        if (s->litLeft) {
+            if (fw_stream_src_byte(s, &c) != VPROC_STATUS_SUCCESS) {
+                return VPROC_STATUS_ERR_IMAGE;
+            }
+            s->litLeft--;
+        } else {
+            c = s->window[(s->rawPos - s->matchOff) & s->windowMask];
+            s->matchLeft--;
+        }
+        s->window[s->rawPos & s->windowMask] = c;
+        s->rawPos++;
+        s->crc = fw_stream_crc_byte(s->crc, c);
+        *dst++ = c;
+    }
+    return VPROC_STATUS_SUCCESS;
+}
+
+VprocStatusType VprocFwStreamOpen(VprocFwStream *s, const uint8 *image, uint32 len)
+{
+    memset(s, 0, sizeof(VprocFwStream));
+    if (image == NULL || len < FW_STREAM_HEADER_SIZE || memcmp(image, FW_STREAM_MAGIC, 4) != 0 ||
+        GET_LE16(image + 4) != FW_STREAM_VERSION) {
+        DEBUG_LOGE(TAG_SPI, "Invalid firmware image header\n");
+        return VPROC_STATUS_ERR_IMAGE;
+    }
+    if (image[6] > VPROC_FW_STREAM_MAX_WINDOW_BITS || GET_LE32(image + 12) > len - FW_STREAM_HEADER_SIZE) {
+        DEBUG_LOGE(TAG_SPI, "Firmware image window:%d or size not supported\n", image[6]);
+        return VPROC_STATUS_ERR_IMAGE;
+    }
+    s->windowMask = (1 << image[6]) - 1;
+    s->rawSize = GET_LE32(image + 8);
+    s->srcLen = GET_LE32(image + 12);
+    s->execAddr = GET_LE32(image + 16);
+    s->prgmBase = GET_LE32(image + 20);
+    s->havePrgmBase = image[24];
+    s->crcExpected = GET_LE32(image + 28);
+    s->src = image + FW_STREAM_HEADER_SIZE;
+    s->window = (uint8 *) malloc(s->windowMask + 1);
+    if (s->window == NULL) {
+        return VPROC_STATUS_FAILURE;
+    }
+    VprocFwStreamRewind(s);
+    return VPROC_STATUS_SUCCESS;
+}
+
+void VprocFwStreamRewind(VprocFwStream *s)
+{
+    s->srcPos = 0;
+    s->rawPos = 0;
+    s->litLeft = 0;
+    s->matchLeft = 0;
+    s->matchPending = 0;
+    s->crc = 0xFFFFFFFF;
+    s->segWordsLeft = 0;
+}
+
+VprocStatusType VprocFwStreamRead(VprocFwStream *s, uint32 *addr, unsigned short *pData, unsigned char maxWords,
+                                  unsigned char *numwords)
+{
+    uint8 buf[FW_STREAM_SEG_HDR];
+    uint32 num;
+    *numwords = 0;
+    if (s->segWordsLeft == 0) {
+        if (s->rawPos == s->rawSize) {
+            if ((s->crc ^ 0xFFFFFFFF) != s->crcExpected) {
+                DEBUG_LOGE(TAG_SPI, "Firmware image CRC mismatch\n");
+                return VPROC_STATUS_ERR_IMAGE;
+            }
+            return VPROC_STATUS_SUCCESS;
+        }
+        if (fw_stream_get(s, buf, FW_STREAM_SEG_HDR) != VPROC_STATUS_SUCCESS) {
+            return VPROC_STATUS_ERR_IMAGE;
+        }
+        s->segAddr = GET_LE32(buf);
+        s->segWordsLeft = GET_LE16(buf + 4);
+        if (s->segWordsLeft == 0 || (s->segAddr & 1)) {
+            return VPROC_STATUS_ERR_IMAGE;
+        }
+    }
+    /*limit the block inside the current segment and the page 255 window*/
+    num = (FW_STREAM_PAGE_SIZE - (s->segAddr & (FW_STREAM_PAGE_SIZE - 1))) / 2;
+    if (num > s->segWordsLeft) {
+        num = s->segWordsLeft;
+    }
+    if (num > maxWords) {
+        num = maxWords;
+    }
+    *addr = s->segAddr;
+    for (uint32 i = 0; i < num; i++) {
+        if (fw_stream_get(s, buf, 2) != VPROC_STATUS_SUCCESS) {
+            return VPROC_STATUS_ERR_IMAGE;
+        }
+        pData[i] = GET_LE16(buf);
+    }
+    s->segAddr += num * 2;
+    s->segWordsLeft -= num;
+    *numwords = (unsigned char) num;
+    return VPROC_STATUS_SUCCESS;
+}
+
+void VprocFwStreamClose(VprocFwStream *s)
+{
+    if (s->window) {
+        free(s->window);
+        s->window = NULL;
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef VPROC_FW_STREAM_H
+#define VPROC_FW_STREAM_H
+
+#include "vproc_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VPROC_FW_STREAM_MAX_WINDOW_BITS 12 /*largest history window accepted (4KB of RAM)*/
+
+/*Decoder state of a compressed firmware image
+ * The image is decompressed on the fly, only the LZ history window is kept in RAM
+ */
+typedef struct {
+    const uint8 *src;          /*compressed data*/
+    uint32       srcLen;
+    uint32       srcPos;
+    uint8       *window;       /*history of decompressed bytes*/
+    uint32       windowMask;
+    uint32       rawSize;      /*total size of decompressed stream*/
+    uint32       rawPos;
+    uint32       litLeft;      /*literal bytes left in current sequence*/
+    uint32       matchLeft;    /*match bytes left in current sequence*/
+    uint32       matchOff;
+    uint8        token;
+    uint8        matchPending; /*literals done, match of the token still to be read*/
+    uint32       crc;
+    uint32       crcExpected;
+    uint32       segAddr;      /*device address of next word in current segment*/
+    uint32       segWordsLeft;
+    uint32       execAddr;     /*The execution start address of the firmware in RAM*/
+    uint32       prgmBase;
+    uint8        havePrgmBase;
+} VprocFwStream;
+
+/*Parse the image header and allocate the history window*/
+VprocStatusType VprocFwStreamOpen(VprocFwStream *s, const uint8 *image, uint32 len);
+
+/*Get next block of firmware words, block never crosses the 256 bytes page 255 window
+ * numwords is set to 0 once the whole image is read and its CRC is verified
+ */
+VprocStatusType VprocFwStreamRead(VprocFwStream *s, uint32 *addr, unsigned short *pData, unsigned char maxWords,
+                                  unsigned char *numwords);
+
+/*Restart reading from the beginning of the image*/
+void VprocFwStreamRewind(VprocFwStream *s);
+
+/*Release the history window*/
+void VprocFwStreamClose(VprocFwStream *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VPROC_FW_STREAM_H */
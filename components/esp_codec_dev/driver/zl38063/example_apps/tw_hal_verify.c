@@ -43,7 +43,7 @@ static const char *TAG = "TW_HAL_VERIFY";
  *                   1 - load firmware only
  *                   2 - load config only
  */
-VprocStatusType LoadFwrConfig_Alt(uint8 mode)
+VprocStatusType LoadFwrConfig_Alt(VprocDev *dev, uint8 mode)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     if ((mode == 0) || (mode == 1)) {
@@ -54,7 +54,7 @@ VprocStatusType LoadFwrConfig_Alt(uint8 mode)
         st_Firmware.havePrgmBase = (uint8) haveProgramBaseAddress;
         st_Firmware.prgmBase = (uint32) programBaseAddress;
         ESP_LOGD(TAG, "Firmware boot loading started ....");
-        status = VprocTwolfHbiBoot_alt(&st_Firmware);
+        status = VprocTwolfHbiBoot_alt(dev, &st_Firmware);
         if (status != VPROC_STATUS_SUCCESS) {
             ESP_LOGD(TAG, "Error %d:VprocTwolfHbiBoot()", status);
             return -1;
@@ -62,7 +62,7 @@ VprocStatusType LoadFwrConfig_Alt(uint8 mode)
         ESP_LOGD(TAG, "Loading the image to RAM....done");
 #ifdef SAVE_IMAGE_TO_FLASH
         ESP_LOGD(TAG, "Saving firmware to flash....");
-        status = VprocTwolfSaveImgToFlash();
+        status = VprocTwolfSaveImgToFlash(dev);
         if (status != VPROC_STATUS_SUCCESS) {
             ESP_LOGD(TAG, "Error %d:VprocTwolfSaveImgToFlash()", status);
 
@@ -72,7 +72,7 @@ VprocStatusType LoadFwrConfig_Alt(uint8 mode)
 
 #endif
 
-        status = VprocTwolfFirmwareStart();
+        status = VprocTwolfFirmwareStart(dev);
         if (status != VPROC_STATUS_SUCCESS) {
             ESP_LOGD(TAG, "Error %d:VprocTwolfFirmwareStart()", status);
 
@@ -82,7 +82,7 @@ VprocStatusType LoadFwrConfig_Alt(uint8 mode)
     if ((mode == 0) || (mode == 2)) {
         ESP_LOGD(TAG, "Loading the config file into the device RAM....");
 
-        status = VprocTwolfLoadConfig((dataArr *) st_twConfig, (uint16) configStreamLen);
+        status = VprocTwolfLoadConfig(dev, (dataArr *) st_twConfig, (uint16) configStreamLen);
         if (status != VPROC_STATUS_SUCCESS) {
             ESP_LOGD(TAG, "Error %d:VprocTwolfLoadConfig()", status);
 
@@ -90,7 +90,7 @@ VprocStatusType LoadFwrConfig_Alt(uint8 mode)
         }
 #ifdef SAVE_CFG_TO_FLASH
         ESP_LOGD(TAG, "Saving config to flash....");
-        status = VprocTwolfSaveCfgToFlash();
+        status = VprocTwolfSaveCfgToFlash(dev);
         if (status != VPROC_STATUS_SUCCESS) {
             ESP_LOGD(TAG, "Error %d:VprocTwolfSaveCfgToFlash()", status);
 
@@ -103,10 +103,10 @@ VprocStatusType LoadFwrConfig_Alt(uint8 mode)
     { /*Verify that the boot loading PASS or Fail*/
         uint16 val = 0;
 
-        status = VprocTwolfHbiRead(0x0022, 1, &val);
+        status = VprocTwolfHbiRead(dev, 0x0022, 1, &val);
         if (status != VPROC_STATUS_SUCCESS) {
             ESP_LOGD(TAG, "Error %d:VprocTwolfHbiRead()", status);
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
             return -1;
         }
         if ((val == 38040) || (val == 38050) || (val == 38060) || (val == 38080) || (val == 38051) || (val == 38041)) {
@@ -126,7 +126,7 @@ VprocStatusType LoadFwrConfig_Alt(uint8 mode)
      *        command once the I2S master
      *        is up and running and is at a stable state.
      */
-    status = VprocTwolfReset(VPROC_RST_SOFTWARE);
+    status = VprocTwolfReset(dev, VPROC_RST_SOFTWARE);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfReset()", status);
 
@@ -139,6 +139,7 @@ VprocStatusType LoadFwrConfig_Alt(uint8 mode)
 
 int test_zl38063(void *arg)
 {
+    VprocDev *dev = (VprocDev *) arg;
     int status = 0;
     uint16 cmdword = 0;
     uint16 val[MAX_WORDS_FOR_MULTIWORD_ACCESS_TEST];
@@ -148,7 +149,7 @@ int test_zl38063(void *arg)
 #ifdef TW_HAL_VERIFY_DEBUG
     uint16 j = 0;
 #endif
-    status = VprocTwolfHbiInit();
+    status = VprocTwolfHbiInit(dev);
     if (status < 0) {
         perror("tw_spi_access open");
         return -1;
@@ -164,10 +165,10 @@ int test_zl38063(void *arg)
     numwords = 2;
     val[0] = 0x1234;
     val[1] = 0x5678;
-    status = VprocTwolfHbiWrite(cmdword, numwords, val);
+    status = VprocTwolfHbiWrite(dev, cmdword, numwords, val);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiWrite()\n", status);
-        VprocHALcleanup();
+        VprocHALcleanup(dev);
         return -1;
     }
 #ifdef TW_HAL_VERIFY_DEBUG
@@ -177,10 +178,10 @@ int test_zl38063(void *arg)
         j = j + 2;
     }
 #endif
-    status = VprocTwolfHbiRead(cmdword, numwords, tempbuf);
+    status = VprocTwolfHbiRead(dev, cmdword, numwords, tempbuf);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiRead()", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 #ifdef TW_HAL_VERIFY_DEBUG
@@ -197,10 +198,10 @@ int test_zl38063(void *arg)
 
     ESP_LOGD(TAG, "Test 1 - completed - PASS\n\n");
 
-    status = VprocTwolfReset(0);
+    status = VprocTwolfReset(dev, 0);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiRead()", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
     ESP_LOGD(TAG, "Device reset completed successfully...");
@@ -209,10 +210,10 @@ int test_zl38063(void *arg)
     cmdword = 0x0300;
     val[0] = 0x4008;
     numwords = 1;
-    status = VprocTwolfHbiWrite(cmdword, numwords, val);
+    status = VprocTwolfHbiWrite(dev, cmdword, numwords, val);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiWrite()", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 #ifdef TW_HAL_VERIFY_DEBUG
@@ -222,10 +223,10 @@ int test_zl38063(void *arg)
         j = j + 2;
     }
 #endif
-    status = VprocTwolfHbiRead(cmdword, numwords, val);
+    status = VprocTwolfHbiRead(dev, cmdword, numwords, val);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiRead()", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 #ifdef TW_HAL_VERIFY_DEBUG
@@ -250,10 +251,10 @@ int test_zl38063(void *arg)
 
     cmdword = 0x0300;
     numwords = MAX_WORDS_FOR_MULTIWORD_ACCESS_TEST;
-    status = VprocTwolfHbiWrite(cmdword, numwords, val);
+    status = VprocTwolfHbiWrite(dev, cmdword, numwords, val);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiWrite()", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 #ifdef TW_HAL_VERIFY_DEBUG
@@ -263,10 +264,10 @@ int test_zl38063(void *arg)
         j = j + 2;
     }
 #endif
-    status = VprocTwolfHbiRead(cmdword, numwords, tempbuf);
+    status = VprocTwolfHbiRead(dev, cmdword, numwords, tempbuf);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiRead()", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 #ifdef TW_HAL_VERIFY_DEBUG
@@ -288,12 +289,12 @@ int test_zl38063(void *arg)
     ESP_LOGD(TAG, "Test 3 - completed - PASS");
 
     ESP_LOGD(TAG, "Test 4 - Verifying the firmware/config boot loading ....");
-    if (LoadFwrConfig_Alt(0) != VPROC_STATUS_SUCCESS) {
+    if (LoadFwrConfig_Alt(dev, 0) != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Device boot loading failed.....");
         ESP_LOGD(TAG, "Test 4 - completed - FAIL!!!");
 
     } else
         ESP_LOGD(TAG, "Test 4 - completed - PASS");
-    VprocTwolfHbiCleanup();
+    VprocTwolfHbiCleanup(dev);
     return 0;
 }
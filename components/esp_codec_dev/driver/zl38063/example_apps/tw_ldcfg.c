@@ -48,7 +48,7 @@ static unsigned long fseekNunlines(FILE *BOOT_FD)
  * filepath -- pointer to the location where to find the file
  * pCr2Buf -- the actual firmware data array will be pointed to this buffer
  */
-static int readCfgFile(char *filepath)
+static int readCfgFile(VprocDev *dev, char *filepath)
 {
     unsigned int reg[2], val[2], len;
     uint8 done = 0;
@@ -112,6 +112,8 @@ static int readCfgFile(char *filepath)
 
 int main(int argc, char **argv)
 {
+    VprocDev vproc_dev = {.irq_pin = -1};
+    VprocDev *dev = &vproc_dev;
     VprocStatusType status = VPROC_STATUS_SUCCESS;
 
     if (argc != 2) {
@@ -122,31 +124,31 @@ int main(int argc, char **argv)
     ESP_LOGD(TAG, ":%s %s %s", argv[0], argv[1], argv[2]);
 
     /*global file handle*/
-    status = VprocTwolfHbiInit();
+    status = VprocTwolfHbiInit(dev);
 
     if (status < 0) {
         perror("tw_spi_access open");
         return -1;
     }
 
-    if (readCfgFile(argv[1]) < 0) {
+    if (readCfgFile(dev, argv[1]) < 0) {
         ESP_LOGD(TAG, "Error:read %s file", argv[1]);
     }
     ESP_LOGD(TAG, "a- Reading config file to host RAM - done....");
 
     ESP_LOGD(TAG, "c- Loading the config file into the device RAM");
-    status = VprocTwolfLoadConfig(pCr2Buf, numElements);
+    status = VprocTwolfLoadConfig(dev, pCr2Buf, numElements);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfLoadConfig()", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 
 #ifdef SAVE_CONFIG_TO_FLASH
-    status = VprocTwolfSaveCfgToFlash();
+    status = VprocTwolfSaveCfgToFlash(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfSaveCfgToFlash()", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
     ESP_LOGD(TAG, "d- Saving config to flash- done....");
@@ -155,7 +157,7 @@ int main(int argc, char **argv)
     ESP_LOGD(TAG, "e- Loading config record - done....");
     free(pCr2Buf);
     pCr2Buf = NULL;
-    VprocTwolfHbiCleanup();
+    VprocTwolfHbiCleanup(dev);
 
     return 0;
 }
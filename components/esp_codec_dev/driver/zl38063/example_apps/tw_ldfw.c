@@ -30,6 +30,8 @@ static const char *TAG = "TW_LDFW";
  */
 int main(int argc, char **argv)
 {
+    VprocDev vproc_dev = {.irq_pin = -1};
+    VprocDev *dev = &vproc_dev;
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     FILE *BOOT_FD;
     char line[256] = "";
@@ -48,7 +50,7 @@ int main(int argc, char **argv)
     }
 
     /*global file handle*/
-    status = VprocTwolfHbiInit();
+    status = VprocTwolfHbiInit(dev);
     if (status < 0) {
         perror("tw_spi_access open");
         fclose(BOOT_FD);
@@ -57,17 +59,17 @@ int main(int argc, char **argv)
 
     ESP_LOGD(TAG, "1- Opening firmware file - done....");
 
-    status = VprocTwolfHbiBootPrepare();
+    status = VprocTwolfHbiBootPrepare(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiBootPrepare()", status);
         fclose(BOOT_FD);
-        VprocHALcleanup();
+        VprocHALcleanup(dev);
         return -1;
     }
     ESP_LOGD(TAG, "-- Boot prepare - done....");
 
     while (fgets(line, 256, BOOT_FD) != NULL) {
-        status = VprocTwolfHbiBootMoreData(line);
+        status = VprocTwolfHbiBootMoreData(dev, line);
         if (status == VPROC_STATUS_BOOT_LOADING_MORE_DATA) {
             continue;
         } else if (status == VPROC_STATUS_BOOT_LOADING_CMP) {
@@ -75,43 +77,43 @@ int main(int argc, char **argv)
         } else if (status != VPROC_STATUS_SUCCESS) {
             ESP_LOGD(TAG, "Error %d:VprocTwolfHbiBootMoreData()", status);
             fclose(BOOT_FD);
-            VprocHALcleanup();
+            VprocHALcleanup(dev);
             return -1;
         }
     }
     ESP_LOGD(TAG, "-- Firmware data transfer - done....");
     fclose(BOOT_FD);
     /*clean up and verify that the boodloading completed correctly*/
-    status = VprocTwolfHbiBootConclude();
+    status = VprocTwolfHbiBootConclude(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfHbiBootConclude()", status);
-        VprocHALcleanup();
+        VprocHALcleanup(dev);
         return -1;
     }
 
     ESP_LOGD(TAG, "2- Loading firmware - done....");
 #ifdef SAVE_IMAGE_TO_FLASH
     ESP_LOGD(TAG, "-- Saving firmware to flash....");
-    status = VprocTwolfSaveImgToFlash();
+    status = VprocTwolfSaveImgToFlash(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfSaveImgToFlash()", status);
-        VprocHALcleanup();
+        VprocHALcleanup(dev);
         return -1;
     }
     ESP_LOGD(TAG, "-- Saving firmware to flash....done");
 
 #endif
 
-    status = VprocTwolfFirmwareStart();
+    status = VprocTwolfFirmwareStart(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         ESP_LOGD(TAG, "Error %d:VprocTwolfFirmwareStart()", status);
-        VprocHALcleanup();
+        VprocHALcleanup(dev);
         return -1;
     }
 
     ESP_LOGD(TAG, "Device boot loading completed successfully...");
 
-    VprocHALcleanup();
+    VprocHALcleanup(dev);
 
     return 0;
 }
@@ -50,7 +50,7 @@ static unsigned long fseekNunlines(FILE *BOOT_FD)
  * filepath -- pointer to the location where to find the file
  * pCr2Buf -- the actual firmware data array will be pointed to this buffer
  */
-static int readCfgFile(char *filepath)
+static int readCfgFile(VprocDev *dev, char *filepath)
 {
     unsigned int reg[2], val[2], len;
     uint8 done = 0;
@@ -113,6 +113,8 @@ static int readCfgFile(char *filepath)
  */
 int main(int argc, char **argv)
 {
+    VprocDev vproc_dev = {.irq_pin = -1};
+    VprocDev *dev = &vproc_dev;
     VprocStatusType status = VPROC_STATUS_SUCCESS;
     FILE *BOOT_FD;
     char line[256] = "";
@@ -130,7 +132,7 @@ int main(int argc, char **argv)
         return -1;
     }
     /*global file handle*/
-    status = VprocTwolfHbiInit();
+    status = VprocTwolfHbiInit(dev);
     // gTwolf_fd = open(file_name, O_RDWR);
     if (status < 0) {
         perror("tw_spi_access open");
@@ -140,17 +142,17 @@ int main(int argc, char **argv)
 
     printf("1- Opening firmware file - done....\n");
 
-    status = VprocTwolfHbiBootPrepare();
+    status = VprocTwolfHbiBootPrepare(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         printf("Error %d:VprocTwolfHbiBootPrepare()\n", status);
         fclose(BOOT_FD);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
     printf("-- Boot prepare - done....\n");
 
     while (fgets(line, 256, BOOT_FD) != NULL) {
-        status = VprocTwolfHbiBootMoreData(line);
+        status = VprocTwolfHbiBootMoreData(dev, line);
         if (status == VPROC_STATUS_BOOT_LOADING_MORE_DATA) {
             continue;
         } else if (status == VPROC_STATUS_BOOT_LOADING_CMP) {
@@ -158,58 +160,58 @@ int main(int argc, char **argv)
         } else if (status != VPROC_STATUS_SUCCESS) {
             printf("Error %d:VprocTwolfHbiBootMoreData()\n", status);
             fclose(BOOT_FD);
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
             return -1;
         }
     }
     printf("-- Firmware data transfer - done....\n");
     fclose(BOOT_FD);
 
-    status = VprocTwolfHbiBootConclude();
+    status = VprocTwolfHbiBootConclude(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         printf("Error %d:VprocTwolfHbiBootConclude()\n", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 
 #ifdef SAVE_IMAGE_TO_FLASH
     printf("-- Saving firmware to flash....\n");
-    status = VprocTwolfSaveImgToFlash();
+    status = VprocTwolfSaveImgToFlash(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         printf("Error %d:VprocTwolfSaveImgToFlash()\n", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
     printf("-- Saving firmware to flash....done\n");
 
 #endif
 
-    status = VprocTwolfFirmwareStart();
+    status = VprocTwolfFirmwareStart(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         printf("Error %d:VprocTwolfFirmwareStart()\n", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 
     printf("3- Loading the config file into the device RAM\n");
-    if (readCfgFile(argv[2]) < 0) {
+    if (readCfgFile(dev, argv[2]) < 0) {
         printf("Error:read %s file\n", argv[2]);
     }
     printf("a- Reading config file to host RAM - done....\n");
 
-    status = VprocTwolfLoadConfig(pCr2Buf, numElements);
+    status = VprocTwolfLoadConfig(dev, pCr2Buf, numElements);
     if (status != VPROC_STATUS_SUCCESS) {
         printf("Error %d:VprocTwolfLoadConfig()\n", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
 
 #ifdef SAVE_CFG_TO_FLASH
     printf("-- Saving config to flash....\n");
-    status = VprocTwolfSaveCfgToFlash();
+    status = VprocTwolfSaveCfgToFlash(dev);
     if (status != VPROC_STATUS_SUCCESS) {
         printf("Error %d:VprocTwolfSaveCfgToFlash()\n", status);
-        VprocTwolfHbiCleanup();
+        VprocTwolfHbiCleanup(dev);
         return -1;
     }
     printf("-- Saving config to flash....done\n");
@@ -217,7 +219,7 @@ int main(int argc, char **argv)
 #endif
     printf("Device boot loading completed successfully...\n");
 
-    VprocTwolfHbiCleanup();
+    VprocTwolfHbiCleanup(dev);
 
     return 0;
 }
@@ -10,6 +10,7 @@
  *
  ***************************************************************************/
 
+#include "sdkconfig.h"
 #include "vproc_common.h"
 #include "vprocTwolf_access.h"
 
@@ -19,7 +20,9 @@
  * then remove the #include *.c below
  */
 #include "zl38063_config.h"
+#ifndef CONFIG_CODEC_ZL38063_COMPRESSED_FIRMWARE
 #include "zl38063_firmware.h"
+#endif
 #include "codec_dev_os.h"
 
 #undef SAVE_IMAGE_TO_FLASH /*define this macro to save the firmware from RAM to flash*/
@@ -29,44 +32,188 @@
 #define SAVE_CFG_TO_FLASH
 /*quick test*/
 
-/*LoadFwrConfig_Alt - to load a converted *s3, *cr2 to c code into the device.
- * Basically instead of loading the *.s3, *cr2 directly,
- * use the tw_convert tool to convert the ascii hex fwr mage into code and compile
- * with the application
- *
- * input arg: mode:  0 - load both firmware and confing
- *                   1 - load firmware only
- *                   2 - load config only
- *                  -1 - Force loading
+#define TW_APP_BOOT_TIMEOUT_MS  1000 /*maximum time for the firmware to be running after reset*/
+#define TW_APP_POLL_INTERVAL_MS 20
+#define TW_FLASH_IMAGE_INDEX    1   /*image slot used by the managed flash boot*/
+#define TW_FINGERPRINT_RECORDS  4   /*number of firmware records sampled in the fingerprint*/
+#define TW_FNV_OFFSET_BASIS     0x811C9DC5
+#define TW_FNV_PRIME            0x01000193
+#define TW_SAMPLE_WORDS         16  /*maximum words of one sampled firmware block*/
+
+typedef struct {
+    uint32 addr;
+    uint16 num;
+    uint16 buf[TW_SAMPLE_WORDS];
+} tw_fw_sample_t;
+
+/*config registers changed at runtime (output gain A/B, system control), they are
+ * left out of the fingerprint so that a warm reboot after volume change still matches
+ */
+static const uint16 tw_runtime_regs[] = {0x0238, 0x023A, 0x0300};
+
+#ifdef CONFIG_CODEC_ZL38063_COMPRESSED_FIRMWARE
+/*compressed firmware image embedded by the component build*/
+extern const uint8 zl38063_fw_image_start[] asm("_binary_zl38063_firmware_lz_bin_start");
+extern const uint8 zl38063_fw_image_end[] asm("_binary_zl38063_firmware_lz_bin_end");
+
+static int tw_fw_stream_open(VprocFwStream *fw)
+{
+    return VprocFwStreamOpen(fw, zl38063_fw_image_start, (uint32) (zl38063_fw_image_end - zl38063_fw_image_start));
+}
+
+/*tw_get_fw_samples - pick TW_FINGERPRINT_RECORDS blocks evenly spaced in the raw stream of the
+ * compressed image in a single pass. Decoding stops at the last sample, the CRC of the whole
+ * image is verified when it is loaded
+ */
+static int tw_get_fw_samples(tw_fw_sample_t *samples)
+{
+    VprocFwStream fw;
+    int picked = 0;
+    uint32 addr;
+    unsigned char num = 0;
+    int status = tw_fw_stream_open(&fw);
+    if (status != VPROC_STATUS_SUCCESS) {
+        return status;
+    }
+    while (picked < TW_FINGERPRINT_RECORDS) {
+        uint32 pos = fw.rawPos;
+        status = VprocFwStreamRead(&fw, &addr, samples[picked].buf, TW_SAMPLE_WORDS, &num);
+        if (status != VPROC_STATUS_SUCCESS || num == 0) {
+            break;
+        }
+        if ((uint64_t) pos * TW_FINGERPRINT_RECORDS >= (uint64_t) fw.rawSize * picked) {
+            samples[picked].addr = addr;
+            samples[picked].num = num;
+            picked++;
+        }
+    }
+    VprocFwStreamClose(&fw);
+    if (status == VPROC_STATUS_SUCCESS && picked != TW_FINGERPRINT_RECORDS) {
+        status = VPROC_STATUS_ERR_IMAGE;
+    }
+    return status;
+}
+#else
+static int tw_get_fw_samples(tw_fw_sample_t *samples)
+{
+    for (int i = 0; i < TW_FINGERPRINT_RECORDS; i++) {
+        const twFwr *fwr = &st_twFirmware[(firmwareStreamLen - 1) * i / (TW_FINGERPRINT_RECORDS - 1)];
+        samples[i].addr = fwr->targetAddr;
+        samples[i].num = fwr->numWords > TW_SAMPLE_WORDS ? TW_SAMPLE_WORDS : fwr->numWords;
+        memcpy(samples[i].buf, fwr->buf, samples[i].num * sizeof(uint16));
+    }
+    return VPROC_STATUS_SUCCESS;
+}
+#endif
+
+/*tw_wait_app_running - poll the application status until the firmware
+ * is running or the timeout is reached instead of a blind delay
+ */
+static int tw_wait_app_running(VprocDev *dev, uint16 *app_status, int timeout_ms)
+{
+    int ret;
+    int waited = 0;
+    while (1) {
+        *app_status = 0;
+        ret = VprocTwolfGetAppStatus(dev, app_status);
+        if ((ret == VPROC_STATUS_SUCCESS && *app_status) || waited >= timeout_ms) {
+            break;
+        }
+        codec_dev_sleep(TW_APP_POLL_INTERVAL_MS);
+        waited += TW_APP_POLL_INTERVAL_MS;
+    }
+    ESP_LOGI(TAG_SPI, "App status:%d after %dms", *app_status, waited);
+    return ret;
+}
+
+static bool tw_is_runtime_reg(uint16 reg)
+{
+    for (int i = 0; i < sizeof(tw_runtime_regs) / sizeof(tw_runtime_regs[0]); i++) {
+        if (tw_runtime_regs[i] == reg) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32 tw_hash_words(uint32 hash, const uint16 *words, int num)
+{
+    for (int i = 0; i < num; i++) {
+        hash = (hash ^ (words[i] & 0xFF)) * TW_FNV_PRIME;
+        hash = (hash ^ (words[i] >> 8)) * TW_FNV_PRIME;
+    }
+    return hash;
+}
+
+/*tw_get_image_fingerprint - build the tag of the image from the pre-compiled
+ * config record and sampled firmware records, either from host image or read back from device
+ * Config registers changed at runtime are skipped
+ */
+static int tw_get_image_fingerprint(VprocDev *dev, bool from_device, const tw_fw_sample_t *samples,
+                                    uint32 *fingerprint)
+{
+    uint32 hash = TW_FNV_OFFSET_BASIS;
+    uint16 buf[TW_SAMPLE_WORDS];
+    int status;
+    for (int i = 0; i < configStreamLen; i++) {
+        if (tw_is_runtime_reg(st_twConfig[i].reg)) {
+            continue;
+        }
+        buf[0] = st_twConfig[i].value;
+        if (from_device) {
+            status = VprocTwolfHbiRead(dev, st_twConfig[i].reg, 1, buf);
+            if (status != VPROC_STATUS_SUCCESS) {
+                return status;
+            }
+        }
+        hash = tw_hash_words(hash, buf, 1);
+    }
+    for (int i = 0; i < TW_FINGERPRINT_RECORDS; i++) {
+        int num = samples[i].num;
+        if (num == 0) {
+            continue;
+        }
+        memcpy(buf, samples[i].buf, num * sizeof(uint16));
+        if (from_device) {
+            status = VprocTwolfReadRam(dev, samples[i].addr, num, buf);
+            if (status != VPROC_STATUS_SUCCESS) {
+                return status;
+            }
+        }
+        hash = tw_hash_words(hash, buf, num);
+    }
+    *fingerprint = hash;
+    return VPROC_STATUS_SUCCESS;
+}
+
+/*tw_load_dsp_firmware - load the pre-compiled firmware and or config into device RAM
+ * and optionally save them into the slave flash
  */
-int tw_upload_dsp_firmware(int mode)
+static int tw_load_dsp_firmware(VprocDev *dev, int mode, bool save_img, bool save_cfg)
 {
     union {
         short a;
         char  b;
     } test_bigendian;
-    if (mode >= 0) {
-        uint16 vol = 0;
-        codec_dev_sleep(1000);
-        int ret = VprocTwolfGetAppStatus(&vol);
-        if (vol) {
-            ESP_LOGW(TAG_SPI, "MCS ret:%d,Status:%d", ret, vol);
-            return 0;
-        }
-        ESP_LOGI(TAG_SPI, "** Loading DSP firmware ret:%d,Status:%d **", ret, vol);
-    } else {
-        mode = 0;
-    }
     test_bigendian.a = 1;
     ESP_LOGI(TAG_SPI, "b=%d", test_bigendian.b);
 
-    int status = VprocTwolfHbiInit();
+    int status = VprocTwolfHbiInit(dev);
     if (status < 0) {
         DEBUG_LOGE(TAG_SPI, "tw_spi_access open");
         return -1;
     }
 
     if ((mode == 0) || (mode == 1)) {
+#ifdef CONFIG_CODEC_ZL38063_COMPRESSED_FIRMWARE
+        VprocFwStream fw;
+        ESP_LOGI(TAG_SPI, "1- Compressed firmware boot loading started ....");
+        status = tw_fw_stream_open(&fw);
+        if (status == VPROC_STATUS_SUCCESS) {
+            status = VprocTwolfHbiBootStream(dev, &fw);
+            VprocFwStreamClose(&fw);
+        }
+#else
         twFirmware st_Firmware;
         st_Firmware.st_Fwr = (twFwr *) st_twFirmware;
         st_Firmware.twFirmwareStreamLen = (uint16) firmwareStreamLen;
@@ -76,7 +223,8 @@ int tw_upload_dsp_firmware(int mode)
 
         ESP_LOGI(TAG_SPI, "1- Firmware boot loading started ....");
 
-        status = VprocTwolfHbiBoot_alt(&st_Firmware);
+        status = VprocTwolfHbiBoot_alt(dev, &st_Firmware);
+#endif
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "Error %d:VprocTwolfHbiBoot()", status);
             // VprocTwolfHbiCleanup();
@@ -84,18 +232,17 @@ int tw_upload_dsp_firmware(int mode)
         }
 
         ESP_LOGI(TAG_SPI, "2- Loading the image to RAM....done");
-#ifdef SAVE_IMAGE_TO_FLASH
-        ESP_LOGI(TAG_SPI, "-- Saving firmware to flash....");
-        status = VprocTwolfSaveImgToFlash();
-        if (status != VPROC_STATUS_SUCCESS) {
-            DEBUG_LOGE(TAG_SPI, "Error %d:VprocTwolfSaveImgToFlash()", status);
-            // VprocTwolfHbiCleanup();
-            return status;
+        if (save_img) {
+            ESP_LOGI(TAG_SPI, "-- Saving firmware to flash....");
+            status = VprocTwolfSaveImgToFlash(dev);
+            if (status != VPROC_STATUS_SUCCESS) {
+                DEBUG_LOGE(TAG_SPI, "Error %d:VprocTwolfSaveImgToFlash()", status);
+                // VprocTwolfHbiCleanup();
+                return status;
+            }
+            ESP_LOGI(TAG_SPI, "-- Saving firmware to flash....done");
         }
-        ESP_LOGI(TAG_SPI, "-- Saving firmware to flash....done");
-
-#endif
-        status = VprocTwolfFirmwareStart();
+        status = VprocTwolfFirmwareStart(dev);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "Error %d:VprocTwolfFirmwareStart()", status);
             // VprocTwolfHbiCleanup();
@@ -103,43 +250,110 @@ int tw_upload_dsp_firmware(int mode)
         }
     }
 
-#if 1
     if ((mode == 0) || (mode == 2)) {
         ESP_LOGI(TAG_SPI, "3- Loading the config file into the device RAM....");
 
-        status = VprocTwolfLoadConfig((dataArr *) st_twConfig, (uint16) configStreamLen);
+        status = VprocTwolfLoadConfig(dev, (dataArr *) st_twConfig, (uint16) configStreamLen);
         if (status != VPROC_STATUS_SUCCESS) {
             DEBUG_LOGE(TAG_SPI, "Error %d:VprocTwolfLoadConfig()", status);
             // VprocTwolfHbiCleanup();
             return status;
         }
-#ifdef SAVE_CFG_TO_FLASH
-        ESP_LOGI(TAG_SPI, "-- Saving config to flash....");
-        status = VprocTwolfSaveCfgToFlash();
-        if (status != VPROC_STATUS_SUCCESS) {
-            DEBUG_LOGE(TAG_SPI, "Error %d:VprocTwolfSaveCfgToFlash()", status);
-            // VprocTwolfHbiCleanup();
-            return status;
+        if (save_cfg) {
+            ESP_LOGI(TAG_SPI, "-- Saving config to flash....");
+            status = VprocTwolfSaveCfgToFlash(dev);
+            if (status != VPROC_STATUS_SUCCESS) {
+                DEBUG_LOGE(TAG_SPI, "Error %d:VprocTwolfSaveCfgToFlash()", status);
+                // VprocTwolfHbiCleanup();
+                return status;
+            }
+            ESP_LOGI(TAG_SPI, "-- Saving config to flash....done");
         }
-        ESP_LOGI(TAG_SPI, "-- Saving config to flash....done");
-
-#endif
     }
     /*Firmware reset - in order for the configuration to take effect*/
-    status = VprocTwolfReset(VPROC_RST_SOFTWARE);
+    status = VprocTwolfReset(dev, VPROC_RST_SOFTWARE);
     if (status != VPROC_STATUS_SUCCESS) {
         DEBUG_LOGE(TAG_SPI, "Error %d:VprocTwolfReset()", status);
         ESP_LOGI(TAG_SPI, "Error");
         // VprocTwolfHbiCleanup();
         return status;
     }
-#endif
 
     ESP_LOGI(TAG_SPI, "Device boot loading completed successfully...");
     return status;
 }
 
-int zl38063_comm(int argc, char **argv)
+/*LoadFwrConfig_Alt - to load a converted *s3, *cr2 to c code into the device.
+ * Basically instead of loading the *.s3, *cr2 directly,
+ * use the tw_convert tool to convert the ascii hex fwr mage into code and compile
+ * with the application
+ *
+ * input arg: mode:  0 - load both firmware and confing
+ *                   1 - load firmware only
+ *                   2 - load config only
+ *                  -1 - Force loading
+ */
+int tw_upload_dsp_firmware(VprocDev *dev, int mode)
+{
+    bool save_img = false;
+    bool save_cfg = false;
+#ifdef SAVE_IMAGE_TO_FLASH
+    save_img = true;
+#endif
+#ifdef SAVE_CFG_TO_FLASH
+    save_cfg = true;
+#endif
+    if (mode >= 0) {
+        uint16 vol = 0;
+        int ret = tw_wait_app_running(dev, &vol, TW_APP_BOOT_TIMEOUT_MS);
+        if (vol) {
+            ESP_LOGW(TAG_SPI, "MCS ret:%d,Status:%d", ret, vol);
+            return 0;
+        }
+        ESP_LOGI(TAG_SPI, "** Loading DSP firmware ret:%d,Status:%d **", ret, vol);
+    } else {
+        mode = 0;
+    }
+    return tw_load_dsp_firmware(dev, mode, save_img, save_cfg);
+}
+
+/*tw_boot_dsp_firmware_from_flash - managed flash boot.
+ * Start the firmware saved in the slave flash and verify its fingerprint against
+ * the pre-compiled image. Only when missing or outdated, load the image through HBI
+ * and save firmware and config to flash so that following boots run from flash.
+ */
+int tw_boot_dsp_firmware_from_flash(VprocDev *dev)
+{
+    uint16 app_status = 0;
+    uint32 expected = 0, actual = 0;
+    tw_fw_sample_t samples[TW_FINGERPRINT_RECORDS];
+    /*samples are shared by both fingerprints so that the image is decoded only once*/
+    int status = tw_get_fw_samples(samples);
+    if (status == VPROC_STATUS_SUCCESS) {
+        tw_get_image_fingerprint(dev, false, samples, &expected);
+    }
+    tw_wait_app_running(dev, &app_status, TW_APP_BOOT_TIMEOUT_MS);
+    if (app_status == 0) {
+        /*firmware not started by itself, try to load it from flash*/
+        if (VprocTwolfHbiInit(dev) == VPROC_STATUS_SUCCESS &&
+            VprocTwolfLoadFwrCfgFromFlash(dev, TW_FLASH_IMAGE_INDEX) == VPROC_STATUS_SUCCESS &&
+            VprocTwolfReset(dev, VPROC_RST_HARDWARE_RAM) == VPROC_STATUS_SUCCESS) {
+            tw_wait_app_running(dev, &app_status, TW_APP_BOOT_TIMEOUT_MS);
+        }
+    }
+    if (app_status && status == VPROC_STATUS_SUCCESS &&
+        tw_get_image_fingerprint(dev, true, samples, &actual) == VPROC_STATUS_SUCCESS && actual == expected) {
+        ESP_LOGI(TAG_SPI, "Boot from flash image tag:%08x", (unsigned) expected);
+        return 0;
+    }
+    ESP_LOGW(TAG_SPI, "Flash image tag:%08x expected:%08x, update flash image", (unsigned) actual, (unsigned) expected);
+    if (app_status) {
+        VprocTwolfFirmwareStop(dev);
+    }
+    return tw_load_dsp_firmware(dev, 0, true, true);
+}
+
+int zl38063_comm(VprocDev *dev, int argc, char **argv)
 {
     VprocStatusType status = VPROC_STATUS_SUCCESS;
 
@@ -252,7 +466,7 @@ int zl38063_comm(int argc, char **argv)
         return -1;
     }
     /*global file handle*/
-    status = VprocTwolfHbiInit();
+    status = VprocTwolfHbiInit(dev);
     if (status < 0) {
         perror("tw_spi_access open");
         return -1;
@@ -273,10 +487,10 @@ int zl38063_comm(int argc, char **argv)
             for (i = 0; i < numwords; i++) {
                 val[i] = (unsigned short) strtoul(argv[3 + i], NULL, 0);
             }
-            status = VprocTwolfHbiWrite(cmdword, numwords, val);
+            status = VprocTwolfHbiWrite(dev, cmdword, numwords, val);
             if (status != VPROC_STATUS_SUCCESS) {
                 printf("Error %d:VprocTwolfHbiWrite()\n", status);
-                VprocTwolfHbiCleanup();
+                VprocTwolfHbiCleanup(dev);
                 return -1;
             }
             for (i = 0; i < numwords; i++) {
@@ -288,13 +502,13 @@ int zl38063_comm(int argc, char **argv)
             numwords = (unsigned char) strtoul(argv[3], NULL, 0);
             if ((numwords == 0) || (numwords > 128)) {
                 printf("number of words is out of range. Maximum is 128\n");
-                VprocTwolfHbiCleanup();
+                VprocTwolfHbiCleanup(dev);
                 return -1;
             }
-            status = VprocTwolfHbiRead(cmdword, numwords, val);
+            status = VprocTwolfHbiRead(dev, cmdword, numwords, val);
             if (status != VPROC_STATUS_SUCCESS) {
                 printf("Error %d:VprocTwolfHbiRead()\n", status);
-                VprocTwolfHbiCleanup();
+                VprocTwolfHbiCleanup(dev);
                 return -1;
             }
             for (i = 0; i < numwords; i++) {
@@ -304,10 +518,10 @@ int zl38063_comm(int argc, char **argv)
         }
     } else if (strcmp(argv[1], "-rst") == 0) { /*for RESETTING ZL380xx*/
         unsigned char rstMode = (unsigned char) strtoul(argv[2], NULL, 0);
-        status = VprocTwolfReset((uint16) rstMode);
+        status = VprocTwolfReset(dev, (uint16) rstMode);
         if (status != VPROC_STATUS_SUCCESS) {
             printf("Error %d:VprocTwolfHbiRead()\n", status);
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
             return -1;
         }
         printf("Device reset completed successfully...\n");
@@ -315,55 +529,55 @@ int zl38063_comm(int argc, char **argv)
     } else if (strcmp(argv[1], "-lfcff") == 0) {
         /*Load ZL380x0 firmware + related config record from flash*/
         unsigned short image_num = (unsigned short) strtoul(argv[2], NULL, 0);
-        status = VprocTwolfFirmwareStop();
+        status = VprocTwolfFirmwareStop(dev);
         if (status != VPROC_STATUS_SUCCESS) {
             printf("Error %d:VprocTwolfFirmwareStop()\n", status);
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
             return -1;
         }
-        status = VprocTwolfLoadFwrCfgFromFlash(image_num);
+        status = VprocTwolfLoadFwrCfgFromFlash(dev, image_num);
         if (status != VPROC_STATUS_SUCCESS) {
             printf("Error %d:VprocTwolfLoadFwrCfgFromFlash()\n", status);
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
             return -1;
         }
-        status = VprocTwolfReset(VPROC_RST_HARDWARE_RAM);
+        status = VprocTwolfReset(dev, VPROC_RST_HARDWARE_RAM);
         if (status != VPROC_STATUS_SUCCESS) {
             printf("Error %d:VprocTwolfReset()\n", status);
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
             return -1;
         }
         printf("Device boot loading from flash completed successfully...\n");
     } else if (strcmp(argv[1], "-lfff") == 0) {
         if (status != VPROC_STATUS_SUCCESS) {
             printf("Error %d:VprocTwolfLoadFwrFromFlash()\n", status);
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
             return -1;
         }
 
         printf("Device boot loading from flash completed successfully...\n");
 
     } else if (strcmp(argv[1], "-lfcfh-a") == 0) { /*for LOADING FWR/CFG via SPI*/
-        if (tw_upload_dsp_firmware(0) != VPROC_STATUS_SUCCESS)
+        if (tw_upload_dsp_firmware(dev, 0) != VPROC_STATUS_SUCCESS)
             printf("Device boot loading failed.....\n");
 
     } else if (strcmp(argv[1], "-lcfh-a") == 0) { /*for LOADING CFG via SPI*/
-        if (tw_upload_dsp_firmware(2) != VPROC_STATUS_SUCCESS)
+        if (tw_upload_dsp_firmware(dev, 2) != VPROC_STATUS_SUCCESS)
             printf("Device boot loading failed.....\n");
 
     } else if (strcmp(argv[1], "-lffh-a") == 0) { /*for LOADING FWR via SPI*/
-        if (tw_upload_dsp_firmware(1) != VPROC_STATUS_SUCCESS)
+        if (tw_upload_dsp_firmware(dev, 1) != VPROC_STATUS_SUCCESS)
             printf("Device boot loading failed.....\n");
 
     } else if (strcmp(argv[1], "-sto") == 0) { /*for resetting into boot mode*/
-        if (VprocTwolfFirmwareStop() != 0)
-            VprocTwolfHbiCleanup();
+        if (VprocTwolfFirmwareStop(dev) != 0)
+            VprocTwolfHbiCleanup(dev);
         else
             printf("Firmware stopped to boot mode completed"
                    " successfully...\n");
     } else if (strcmp(argv[1], "-sta") == 0) { /*start executing FWR/CFG */
-        if (VprocTwolfFirmwareStart() != 0)
-            VprocTwolfHbiCleanup();
+        if (VprocTwolfFirmwareStart(dev) != 0)
+            VprocTwolfHbiCleanup(dev);
         else
             printf("Firmware is now running successfully...\n");
     } else if (strcmp(argv[1], "-mute_r") == 0) { /*start executing FWR/CFG */
@@ -371,7 +585,7 @@ int zl38063_comm(int argc, char **argv)
         // to do need fix
         // if(VprocTwolfMute(VPROC_ROUT, mute) != 0)
         if (1) {
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
         } else {
             if (mute)
                 printf("ROUT Port muted sucessfully...\n");
@@ -383,7 +597,7 @@ int zl38063_comm(int argc, char **argv)
         // to do need fix
         // if(VprocTwolfMute(VPROC_SOUT, mute) != 0)
         if (1)
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
         else {
             if (mute)
                 printf("SOUT Port muted sucessfully...\n");
@@ -403,22 +617,22 @@ int zl38063_comm(int argc, char **argv)
 #if 0
         if (strcmp(argv[1], "-arec") == 0) {
             if (VprocTwolfUpstreamConfigure(pclkrate, fsrate, aecState) != 0)
-                VprocTwolfHbiCleanup();
+                VprocTwolfHbiCleanup(dev);
             else
                 printf("Device configured for audio recording...\n");
         } else if (strcmp(argv[1], "-apla") == 0) {
             if (VprocTwolfDownstreamConfigure(pclkrate, fsrate, aecState) != 0)
-                VprocTwolfHbiCleanup();
+                VprocTwolfHbiCleanup(dev);
             else
                 printf("Device configured for audio playback...\n");
         }
 #endif
     } else if (strcmp(argv[1], "-fclr") == 0) {
         /*Erase the full content of the ZL380x0 controlled slave flash*/
-        status = VprocTwolfEraseFlash();
+        status = VprocTwolfEraseFlash(dev);
         if (status != VPROC_STATUS_SUCCESS) {
             printf("Error %d:VprocTwolfEraseFlash()\n", status);
-            VprocTwolfHbiCleanup();
+            VprocTwolfHbiCleanup(dev);
             return -1;
         }
         printf("flash erasing completed successfully...\n");
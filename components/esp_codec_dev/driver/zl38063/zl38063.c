@@ -31,6 +31,7 @@
 #include "codec_dev_utils.h"
 #include "tw_spi_access.h"
 #include "vproc_common.h"
+#include "vprocTwolf_access.h"
 
 #define TAG                              "zl38063"
 
@@ -46,6 +47,7 @@ typedef struct {
     bool                         is_open;
     int16_t                      pa_pin;
     int16_t                      reset_pin;
+    VprocDev                     vproc;
 } audio_codec_zl38063_t;
 
 static uint16_t convert_edian(uint16_t v)
@@ -178,7 +180,8 @@ static int zl38063_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
     codec->pa_pin = codec_cfg->pa_pin;
     codec->reset_pin = codec_cfg->reset_pin;
     uint16_t status = 0;
-    VprocSetCtrlIf((void *) codec_cfg->ctrl_if);
+    VprocSetCtrlIf(&codec->vproc, codec_cfg->ctrl_if);
+    VprocSetIrqPin(&codec->vproc, codec_cfg->irq_pin);
     zl38063_reset(codec, true);
     int ret = get_status(codec, &status);
     if (ret != 0) {
@@ -186,8 +189,10 @@ static int zl38063_open(const audio_codec_if_t *h, void *cfg, int cfg_size)
         return CODEC_DEV_WRITE_FAIL;
     }
     ESP_LOGI(TAG, "Status:%d", status);
-    if (status == 0) {
-        ret = tw_upload_dsp_firmware(0);
+    if (codec_cfg->flash_boot) {
+        ret = tw_boot_dsp_firmware_from_flash(&codec->vproc);
+    } else if (status == 0) {
+        ret = tw_upload_dsp_firmware(&codec->vproc, 0);
     }
     if (ret != 0) {
         ESP_LOGI(TAG, "Fail to write register");
@@ -242,7 +247,8 @@ static int zl38063_close(const audio_codec_if_t *h)
         codec->is_open = false;
     }
     zl38063_reset(codec, false);
-    VprocSetCtrlIf(NULL);
+    VprocSetIrqPin(&codec->vproc, -1);
+    VprocSetCtrlIf(&codec->vproc, NULL);
     return CODEC_DEV_OK;
 }
 
@@ -281,12 +287,23 @@ static int zl38063_set_fs(const audio_codec_if_t *h, codec_sample_info_t *fs)
         return CODEC_DEV_WRONG_STATE;
     }
     if (fs->channel != 2 || fs->sample_rate != 48000 || fs->bits_per_sample != 16) {
-        ESP_LOGE(TAG, "Firmware only support 48k 2channel 16 bits audio");
+        ESP_LOGW(TAG, "Firmware runs at 48k 2channel 16 bits audio");
         return CODEC_DEV_NOT_SUPPORT;
     }
     return CODEC_DEV_OK;
 }
 
+static int zl38063_get_caps(const audio_codec_if_t *h, uint32_t *caps)
+{
+    audio_codec_zl38063_t *codec = (audio_codec_zl38063_t *) h;
+    if (codec == NULL || caps == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    // DSP converts other formats to the fixed firmware format
+    *caps = CODEC_IF_CAP_FIXED_FMT;
+    return CODEC_DEV_OK;
+}
+
 const audio_codec_if_t *zl38063_codec_new(zl38063_codec_cfg_t *codec_cfg)
 {
     // verify param
@@ -309,6 +326,7 @@ const audio_codec_if_t *zl38063_codec_new(zl38063_codec_cfg_t *codec_cfg)
     codec->base.set_reg = zl38063_set_reg;
     codec->base.get_reg = zl38063_get_reg;
     codec->base.set_fs = zl38063_set_fs;
+    codec->base.get_caps = zl38063_get_caps;
     codec->base.close = zl38063_close;
     do {
         int ret = codec->base.open(&codec->base, codec_cfg, sizeof(zl38063_codec_cfg_t));
@@ -323,3 +341,19 @@ const audio_codec_if_t *zl38063_codec_new(zl38063_codec_cfg_t *codec_cfg)
     }
     return NULL;
 }
+
+int zl38063_get_cmd_stats(const audio_codec_if_t *h, zl38063_cmd_stats_t *stats, bool reset)
+{
+    audio_codec_zl38063_t *codec = (audio_codec_zl38063_t *) h;
+    VprocCmdStats cmd_stats;
+    if (codec == NULL || stats == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    VprocTwolfGetCmdStats(&codec->vproc, &cmd_stats, reset);
+    stats->cmd_count = cmd_stats.cmd_count;
+    stats->timeout_count = cmd_stats.timeout_count;
+    stats->poll_count = cmd_stats.poll_count;
+    stats->max_wait_us = cmd_stats.max_wait_us;
+    stats->total_wait_us = cmd_stats.total_wait_us;
+    return CODEC_DEV_OK;
+}
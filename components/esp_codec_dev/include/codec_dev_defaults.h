@@ -34,6 +34,14 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Codec register cache control interface configuration
+ */
+typedef struct {
+    const audio_codec_ctrl_if_t  *ctrl_if; /*!< Control interface to access codec registers, must be deleted after cache interface */
+    const codec_reg_cache_desc_t *desc;    /*!< Register cache description of codec */
+} codec_cache_ctrl_cfg_t;
+
 /**
  * @brief         Get default codec GPIO interface
  * @return        Codec GPIO interface
@@ -58,6 +66,38 @@ const audio_codec_ctrl_if_t *audio_codec_new_i2c_ctrl_if(codec_i2c_dev_cfg_t *i2
  */
 const audio_codec_data_if_t *audio_codec_new_i2s_data_if(codec_i2s_dev_cfg_t *i2s_cfg);
 
+/**
+ * @brief         Get register cache control interface
+ *                It wraps an existing control interface, keeps a shadow copy of written and read registers
+ *                Register read is served from cache, write which not change register value is skipped
+ * @note          Only supports codec with 8-bit register address
+ *                Cache interface need be deleted before the wrapped control interface
+ * @param         cache_cfg: Cache control configuration
+ * @return        NULL: Fail to new cache control interface
+ *                -Others: Cache control interface
+ */
+const audio_codec_ctrl_if_t *audio_codec_new_cache_ctrl_if(codec_cache_ctrl_cfg_t *cache_cfg);
+
+/**
+ * @brief         Invalidate all cached registers
+ *                Call it when codec registers may be changed without the cache interface (e.g. power lost)
+ * @param         ctrl_if: Cache control interface
+ * @return        CODEC_DEV_OK: Invalidate success
+ *                CODEC_DEV_INVALID_ARG: Not cache control interface
+ */
+int audio_codec_cache_ctrl_invalidate(const audio_codec_ctrl_if_t *ctrl_if);
+
+/**
+ * @brief         Get lock statistics of shared control bus
+ * @param         bus_type: Bus type
+ * @param         port: Bus port
+ * @param         stats: Bus lock statistics to store
+ * @return        CODEC_DEV_OK: Get statistics success
+ *                CODEC_DEV_INVALID_ARG: Invalid arguments
+ *                CODEC_DEV_NOT_FOUND: No control interface uses this bus
+ */
+int audio_codec_get_bus_lock_stats(codec_bus_type_t bus_type, uint8_t port, codec_bus_lock_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
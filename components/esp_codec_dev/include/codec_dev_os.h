@@ -24,6 +24,8 @@
 #ifndef CODEC_DEV_OS_H
 #define CODEC_DEV_OS_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -34,6 +36,88 @@ extern "C" {
  */
 void codec_dev_sleep(int ms);
 
+/**
+ * @brief         Busy wait certain microseconds, used for short polling interval
+ * @param         us: Wait time (unit us)
+ */
+void codec_dev_delay_us(int us);
+
+/**
+ * @brief         Get current time
+ * @return        Time since system start (unit us)
+ */
+uint64_t codec_dev_get_time_us(void);
+
+/**
+ * @brief         Create mutex
+ * @return        NULL: Fail to create mutex
+ *                -Others: Mutex handle
+ */
+void *codec_dev_mutex_create(void);
+
+/**
+ * @brief         Lock mutex, wait until lock success
+ * @param         mutex: Mutex handle
+ */
+void codec_dev_mutex_lock(void *mutex);
+
+/**
+ * @brief         Unlock mutex
+ * @param         mutex: Mutex handle
+ */
+void codec_dev_mutex_unlock(void *mutex);
+
+/**
+ * @brief         Delete mutex
+ * @param         mutex: Mutex handle
+ */
+void codec_dev_mutex_delete(void *mutex);
+
+/**
+ * @brief         Create binary semaphore
+ * @return        NULL: Fail to create semaphore
+ *                -Others: Semaphore handle
+ */
+void *codec_dev_sem_create(void);
+
+/**
+ * @brief         Take semaphore
+ * @param         sem: Semaphore handle
+ * @param         timeout_ms: Wait time (unit ms), negative value means wait forever
+ * @return        0: Take success
+ *                -1: Timeout
+ */
+int codec_dev_sem_take(void *sem, int timeout_ms);
+
+/**
+ * @brief         Give semaphore
+ * @param         sem: Semaphore handle
+ */
+void codec_dev_sem_give(void *sem);
+
+/**
+ * @brief         Delete semaphore
+ * @param         sem: Semaphore handle
+ */
+void codec_dev_sem_delete(void *sem);
+
+/**
+ * @brief         Create thread
+ * @param         body: Thread body
+ * @param         name: Thread name
+ * @param         arg: Argument passed to thread body
+ * @param         stack_size: Thread stack size (unit bytes)
+ * @param         prio: Thread priority
+ * @return        0: Create success
+ *                -1: Fail to create thread
+ */
+int codec_dev_thread_create(void (*body)(void *arg), const char *name, void *arg, int stack_size, int prio);
+
+/**
+ * @brief         Exit from current thread, must be called at end of thread body
+ */
+void codec_dev_thread_exit(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -48,8 +48,18 @@ typedef struct {
     uint8_t  bits_per_sample; /*!< Bit lengths of one channel data */
     uint8_t  channel;         /*!< Channels of sample */
     uint32_t sample_rate;     /*!< Sample rate of sample */
+    uint32_t mclk;            /*!< MCLK frequency (Hz) fed to codec, filled by data interface when open
+                                   0 means unknown, codec uses its default MCLK multiple */
 } codec_sample_info_t;
 
+/**
+ * @brief Codec register and value pair used for register sequence write
+ */
+typedef struct {
+    uint8_t reg;   /*!< Register address */
+    uint8_t value; /*!< Register value */
+} codec_reg_val_pair_t;
+
 /**
  * @brief Codec volume map to decibel
  */
@@ -70,25 +80,65 @@ typedef struct {
  * @brief Codec I2C configuration
  */
 typedef struct {
-    uint8_t port;  /*!< I2C port, this port need pre-installed by other modules */
-    uint8_t addr;  /*!< I2C address, default address can be gotten from codec head files */
+    uint8_t  port;  /*!< I2C port, this port need pre-installed by other modules */
+    uint8_t  addr;  /*!< I2C address, default address can be gotten from codec head files */
+    uint32_t speed; /*!< Maximum I2C clock speed (Hz) device supports, 0 means no limitation */
 } codec_i2c_dev_cfg_t;
 
 /**
  * @brief Codec I2S configuration
  */
 typedef struct {
-    uint8_t port; /*!< I2S port, this port need pre-installed by other modules */
+    uint8_t  port;          /*!< I2S port, this port need pre-installed by other modules */
+    uint16_t mclk_multiple; /*!< MCLK multiple of sample rate, same as `mclk_multiple` used to install I2S driver
+                                 Set to 0 to use default 256 */
+    uint32_t fixed_mclk;    /*!< Fixed MCLK frequency (Hz), same as `fixed_mclk` used to install I2S driver
+                                 Set to 0 if MCLK follows sample rate */
 } codec_i2s_dev_cfg_t;
 
 /**
  * @brief Codec SPI configuration
  */
 typedef struct {
-    uint8_t spi_port; /*!< SPI port, this port need pre-installed by other modules */
-    int16_t cs_pin;   /*!< SPI CS GPIO pin setting */
+    uint8_t  spi_port;    /*!< SPI host port, this port need pre-installed by other modules
+                               Set to 0 to use default host (SPI3_HOST) */
+    int16_t  cs_pin;      /*!< SPI CS GPIO pin setting */
+    uint32_t clock_speed; /*!< SPI clock speed (unit Hz), set to 0 to use default speed 1MHz */
+    bool     use_dma;     /*!< Whether SPI bus is installed with DMA channel,
+                               large payload is sent in DMA transfers if enabled */
 } codec_spi_dev_cfg_t;
 
+/**
+ * @brief Codec register cache description
+ */
+typedef struct {
+    uint16_t       reg_num;       /*!< Number of registers start from address 0 which can be cached */
+    int16_t        reset_reg;     /*!< Register which reset codec, write to it invalidates cache, -1 if not exist */
+    const uint8_t *volatile_mask; /*!< Bitmap of volatile registers (bit n for register n) which always read from codec,
+                                       NULL if all registers are cacheable */
+} codec_reg_cache_desc_t;
+
+/**
+ * @brief Codec control bus type
+ */
+typedef enum {
+    CODEC_BUS_TYPE_I2C, /*!< I2C bus */
+    CODEC_BUS_TYPE_SPI, /*!< SPI bus */
+} codec_bus_type_t;
+
+/**
+ * @brief Codec control bus lock statistics
+ */
+typedef struct {
+    uint32_t acquire_count;    /*!< Times of bus acquired (nested acquire not counted) */
+    uint32_t contention_count; /*!< Times of bus already held by other task when acquire */
+    uint32_t timeout_count;    /*!< Times of fail to acquire bus in time */
+    uint32_t max_wait_us;      /*!< Maximum time waiting for bus (unit us) */
+    uint64_t total_wait_us;    /*!< Total time waiting for bus (unit us) */
+    uint32_t max_hold_us;      /*!< Maximum time bus held in one transaction (unit us) */
+    uint64_t total_hold_us;    /*!< Total time bus held (unit us) */
+} codec_bus_lock_stats_t;
+
 /**
  * @brief Codec working mode
  */
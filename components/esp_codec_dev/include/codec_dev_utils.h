@@ -25,11 +25,55 @@
 #define CODEC_DEV_UTILS_H
 
 #include "codec_dev_types.h"
+#include "audio_codec_ctrl_if.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Register sequence operation
+ */
+typedef enum {
+    CODEC_REG_SEQ_OP_WRITE,       /*!< Write `value` to register `reg` */
+    CODEC_REG_SEQ_OP_UPDATE_BITS, /*!< Update bits selected by `mask` of register `reg` to `value` */
+    CODEC_REG_SEQ_OP_DELAY,       /*!< Delay `value` milliseconds */
+    CODEC_REG_SEQ_OP_IF,          /*!< Run following `value` entries only when condition bit `reg` equals `mask` */
+    CODEC_REG_SEQ_OP_BURST,       /*!< Write `value` bytes packed in following entries to registers from `reg` */
+} codec_reg_seq_op_t;
+
+/**
+ * @brief Register sequence entry
+ *        Kept in 4 bytes so that sequence tables can be constant data in flash
+ *        Use `CODEC_REG_SEQ_XXX` macros to build entries
+ */
+typedef struct {
+    uint8_t op;    /*!< Operation, see `codec_reg_seq_op_t` */
+    uint8_t reg;   /*!< Register address or condition bit index */
+    uint8_t value; /*!< Register value, delay time or entry count */
+    uint8_t mask;  /*!< Bits to update or expected condition value */
+} codec_reg_seq_t;
+
+/**
+ * @brief Register sequence statistics
+ */
+typedef struct {
+    uint16_t writes;       /*!< Registers written */
+    uint16_t reads;        /*!< Registers read for bits update */
+    uint16_t transactions; /*!< Control interface calls for write batches and reads */
+    uint16_t skipped;      /*!< Bits updates skipped for register value unchanged */
+    uint32_t delay_ms;     /*!< Total delay time in milliseconds */
+} codec_reg_seq_stats_t;
+
+#define CODEC_REG_SEQ_WRITE(reg, value)        {CODEC_REG_SEQ_OP_WRITE, (reg), (value), 0xFF}
+#define CODEC_REG_SEQ_UPDATE(reg, mask, value) {CODEC_REG_SEQ_OP_UPDATE_BITS, (reg), (value), (mask)}
+#define CODEC_REG_SEQ_DELAY(ms)                {CODEC_REG_SEQ_OP_DELAY, 0, (ms), 0}
+#define CODEC_REG_SEQ_IF(cond, n)              {CODEC_REG_SEQ_OP_IF, (cond), (n), 1}
+#define CODEC_REG_SEQ_IF_NOT(cond, n)          {CODEC_REG_SEQ_OP_IF, (cond), (n), 0}
+#define CODEC_REG_SEQ_BURST(reg, len)          {CODEC_REG_SEQ_OP_BURST, (reg), (len), 0}
+#define CODEC_REG_SEQ_DATA(d0, d1, d2, d3)     {(d0), (d1), (d2), (d3)}
+#define CODEC_REG_SEQ_NUM(seq)                 (sizeof(seq) / sizeof(seq[0]))
+
 /**
  * @brief         Convert decibel value to register settings
  * @param         vol_range: Volume range
@@ -46,6 +90,75 @@ int audio_codec_calc_vol_reg(const codec_dev_vol_range_t *vol_range, float db);
  */
 float audio_codec_calc_vol_db(const codec_dev_vol_range_t *vol_range, int vol);
 
+/**
+ * @brief         Write register sequence through codec control interface
+ *                Use `write_regs` of control interface if provided, else write registers one by one
+ * @param         ctrl: Codec control interface
+ * @param         seq: Register and value pairs, written in order
+ * @param         n: Number of register and value pairs
+ * @return        CODEC_DEV_OK: Write success
+ *                CODEC_DEV_INVALID_ARG: Invalid arguments
+ *                Others: Fail to write register
+ */
+int audio_codec_write_regs(const audio_codec_ctrl_if_t *ctrl, const codec_reg_val_pair_t *seq, int n);
+
+/**
+ * @brief         Read contiguous registers (8 bits address and data) in one transaction
+ * @param         ctrl: Codec control interface
+ * @param         reg: Start register address
+ * @param         values: Register values read back
+ * @param         n: Number of registers to read
+ * @return        CODEC_DEV_OK: Read success
+ *                CODEC_DEV_INVALID_ARG: Invalid arguments
+ *                Others: Fail to read register
+ */
+int audio_codec_read_regs(const audio_codec_ctrl_if_t *ctrl, uint8_t reg, uint8_t *values, int n);
+
+/**
+ * @brief         Acquire or release control bus for a transaction across several register accesses
+ *                Acquire can be nested in same task, each acquire must be paired with release
+ * @param         ctrl: Codec control interface
+ * @param         acquire: true to acquire bus, false to release
+ * @return        CODEC_DEV_OK: Success or control interface not support bus acquire
+ *                CODEC_DEV_INVALID_ARG: Invalid arguments
+ *                Others: Fail to acquire bus
+ */
+int audio_codec_ctrl_acquire(const audio_codec_ctrl_if_t *ctrl, bool acquire);
+
+/**
+ * @brief         Run register sequence through codec control interface
+ *                Adjacent writes are sent in batch by `audio_codec_write_regs`
+ *                Bits update uses value of pending write directly, else reads register
+ *                Bits update right after write of same register is merged into that write
+ *                Reads and writes go through `ctrl`, so a cache control interface serves reads and drops unchanged writes
+ *                Bits update is skipped when register value not changed
+ *                Control bus is held during the sequence and released during delay
+ * @param         ctrl: Codec control interface
+ * @param         seq: Register sequence
+ * @param         n: Number of sequence entries
+ * @param         cond: Condition bits tested by `CODEC_REG_SEQ_IF` and `CODEC_REG_SEQ_IF_NOT`
+ * @param         stats: Statistics accumulated into, can be NULL
+ * @return        CODEC_DEV_OK: Run success
+ *                CODEC_DEV_INVALID_ARG: Invalid arguments or malformed sequence
+ *                Others: Fail to access register, sequence stops at first failure
+ */
+int audio_codec_run_reg_seq(const audio_codec_ctrl_if_t *ctrl, const codec_reg_seq_t *seq, int n, uint32_t cond,
+                            codec_reg_seq_stats_t *stats);
+
+/**
+ * @brief         Count register accesses of sequence without touching codec (dry run)
+ *                Bits updates not resolved by pending writes are counted as one read and one write
+ *                Each write batch is counted as one transaction like control interface with `write_regs`,
+ *                `audio_codec_run_reg_seq` on interface without it counts one transaction per write instead
+ * @param         seq: Register sequence
+ * @param         n: Number of sequence entries
+ * @param         cond: Condition bits tested by `CODEC_REG_SEQ_IF` and `CODEC_REG_SEQ_IF_NOT`
+ * @param         stats: Statistics accumulated into
+ * @return        CODEC_DEV_OK: Count success
+ *                CODEC_DEV_INVALID_ARG: Invalid arguments or malformed sequence
+ */
+int audio_codec_count_reg_seq(const codec_reg_seq_t *seq, int n, uint32_t cond, codec_reg_seq_stats_t *stats);
+
 #ifdef __cplusplus
 }
 #endif
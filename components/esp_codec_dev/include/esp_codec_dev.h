@@ -40,6 +40,8 @@ typedef struct {
     codec_dev_type_t             dev_type; /*!< Codec device type */
     const audio_codec_if_t      *codec_if; /*!< Codec interface */
     const audio_codec_data_if_t *data_if;  /*!< Codec data interface */
+    bool                         sw_fade;  /*!< Fade output volume in software when codec can not ramp it by hardware
+                                                Codec is kept at top of volume curve, only for 16 bits output */
 } esp_codec_dev_cfg_t;
 
 /**
@@ -69,6 +71,34 @@ typedef struct {
  */
 typedef void *esp_codec_dev_handle_t;
 
+/**
+ * @brief Codec control command which can be executed asynchronously
+ */
+typedef enum {
+    ESP_CODEC_DEV_CTRL_OUT_VOL,  /*!< Set output volume */
+    ESP_CODEC_DEV_CTRL_OUT_MUTE, /*!< Set output mute */
+    ESP_CODEC_DEV_CTRL_IN_GAIN,  /*!< Set input gain */
+    ESP_CODEC_DEV_CTRL_IN_MUTE,  /*!< Set input mute */
+    ESP_CODEC_DEV_CTRL_MAX,
+} esp_codec_dev_ctrl_cmd_t;
+
+/**
+ * @brief Callback when asynchronous control command is executed
+ *        Notes: It is called in control worker context, do not block in it
+ */
+typedef void (*esp_codec_dev_ctrl_done_cb_t)(esp_codec_dev_handle_t codec, esp_codec_dev_ctrl_cmd_t cmd,
+                                             int ret, void *ctx);
+
+/**
+ * @brief Codec asynchronous control configuration
+ */
+typedef struct {
+    int                          task_prio;  /*!< Control worker priority */
+    int                          task_stack; /*!< Control worker stack size, use default size if set to 0 */
+    esp_codec_dev_ctrl_done_cb_t done_cb;    /*!< Callback when command executed (optional) */
+    void                        *ctx;        /*!< User context passed to callback */
+} esp_codec_dev_async_ctrl_cfg_t;
+
 /**
  * @brief         New codec device
  * @param         codec_dev_cfg: Codec device configuration
@@ -81,9 +111,12 @@ esp_codec_dev_handle_t esp_codec_dev_new(esp_codec_dev_cfg_t *codec_dev_cfg);
  * @brief         Open codec device
  * @param         codec: Codec device handle
  * @param         fs: Audio sample information
+ *                    When the other direction already runs on a shared data port, sample rate is updated to its rate
+ *                    if that rate is an integer multiple of the requested one
  * @return        CODEC_DEV_OK: Open success
  *                CODEC_DEV_INVALID_ARG: Invalid arguments
- *                CODEC_DEV_NOT_SUPPORT: Codec not support or driver not ready yet
+ *                CODEC_DEV_NOT_SUPPORT: Codec not support or driver not ready yet,
+ *                                       or format conflicts with the other direction on the same data port
  */
 int esp_codec_dev_open(esp_codec_dev_handle_t codec, codec_sample_info_t *fs);
 
@@ -123,9 +156,10 @@ int esp_codec_dev_write(esp_codec_dev_handle_t codec, void *data, int len);
 int esp_codec_dev_set_hw_gain(esp_codec_dev_handle_t codec, esp_codec_dev_hw_gain_t *hw_gain);
 
 /**
- * @brief         Set codec hardware gain
+ * @brief         Set codec output volume
+ *                If `sw_fade` is set and codec can not ramp volume by hardware, volume change is faded in software
  * @param         codec: Codec device handle
- * @param         hw_gain: Hardware gain setting
+ * @param         volume: Volume setting
  * @return        CODEC_DEV_OK: Set output volume success
  *                CODEC_DEV_INVALID_ARG: Invalid arguments
  *                CODEC_DEV_NOT_SUPPORT: Codec not support output mode
@@ -222,6 +256,22 @@ int esp_codec_dev_set_in_mute(esp_codec_dev_handle_t codec, bool mute);
  */
 int esp_codec_dev_get_in_mute(esp_codec_dev_handle_t codec, bool *muted);
 
+/**
+ * @brief         Enable or disable asynchronous control
+ *                When enabled, output volume, output mute, input gain and input mute settings return immediately
+ *                and are executed by a control worker, so that control bus access not block caller
+ *                Command not executed yet is replaced by new command of same type, only latest setting is applied
+ *                Get APIs return the latest requested setting
+ *                Command for closed direction is kept until direction opened, open and close wait for command in execution
+ * @param         codec: Codec device handle
+ * @param         cfg: Asynchronous control configuration, set to NULL to disable asynchronous control
+ *                     Pending commands are executed before disable return
+ * @return        CODEC_DEV_OK: Set asynchronous control success
+ *                CODEC_DEV_INVALID_ARG: Invalid arguments
+ *                CODEC_DEV_NO_MEM: Fail to create control worker
+ */
+int esp_codec_dev_set_async_ctrl(esp_codec_dev_handle_t codec, esp_codec_dev_async_ctrl_cfg_t *cfg);
+
 /**
  * @brief         Close codec device
  * @param         codec: Codec device handle
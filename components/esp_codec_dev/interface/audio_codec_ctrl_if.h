@@ -42,6 +42,10 @@ struct audio_codec_ctrl_if_t {
                        int addr, int addr_len, void *data, int data_len);
     int (*write_addr)(const audio_codec_ctrl_if_t *ctrl,                     /*!< Write data from codec control */
                        int addr, int addr_len, void *data, int data_len);
+    int (*write_regs)(const audio_codec_ctrl_if_t *ctrl,                     /*!< Write register sequence in one transaction (optional) */
+                       const codec_reg_val_pair_t *seq, int n);
+    int (*acquire_bus)(const audio_codec_ctrl_if_t *ctrl, bool acquire);     /*!< Acquire or release bus so that several accesses
+                                                                                  are not interleaved by other devices (optional) */
     int (*close)(const audio_codec_ctrl_if_t *ctrl);                         /*!< Close codec control interface */
 };
 
@@ -39,7 +39,10 @@ typedef struct audio_codec_data_if_t audio_codec_data_if_t;
 struct audio_codec_data_if_t {
     int (*open)(const audio_codec_data_if_t *h, void *data_cfg, int cfg_size); /*!< Open data interface */
     bool (*is_open)(const audio_codec_data_if_t *h);                           /*!< Check whether data interface is opened */
-    int (*set_fmt)(const audio_codec_data_if_t *h, codec_sample_info_t *fs);   /*!< Set audio format to data interface */
+    int (*set_fmt)(const audio_codec_data_if_t *h, codec_dev_type_t dev_type,
+                   codec_sample_info_t *fs);                                   /*!< Set audio format for input or output direction
+                                                                                    NULL fs to release the direction,
+                                                                                    sample rate actually used is written back to fs */
     int (*read)(const audio_codec_data_if_t *h, uint8_t *data, int size);      /*!< Read data from data interface */
     int (*write)(const audio_codec_data_if_t *h, uint8_t *data, int size);     /*!< Write data to data interface */
     int (*close)(const audio_codec_data_if_t *h);                              /*!< Close data interface */
@@ -32,6 +32,15 @@ extern "C" {
 
 typedef struct audio_codec_if_t audio_codec_if_t;
 
+/**
+ * @brief Codec capability flags reported by `get_caps`
+ */
+typedef enum {
+    CODEC_IF_CAP_NONE = 0,
+    CODEC_IF_CAP_VOL_RAMP = (1 << 0), /*!< Output volume and mute changes are ramped by codec hardware */
+    CODEC_IF_CAP_FIXED_FMT = (1 << 1), /*!< Codec runs at fixed format and converts others, `set_fs` failure not fatal */
+} codec_if_cap_t;
+
 /**
  * @brief Structure for codec interface
  */
@@ -47,6 +56,9 @@ struct audio_codec_if_t {
     int (*set_reg)(const audio_codec_if_t *h, int reg, int value);     /*!< Set register value to codec */
     int (*get_reg)(const audio_codec_if_t *h, int reg, int *value);    /*!< Get register value from codec */
     int (*close)(const audio_codec_if_t *h);                           /*!< Close codec */
+    int (*enable_path)(const audio_codec_if_t *h,                      /*!< Enable input or output path only, preferred over `enable` (optional) */
+                       codec_dev_type_t dev_type, bool enable);
+    int (*get_caps)(const audio_codec_if_t *h, uint32_t *caps);        /*!< Get capability flags of `codec_if_cap_t` (optional) */
 };
 
 /**
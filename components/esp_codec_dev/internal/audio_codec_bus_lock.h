@@ -0,0 +1,71 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#ifndef AUDIO_CODEC_BUS_LOCK_H
+#define AUDIO_CODEC_BUS_LOCK_H
+
+#include "codec_dev_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *audio_codec_bus_lock_t;
+
+/**
+ * @brief         Get lock of shared bus, lock is created when first used and shared by devices on same bus
+ * @param         bus_type: Bus type
+ * @param         port: Bus port
+ * @return        NULL: No memory for lock
+ *                -Others: Bus lock handle
+ */
+audio_codec_bus_lock_t audio_codec_bus_lock_get(codec_bus_type_t bus_type, uint8_t port);
+
+/**
+ * @brief         Acquire bus lock, support nested acquire in same task
+ *                Lock owner inherits priority of waiting tasks to avoid priority inversion
+ * @param         lock: Bus lock handle
+ * @return        CODEC_DEV_OK: Acquire success
+ *                CODEC_DEV_DRV_ERR: Timeout to acquire bus
+ */
+int audio_codec_bus_lock_acquire(audio_codec_bus_lock_t lock);
+
+/**
+ * @brief         Release bus lock
+ * @param         lock: Bus lock handle
+ * @return        CODEC_DEV_OK: Release success
+ *                CODEC_DEV_WRONG_STATE: Lock not held by current task
+ */
+int audio_codec_bus_lock_release(audio_codec_bus_lock_t lock);
+
+/**
+ * @brief         Put bus lock, lock is freed when no device use it
+ * @param         lock: Bus lock handle
+ */
+void audio_codec_bus_lock_put(audio_codec_bus_lock_t lock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
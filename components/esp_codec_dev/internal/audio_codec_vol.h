@@ -51,6 +51,15 @@ audio_codec_vol_handle_t audio_codec_sw_vol_open(codec_sample_info_t *fs, int du
  */
 int audio_codec_sw_vol_set(audio_codec_vol_handle_t h, float db_value);
 
+/**
+ * @brief         Set volume to software volume module without fade
+ * @param         h: Software volume handle
+ * @param         db_value: Volume in decibel
+ * @return        0: On success
+ *                -1: Wrong handle
+ */
+int audio_codec_sw_vol_set_direct(audio_codec_vol_handle_t h, float db_value);
+
 /**
  * @brief         Do volume process
  * @param         h: Software volume handle
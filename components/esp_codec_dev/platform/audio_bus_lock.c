@@ -0,0 +1,204 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "audio_codec_bus_lock.h"
+#include "codec_dev_defaults.h"
+#include "codec_dev_err.h"
+
+#define TAG                  "Bus_Lock"
+
+#define MAX_BUS_LOCK_NUM     (4)
+#define BUS_LOCK_TIMEOUT_MS  (1000)
+
+typedef struct {
+    codec_bus_type_t       bus_type;
+    uint8_t                port;
+    int                    ref_count;
+    SemaphoreHandle_t      mutex;
+    int                    depth;
+    int64_t                acquire_time;
+    codec_bus_lock_stats_t stats;
+} bus_lock_t;
+
+static bus_lock_t *bus_locks[MAX_BUS_LOCK_NUM];
+static portMUX_TYPE bus_lock_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bus_lock_t *_bus_lock_find(codec_bus_type_t bus_type, uint8_t port)
+{
+    for (int i = 0; i < MAX_BUS_LOCK_NUM; i++) {
+        if (bus_locks[i] && bus_locks[i]->bus_type == bus_type && bus_locks[i]->port == port) {
+            return bus_locks[i];
+        }
+    }
+    return NULL;
+}
+
+audio_codec_bus_lock_t audio_codec_bus_lock_get(codec_bus_type_t bus_type, uint8_t port)
+{
+    // Semaphore can not be created in critical section, prepare one before searching
+    bus_lock_t *new_lock = calloc(1, sizeof(bus_lock_t));
+    if (new_lock == NULL) {
+        return NULL;
+    }
+    // Recursive mutex has priority inheritance so low priority owner will not block high priority waiter long
+    new_lock->mutex = xSemaphoreCreateRecursiveMutex();
+    if (new_lock->mutex == NULL) {
+        free(new_lock);
+        return NULL;
+    }
+    new_lock->bus_type = bus_type;
+    new_lock->port = port;
+    portENTER_CRITICAL(&bus_lock_mux);
+    bus_lock_t *lock = _bus_lock_find(bus_type, port);
+    if (lock == NULL) {
+        for (int i = 0; i < MAX_BUS_LOCK_NUM; i++) {
+            if (bus_locks[i] == NULL) {
+                bus_locks[i] = lock = new_lock;
+                new_lock = NULL;
+                break;
+            }
+        }
+    }
+    if (lock) {
+        lock->ref_count++;
+    }
+    portEXIT_CRITICAL(&bus_lock_mux);
+    if (new_lock) {
+        vSemaphoreDelete(new_lock->mutex);
+        free(new_lock);
+    }
+    if (lock == NULL) {
+        ESP_LOGE(TAG, "Too many bus lock try enlarge MAX_BUS_LOCK_NUM(%d)", MAX_BUS_LOCK_NUM);
+    }
+    return (audio_codec_bus_lock_t) lock;
+}
+
+int audio_codec_bus_lock_acquire(audio_codec_bus_lock_t h)
+{
+    bus_lock_t *lock = (bus_lock_t *) h;
+    if (lock == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (xSemaphoreGetMutexHolder(lock->mutex) == xTaskGetCurrentTaskHandle()) {
+        // Nested acquire inside one transaction
+        xSemaphoreTakeRecursive(lock->mutex, 0);
+        lock->depth++;
+        return CODEC_DEV_OK;
+    }
+    int64_t start = esp_timer_get_time();
+    bool contention = false;
+    if (xSemaphoreTakeRecursive(lock->mutex, 0) != pdTRUE) {
+        contention = true;
+        if (xSemaphoreTakeRecursive(lock->mutex, BUS_LOCK_TIMEOUT_MS / portTICK_RATE_MS) != pdTRUE) {
+            portENTER_CRITICAL(&bus_lock_mux);
+            lock->stats.timeout_count++;
+            portEXIT_CRITICAL(&bus_lock_mux);
+            ESP_LOGE(TAG, "Timeout to acquire bus %d port %d", lock->bus_type, lock->port);
+            return CODEC_DEV_DRV_ERR;
+        }
+    }
+    lock->acquire_time = esp_timer_get_time();
+    uint32_t wait_us = (uint32_t) (lock->acquire_time - start);
+    lock->depth = 1;
+    portENTER_CRITICAL(&bus_lock_mux);
+    lock->stats.acquire_count++;
+    if (contention) {
+        lock->stats.contention_count++;
+    }
+    lock->stats.total_wait_us += wait_us;
+    if (wait_us > lock->stats.max_wait_us) {
+        lock->stats.max_wait_us = wait_us;
+    }
+    portEXIT_CRITICAL(&bus_lock_mux);
+    return CODEC_DEV_OK;
+}
+
+int audio_codec_bus_lock_release(audio_codec_bus_lock_t h)
+{
+    bus_lock_t *lock = (bus_lock_t *) h;
+    if (lock == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (xSemaphoreGetMutexHolder(lock->mutex) != xTaskGetCurrentTaskHandle()) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    if (--lock->depth == 0) {
+        uint32_t hold_us = (uint32_t) (esp_timer_get_time() - lock->acquire_time);
+        portENTER_CRITICAL(&bus_lock_mux);
+        lock->stats.total_hold_us += hold_us;
+        if (hold_us > lock->stats.max_hold_us) {
+            lock->stats.max_hold_us = hold_us;
+        }
+        portEXIT_CRITICAL(&bus_lock_mux);
+    }
+    xSemaphoreGiveRecursive(lock->mutex);
+    return CODEC_DEV_OK;
+}
+
+void audio_codec_bus_lock_put(audio_codec_bus_lock_t h)
+{
+    bus_lock_t *lock = (bus_lock_t *) h;
+    if (lock == NULL) {
+        return;
+    }
+    bool need_free = false;
+    portENTER_CRITICAL(&bus_lock_mux);
+    if (--lock->ref_count == 0) {
+        for (int i = 0; i < MAX_BUS_LOCK_NUM; i++) {
+            if (bus_locks[i] == lock) {
+                bus_locks[i] = NULL;
+                break;
+            }
+        }
+        need_free = true;
+    }
+    portEXIT_CRITICAL(&bus_lock_mux);
+    if (need_free) {
+        vSemaphoreDelete(lock->mutex);
+        free(lock);
+    }
+}
+
+int audio_codec_get_bus_lock_stats(codec_bus_type_t bus_type, uint8_t port, codec_bus_lock_stats_t *stats)
+{
+    if (stats == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    int ret = CODEC_DEV_NOT_FOUND;
+    // Copy under spin lock so that reading statistics not disturb bus users
+    portENTER_CRITICAL(&bus_lock_mux);
+    bus_lock_t *lock = _bus_lock_find(bus_type, port);
+    if (lock) {
+        memcpy(stats, &lock->stats, sizeof(codec_bus_lock_stats_t));
+        ret = CODEC_DEV_OK;
+    }
+    portEXIT_CRITICAL(&bus_lock_mux);
+    return ret;
+}
@@ -23,8 +23,80 @@
  */
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "esp_idf_version.h"
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
+#include "esp_rom_sys.h"
+#else
+#include "rom/ets_sys.h"
+#define esp_rom_delay_us ets_delay_us
+#endif
+#include "codec_dev_os.h"
 
 void codec_dev_sleep(int ms)
 {
-    vTaskDelay(ms / portTICK_RATE_MS);
+    // Round up so that short sleep still yields at least one tick
+    vTaskDelay((ms + portTICK_RATE_MS - 1) / portTICK_RATE_MS);
+}
+
+void codec_dev_delay_us(int us)
+{
+    esp_rom_delay_us((uint32_t) us);
+}
+
+uint64_t codec_dev_get_time_us(void)
+{
+    return (uint64_t) esp_timer_get_time();
+}
+
+void *codec_dev_mutex_create(void)
+{
+    return (void *) xSemaphoreCreateMutex();
+}
+
+void codec_dev_mutex_lock(void *mutex)
+{
+    xSemaphoreTake((SemaphoreHandle_t) mutex, portMAX_DELAY);
+}
+
+void codec_dev_mutex_unlock(void *mutex)
+{
+    xSemaphoreGive((SemaphoreHandle_t) mutex);
+}
+
+void codec_dev_mutex_delete(void *mutex)
+{
+    vSemaphoreDelete((SemaphoreHandle_t) mutex);
+}
+
+void *codec_dev_sem_create(void)
+{
+    return (void *) xSemaphoreCreateBinary();
+}
+
+int codec_dev_sem_take(void *sem, int timeout_ms)
+{
+    TickType_t wait_ticks = timeout_ms < 0 ? portMAX_DELAY : timeout_ms / portTICK_RATE_MS;
+    return xSemaphoreTake((SemaphoreHandle_t) sem, wait_ticks) == pdTRUE ? 0 : -1;
+}
+
+void codec_dev_sem_give(void *sem)
+{
+    xSemaphoreGive((SemaphoreHandle_t) sem);
+}
+
+void codec_dev_sem_delete(void *sem)
+{
+    vSemaphoreDelete((SemaphoreHandle_t) sem);
+}
+
+int codec_dev_thread_create(void (*body)(void *arg), const char *name, void *arg, int stack_size, int prio)
+{
+    return xTaskCreate(body, name, stack_size, arg, prio, NULL) == pdPASS ? 0 : -1;
+}
+
+void codec_dev_thread_exit(void)
+{
+    vTaskDelete(NULL);
 }
@@ -24,18 +24,51 @@
 
 #include "audio_codec_ctrl_if.h"
 #include "driver/i2c.h"
+#include "esp_idf_version.h"
 #include "esp_log.h"
 #include "codec_dev_err.h"
+#include "audio_codec_bus_lock.h"
 
-#define TAG "I2C_If"
+#define TAG                 "I2C_If"
+
+#define I2C_MAX_QUEUED_REGS (16)
+
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 4, 0))
+#define I2C_STATIC_CMD_LINK
+/* Each queued register takes at most START, address, register and data commands */
+#define I2C_CMD_LINK_SIZE   I2C_LINK_RECOMMENDED_SIZE(I2C_MAX_QUEUED_REGS)
+#endif
 
 typedef struct {
-    audio_codec_ctrl_if_t base;
-    bool                  is_open;
-    uint8_t               port;
-    uint8_t               addr;
+    audio_codec_ctrl_if_t  base;
+    bool                   is_open;
+    uint8_t                port;
+    uint8_t                addr;
+    audio_codec_bus_lock_t bus_lock;
+#ifdef I2C_STATIC_CMD_LINK
+    uint8_t                cmd_buf[I2C_CMD_LINK_SIZE];
+#endif
 } i2c_ctrl_t;
 
+static i2c_cmd_handle_t _i2c_ctrl_cmd_create(i2c_ctrl_t *i2c_ctrl)
+{
+#ifdef I2C_STATIC_CMD_LINK
+    // Build command in buffer owned by interface to avoid heap allocation on every register access
+    return i2c_cmd_link_create_static(i2c_ctrl->cmd_buf, sizeof(i2c_ctrl->cmd_buf));
+#else
+    return i2c_cmd_link_create();
+#endif
+}
+
+static void _i2c_ctrl_cmd_delete(i2c_cmd_handle_t cmd)
+{
+#ifdef I2C_STATIC_CMD_LINK
+    i2c_cmd_link_delete_static(cmd);
+#else
+    i2c_cmd_link_delete(cmd);
+#endif
+}
+
 int _i2c_ctrl_open(const audio_codec_ctrl_if_t *ctrl, void *cfg, int cfg_size)
 {
     if (ctrl == NULL || cfg == NULL || cfg_size != sizeof(codec_i2c_dev_cfg_t)) {
@@ -45,6 +78,11 @@ int _i2c_ctrl_open(const audio_codec_ctrl_if_t *ctrl, void *cfg, int cfg_size)
     codec_i2c_dev_cfg_t *i2c_cfg = (codec_i2c_dev_cfg_t *) cfg;
     i2c_ctrl->port = i2c_cfg->port;
     i2c_ctrl->addr = i2c_cfg->addr;
+    // Devices on same I2C port share one lock
+    i2c_ctrl->bus_lock = audio_codec_bus_lock_get(CODEC_BUS_TYPE_I2C, i2c_cfg->port);
+    if (i2c_ctrl->bus_lock == NULL) {
+        return CODEC_DEV_NO_MEM;
+    }
     return 0;
 }
 
@@ -59,35 +97,29 @@ bool _i2c_ctrl_is_open(const audio_codec_ctrl_if_t *ctrl)
 
 static int _i2c_ctrl_read_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
 {
-    if (ctrl == NULL || data == NULL) {
+    if (ctrl == NULL || data == NULL || data_len <= 0) {
         return CODEC_DEV_INVALID_ARG;
     }
     i2c_ctrl_t *i2c_ctrl = (i2c_ctrl_t *) ctrl;
     if (i2c_ctrl->is_open == false) {
         return CODEC_DEV_WRONG_STATE;
     }
+    if (audio_codec_bus_lock_acquire(i2c_ctrl->bus_lock) != CODEC_DEV_OK) {
+        return CODEC_DEV_READ_FAIL;
+    }
     esp_err_t ret = ESP_OK;
-    i2c_cmd_handle_t cmd;
-    cmd = i2c_cmd_link_create();
+    // Send register address then use repeated start to read back in one transaction
+    i2c_cmd_handle_t cmd = _i2c_ctrl_cmd_create(i2c_ctrl);
     ret |= i2c_master_start(cmd);
     ret |= i2c_master_write_byte(cmd, i2c_ctrl->addr, 1);
     ret |= i2c_master_write(cmd, (uint8_t *) &addr, addr_len, 1);
-    ret |= i2c_master_stop(cmd);
-    ret |= i2c_master_cmd_begin(i2c_ctrl->port, cmd, 1000 / portTICK_RATE_MS);
-    i2c_cmd_link_delete(cmd);
-
-    cmd = i2c_cmd_link_create();
     ret |= i2c_master_start(cmd);
     ret |= i2c_master_write_byte(cmd, i2c_ctrl->addr | 0x01, 1);
-
-    for (int i = 0; i < data_len - 1; i++) {
-        ret |= i2c_master_read_byte(cmd, (uint8_t *) data + i, 0);
-    }
-    ret |= i2c_master_read_byte(cmd, (uint8_t *) data + (data_len - 1), 1);
-
-    ret = i2c_master_stop(cmd);
-    ret = i2c_master_cmd_begin(i2c_ctrl->port, cmd, 1000 / portTICK_RATE_MS);
-    i2c_cmd_link_delete(cmd);
+    ret |= i2c_master_read(cmd, (uint8_t *) data, data_len, I2C_MASTER_LAST_NACK);
+    ret |= i2c_master_stop(cmd);
+    ret |= i2c_master_cmd_begin(i2c_ctrl->port, cmd, 1000 / portTICK_RATE_MS);
+    _i2c_ctrl_cmd_delete(cmd);
+    audio_codec_bus_lock_release(i2c_ctrl->bus_lock);
     if (ret != 0) {
         ESP_LOGE(TAG, "Fail to read from dev %x", i2c_ctrl->addr);
     }
@@ -103,8 +135,11 @@ static int _i2c_ctrl_write_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int
     if (i2c_ctrl->is_open == false) {
         return CODEC_DEV_WRONG_STATE;
     }
+    if (audio_codec_bus_lock_acquire(i2c_ctrl->bus_lock) != CODEC_DEV_OK) {
+        return CODEC_DEV_WRITE_FAIL;
+    }
     esp_err_t ret = ESP_OK;
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    i2c_cmd_handle_t cmd = _i2c_ctrl_cmd_create(i2c_ctrl);
     ret |= i2c_master_start(cmd);
     ret |= i2c_master_write_byte(cmd, i2c_ctrl->addr, 1);
     ret |= i2c_master_write(cmd, (uint8_t *) &addr, addr_len, 1);
@@ -116,10 +151,67 @@ static int _i2c_ctrl_write_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int
     if (ret != 0) {
         ESP_LOGE(TAG, "Fail to write to dev %x", i2c_ctrl->addr);
     }
-    i2c_cmd_link_delete(cmd);
+    _i2c_ctrl_cmd_delete(cmd);
+    audio_codec_bus_lock_release(i2c_ctrl->bus_lock);
     return ret ? CODEC_DEV_WRITE_FAIL : CODEC_DEV_OK;
 }
 
+static int _i2c_ctrl_write_regs(const audio_codec_ctrl_if_t *ctrl, const codec_reg_val_pair_t *seq, int n)
+{
+    i2c_ctrl_t *i2c_ctrl = (i2c_ctrl_t *) ctrl;
+    if (ctrl == NULL || seq == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (i2c_ctrl->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    // Hold bus during whole sequence so that it is not interleaved by other devices
+    if (audio_codec_bus_lock_acquire(i2c_ctrl->bus_lock) != CODEC_DEV_OK) {
+        return CODEC_DEV_WRITE_FAIL;
+    }
+    esp_err_t ret = ESP_OK;
+    int i = 0;
+    while (i < n && ret == ESP_OK) {
+        // Queue several registers into one command link, consecutive addresses use auto-increment burst
+        // Others are separated by repeated start so that only one STOP is sent
+        i2c_cmd_handle_t cmd = _i2c_ctrl_cmd_create(i2c_ctrl);
+        int queued = 0;
+        while (i < n && queued < I2C_MAX_QUEUED_REGS) {
+            ret |= i2c_master_start(cmd);
+            ret |= i2c_master_write_byte(cmd, i2c_ctrl->addr, 1);
+            ret |= i2c_master_write_byte(cmd, seq[i].reg, 1);
+            do {
+                ret |= i2c_master_write_byte(cmd, seq[i].value, 1);
+                i++;
+                queued++;
+            } while (i < n && queued < I2C_MAX_QUEUED_REGS && seq[i].reg == seq[i - 1].reg + 1);
+        }
+        ret |= i2c_master_stop(cmd);
+        ret |= i2c_master_cmd_begin(i2c_ctrl->port, cmd, 1000 / portTICK_RATE_MS);
+        _i2c_ctrl_cmd_delete(cmd);
+    }
+    audio_codec_bus_lock_release(i2c_ctrl->bus_lock);
+    if (ret != 0) {
+        ESP_LOGE(TAG, "Fail to write registers to dev %x", i2c_ctrl->addr);
+    }
+    return ret ? CODEC_DEV_WRITE_FAIL : CODEC_DEV_OK;
+}
+
+static int _i2c_ctrl_acquire_bus(const audio_codec_ctrl_if_t *ctrl, bool acquire)
+{
+    i2c_ctrl_t *i2c_ctrl = (i2c_ctrl_t *) ctrl;
+    if (ctrl == NULL) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    if (i2c_ctrl->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    if (acquire) {
+        return audio_codec_bus_lock_acquire(i2c_ctrl->bus_lock);
+    }
+    return audio_codec_bus_lock_release(i2c_ctrl->bus_lock);
+}
+
 int _i2c_ctrl_close(const audio_codec_ctrl_if_t *ctrl)
 {
     if (ctrl == NULL) {
@@ -127,6 +219,10 @@ int _i2c_ctrl_close(const audio_codec_ctrl_if_t *ctrl)
     }
     i2c_ctrl_t *i2c_ctrl = (i2c_ctrl_t *) ctrl;
     i2c_ctrl->is_open = false;
+    if (i2c_ctrl->bus_lock) {
+        audio_codec_bus_lock_put(i2c_ctrl->bus_lock);
+        i2c_ctrl->bus_lock = NULL;
+    }
     return 0;
 }
 
@@ -140,6 +236,8 @@ const audio_codec_ctrl_if_t *audio_codec_new_i2c_ctrl_if(codec_i2c_dev_cfg_t *i2
     ctrl->base.is_open = _i2c_ctrl_is_open;
     ctrl->base.read_addr = _i2c_ctrl_read_addr;
     ctrl->base.write_addr = _i2c_ctrl_write_addr;
+    ctrl->base.write_regs = _i2c_ctrl_write_regs;
+    ctrl->base.acquire_bus = _i2c_ctrl_acquire_bus;
     ctrl->base.close = _i2c_ctrl_close;
     int ret = _i2c_ctrl_open(&ctrl->base, i2c_cfg, sizeof(codec_i2c_dev_cfg_t));
     if (ret != 0) {
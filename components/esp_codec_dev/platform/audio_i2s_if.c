@@ -29,13 +29,19 @@
 #include "codec_dev_err.h"
 #include <string.h>
 
-#define TAG "I2S_IF"
+#define TAG                 "I2S_IF"
+
+#define I2S_DEFAULT_MCLK_MUL (256)
 
 typedef struct {
     audio_codec_data_if_t base;
     bool                  is_open;
     uint8_t               port;
-    codec_sample_info_t   fs;
+    uint16_t              mclk_multiple;
+    uint32_t              fixed_mclk;
+    codec_sample_info_t   in_fs;  /* Format RX path runs on, sample_rate 0 means not used */
+    codec_sample_info_t   out_fs; /* Format TX path runs on, sample_rate 0 means not used */
+    codec_sample_info_t   fs;     /* Format currently programmed into the shared port clock */
 } i2s_data_t;
 
 int _i2s_data_open(const audio_codec_data_if_t *h, void *data_cfg, int cfg_size)
@@ -47,6 +53,8 @@ int _i2s_data_open(const audio_codec_data_if_t *h, void *data_cfg, int cfg_size)
     codec_i2s_dev_cfg_t *i2s_cfg = (codec_i2s_dev_cfg_t *) data_cfg;
     i2s_data->is_open = true;
     i2s_data->port = i2s_cfg->port;
+    i2s_data->mclk_multiple = i2s_cfg->mclk_multiple ? i2s_cfg->mclk_multiple : I2S_DEFAULT_MCLK_MUL;
+    i2s_data->fixed_mclk = i2s_cfg->fixed_mclk;
     return CODEC_DEV_OK;
 }
 
@@ -59,23 +67,100 @@ bool _i2s_data_is_open(const audio_codec_data_if_t *h)
     return false;
 }
 
-int _i2s_data_set_fmt(const audio_codec_data_if_t *h, codec_sample_info_t *fs)
+static int _i2s_data_negotiate(i2s_data_t *i2s_data, codec_dev_type_t dev_type, codec_sample_info_t *fs,
+                               codec_sample_info_t *port_fs)
+{
+    // Direction not being set and still in use keeps the clock it already runs on
+    bool other_running = ((dev_type & CODEC_DEV_TYPE_IN) == 0 && i2s_data->in_fs.sample_rate) ||
+                         ((dev_type & CODEC_DEV_TYPE_OUT) == 0 && i2s_data->out_fs.sample_rate);
+    if (other_running == false) {
+        memcpy(port_fs, fs, sizeof(codec_sample_info_t));
+        port_fs->mclk = 0;
+        return CODEC_DEV_OK;
+    }
+    memcpy(port_fs, &i2s_data->fs, sizeof(codec_sample_info_t));
+    // TX and RX share one clock on the port, slot width and channel must be the same
+    if (fs->bits_per_sample != port_fs->bits_per_sample || fs->channel != port_fs->channel) {
+        ESP_LOGE(TAG, "I2S %d format conflict, request bits:%d channel:%d running bits:%d channel:%d", i2s_data->port,
+                 fs->bits_per_sample, fs->channel, port_fs->bits_per_sample, port_fs->channel);
+        return CODEC_DEV_NOT_SUPPORT;
+    }
+    // Accept rate which running rate is integer multiple of, so that only integer conversion is needed
+    if (fs->sample_rate == 0 || port_fs->sample_rate % fs->sample_rate) {
+        ESP_LOGE(TAG, "I2S %d rate conflict, request %d running %d", i2s_data->port, fs->sample_rate,
+                 port_fs->sample_rate);
+        return CODEC_DEV_NOT_SUPPORT;
+    }
+    return CODEC_DEV_OK;
+}
+
+static uint32_t _i2s_data_get_mclk(i2s_data_t *i2s_data, codec_sample_info_t *port_fs)
+{
+    // I2S driver derives MCLK from settings when installed, report it so that codec selects matched clock divider
+    uint32_t mclk = i2s_data->fixed_mclk ? i2s_data->fixed_mclk : port_fs->sample_rate * i2s_data->mclk_multiple;
+    uint32_t bclk = port_fs->sample_rate * port_fs->bits_per_sample * 2;
+    if (bclk && mclk % bclk) {
+        ESP_LOGW(TAG, "I2S %d MCLK %d not integer multiple of BCLK %d, set mclk_multiple to 384 for 24 bits",
+                 i2s_data->port, mclk, bclk);
+    }
+    return mclk;
+}
+
+int _i2s_data_set_fmt(const audio_codec_data_if_t *h, codec_dev_type_t dev_type, codec_sample_info_t *fs)
 {
     i2s_data_t *i2s_data = (i2s_data_t *) h;
-    if (i2s_data == NULL) {
+    if (i2s_data == NULL || (dev_type & CODEC_DEV_TYPE_IN_OUT) == 0) {
         return CODEC_DEV_INVALID_ARG;
     }
     if (i2s_data->is_open == false) {
         return CODEC_DEV_WRONG_STATE;
     }
-    if (memcmp(&i2s_data->fs, fs, sizeof(codec_sample_info_t))) {
-        ESP_LOGI(TAG, "I2S %d sample rate:%d channel:%d bits:%d", i2s_data->port, fs->sample_rate, fs->channel,
-                 fs->bits_per_sample);
-        i2s_set_clk(i2s_data->port, fs->sample_rate, fs->bits_per_sample, fs->channel);
+    if (fs == NULL) {
+        // Release direction, remaining direction keeps running on current clock
+        if (dev_type & CODEC_DEV_TYPE_IN) {
+            memset(&i2s_data->in_fs, 0, sizeof(codec_sample_info_t));
+        }
+        if (dev_type & CODEC_DEV_TYPE_OUT) {
+            memset(&i2s_data->out_fs, 0, sizeof(codec_sample_info_t));
+        }
+        if (i2s_data->in_fs.sample_rate == 0 && i2s_data->out_fs.sample_rate == 0) {
+            // Both directions released, reprogram on next use
+            memset(&i2s_data->fs, 0, sizeof(codec_sample_info_t));
+        }
+        return CODEC_DEV_OK;
+    }
+    codec_sample_info_t port_fs;
+    int ret = _i2s_data_negotiate(i2s_data, dev_type, fs, &port_fs);
+    if (ret != CODEC_DEV_OK) {
+        return ret;
+    }
+    if (port_fs.mclk == 0) {
+        port_fs.mclk = _i2s_data_get_mclk(i2s_data, &port_fs);
+    }
+    if (memcmp(&i2s_data->fs, &port_fs, sizeof(codec_sample_info_t))) {
+        ESP_LOGI(TAG, "I2S %d sample rate:%d channel:%d bits:%d mclk:%d", i2s_data->port, port_fs.sample_rate,
+                 port_fs.channel, port_fs.bits_per_sample, port_fs.mclk);
+        ret = i2s_set_clk(i2s_data->port, port_fs.sample_rate, port_fs.bits_per_sample, port_fs.channel);
+        if (ret != 0) {
+            return CODEC_DEV_DRV_ERR;
+        }
         i2s_zero_dma_buffer(i2s_data->port);
-        memcpy(&i2s_data->fs, fs, sizeof(codec_sample_info_t));
+        memcpy(&i2s_data->fs, &port_fs, sizeof(codec_sample_info_t));
+    }
+    if (fs->sample_rate != port_fs.sample_rate) {
+        ESP_LOGW(TAG, "I2S %d request rate %d run at shared rate %d", i2s_data->port, fs->sample_rate,
+                 port_fs.sample_rate);
+        fs->sample_rate = port_fs.sample_rate;
+    }
+    fs->mclk = port_fs.mclk;
+    // Keep format the direction actually runs on
+    if (dev_type & CODEC_DEV_TYPE_IN) {
+        memcpy(&i2s_data->in_fs, fs, sizeof(codec_sample_info_t));
     }
-    return -1;
+    if (dev_type & CODEC_DEV_TYPE_OUT) {
+        memcpy(&i2s_data->out_fs, fs, sizeof(codec_sample_info_t));
+    }
+    return CODEC_DEV_OK;
 }
 
 int _i2s_data_read(const audio_codec_data_if_t *h, uint8_t *data, int size)
@@ -112,6 +197,8 @@ int _i2s_data_close(const audio_codec_data_if_t *h)
     if (i2s_data == NULL) {
         return CODEC_DEV_INVALID_ARG;
     }
+    memset(&i2s_data->in_fs, 0, sizeof(codec_sample_info_t));
+    memset(&i2s_data->out_fs, 0, sizeof(codec_sample_info_t));
     memset(&i2s_data->fs, 0, sizeof(codec_sample_info_t));
     i2s_data->is_open = false;
     return CODEC_DEV_OK;
@@ -22,21 +22,42 @@
  *
  */
 
+#include <string.h>
 #include "audio_codec_ctrl_if.h"
 #include "driver/spi_common.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "esp_heap_caps.h"
+#include "esp_idf_version.h"
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0))
+#include "esp_memory_utils.h"
+#else
+#include "soc/soc_memory_layout.h"
+#endif
 #include "codec_dev_err.h"
+#include "audio_codec_bus_lock.h"
 #include "esp_err.h"
 #include "esp_log.h"
 
-#define TAG "SPI_If"
+#define TAG                   "SPI_If"
+
+/* Transfer with data not exceed this size use polling mode to avoid interrupt and task switch overhead */
+#define SPI_POLLING_MAX_BYTES (32)
+
+#define SPI_DEFAULT_SPEED     (1000000)
+#define SPI_QUEUE_SIZE        (6)
+/* Maximum bytes of one transaction, without DMA data is limited by hardware buffer size */
+#define SPI_CPU_CHUNK_SIZE    (64)
+#define SPI_DMA_CHUNK_SIZE    (4092)
 
 typedef struct {
-    audio_codec_ctrl_if_t base;
-    bool                  is_open;
-    uint8_t               port;
-    spi_device_handle_t   spi_handle;
+    audio_codec_ctrl_if_t  base;
+    bool                   is_open;
+    uint8_t                port;
+    spi_device_handle_t    spi_handle;
+    audio_codec_bus_lock_t bus_lock;
+    int                    acquire_depth;
+    bool                   use_dma;
 } spi_ctrl_t;
 
 int _spi_ctrl_open(const audio_codec_ctrl_if_t *ctrl, void *cfg, int cfg_size)
@@ -50,19 +71,30 @@ int _spi_ctrl_open(const audio_codec_ctrl_if_t *ctrl, void *cfg, int cfg_size)
     spi_ctrl_t *spi_ctrl = (spi_ctrl_t *) ctrl;
     codec_spi_dev_cfg_t *spi_cfg = (codec_spi_dev_cfg_t *) cfg;
     spi_device_interface_config_t dev_cfg = {
-        .clock_speed_hz = 1000000, // Clock out at 10 MHz
-        .mode = 0,                 // SPI mode 0
-        .queue_size = 6,           // queue 7 transactions at a time
+        .clock_speed_hz = spi_cfg->clock_speed ? spi_cfg->clock_speed : SPI_DEFAULT_SPEED,
+        .mode = 0,                    // SPI mode 0
+        .queue_size = SPI_QUEUE_SIZE, // Transactions can be queued at a time
     };
     dev_cfg.spics_io_num = spi_cfg->cs_pin;
-    int ret;
+    spi_host_device_t host = (spi_host_device_t) spi_cfg->spi_port;
+    if (spi_cfg->spi_port == 0) {
 #if (ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(4, 0, 0))
-    ret = spi_bus_add_device(HSPI_HOST, &dev_cfg, &spi_ctrl->spi_handle);
+        host = HSPI_HOST;
 #else
-    ret = spi_bus_add_device(SPI3_HOST, &dev_cfg, &spi_ctrl->spi_handle);
+        host = SPI3_HOST;
 #endif
+    }
+    int ret = spi_bus_add_device(host, &dev_cfg, &spi_ctrl->spi_handle);
     if (ret == 0) {
+        spi_ctrl->port = (uint8_t) host;
+        spi_ctrl->use_dma = spi_cfg->use_dma;
         gpio_set_pull_mode(spi_cfg->cs_pin, GPIO_FLOATING);
+        spi_ctrl->bus_lock = audio_codec_bus_lock_get(CODEC_BUS_TYPE_SPI, spi_ctrl->port);
+        if (spi_ctrl->bus_lock == NULL) {
+            spi_bus_remove_device(spi_ctrl->spi_handle);
+            spi_ctrl->spi_handle = NULL;
+            return CODEC_DEV_NO_MEM;
+        }
         spi_ctrl->is_open = true;
     }
     return ret == 0 ? CODEC_DEV_OK : CODEC_DEV_DRV_ERR;
@@ -77,65 +109,200 @@ bool _spi_ctrl_is_open(const audio_codec_ctrl_if_t *ctrl)
     return false;
 }
 
-static int _spi_ctrl_read_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
+static int _spi_ctrl_acquire(spi_ctrl_t *spi_ctrl, bool acquire)
 {
-    if (ctrl == NULL) {
-        return CODEC_DEV_INVALID_ARG;
+    if (acquire) {
+        int ret = audio_codec_bus_lock_acquire(spi_ctrl->bus_lock);
+        if (ret != CODEC_DEV_OK) {
+            return ret;
+        }
+        // Occupy SPI bus also so that devices not use codec bus lock can not insert transaction
+        if (spi_ctrl->acquire_depth++ == 0) {
+            if (spi_device_acquire_bus(spi_ctrl->spi_handle, portMAX_DELAY) != ESP_OK) {
+                spi_ctrl->acquire_depth--;
+                audio_codec_bus_lock_release(spi_ctrl->bus_lock);
+                return CODEC_DEV_DRV_ERR;
+            }
+        }
+        return CODEC_DEV_OK;
     }
-    spi_ctrl_t *spi_ctrl = (spi_ctrl_t *) ctrl;
-    if (spi_ctrl->is_open == false) {
+    if (spi_ctrl->acquire_depth == 0) {
         return CODEC_DEV_WRONG_STATE;
     }
+    if (--spi_ctrl->acquire_depth == 0) {
+        spi_device_release_bus(spi_ctrl->spi_handle);
+    }
+    return audio_codec_bus_lock_release(spi_ctrl->bus_lock);
+}
+
+static uint16_t _spi_ctrl_addr_word(int addr, int idx)
+{
+    // Address words are stored in bus byte order, command and address phase send value MSB first
+    uint16_t v = ((uint16_t *) &addr)[idx];
+    return (v >> 8) | ((v & 0xFF) << 8);
+}
+
+static void _spi_ctrl_fill_addr(spi_transaction_ext_t *t, int addr, int addr_len)
+{
+    // Send address words use command and address phase so that no extra transaction needed
+    t->base.flags |= SPI_TRANS_VARIABLE_CMD | SPI_TRANS_VARIABLE_ADDR;
+    if (addr_len >= 2) {
+        t->command_bits = 16;
+        t->base.cmd = _spi_ctrl_addr_word(addr, 0);
+    }
+    if (addr_len >= 4) {
+        t->address_bits = 16;
+        t->base.addr = _spi_ctrl_addr_word(addr, 1);
+    }
+}
+
+static void _spi_ctrl_fill_data(spi_transaction_ext_t *t, uint8_t *tx_data, uint8_t *rx_data, int len)
+{
+    t->base.length = len * 8;
+    t->base.tx_buffer = tx_data;
+    if (rx_data) {
+        t->base.rxlength = len * 8;
+        t->base.rx_buffer = rx_data;
+    }
+}
+
+static esp_err_t _spi_ctrl_queue_transfer(spi_ctrl_t *spi_ctrl, int addr, int addr_len, uint8_t *tx_data,
+                                          uint8_t *rx_data, int data_len)
+{
+    spi_transaction_ext_t trans[SPI_QUEUE_SIZE];
+    int chunk_size = spi_ctrl->use_dma ? SPI_DMA_CHUNK_SIZE : SPI_CPU_CHUNK_SIZE;
+#ifndef SPI_TRANS_CS_KEEP_ACTIVE
+    // Can not keep CS between transactions, send all data in one transaction
+    chunk_size = data_len;
+#endif
     esp_err_t ret = ESP_OK;
-    if (addr_len) {
-        uint16_t *v = (uint16_t *) &addr;
-        while (addr_len >= 2) {
-            spi_transaction_t t = {0};
-            t.length = 2 * 8;
-            t.tx_buffer = v;
-            ret = spi_device_transmit(spi_ctrl->spi_handle, &t);
-            v++;
-            addr_len -= 2;
+    int offset = 0;
+    int queued = 0;
+    int done = 0;
+    // Queue chunks back to back, CS is kept active until last chunk finished
+    while (done < queued || offset < data_len) {
+        if (offset < data_len && queued - done < SPI_QUEUE_SIZE && ret == ESP_OK) {
+            spi_transaction_ext_t *t = &trans[queued % SPI_QUEUE_SIZE];
+            memset(t, 0, sizeof(spi_transaction_ext_t));
+            int len = data_len - offset > chunk_size ? chunk_size : data_len - offset;
+            if (offset == 0) {
+                _spi_ctrl_fill_addr(t, addr, addr_len);
+            }
+            _spi_ctrl_fill_data(t, tx_data ? tx_data + offset : NULL, rx_data ? rx_data + offset : NULL, len);
+            offset += len;
+#ifdef SPI_TRANS_CS_KEEP_ACTIVE
+            if (offset < data_len) {
+                t->base.flags |= SPI_TRANS_CS_KEEP_ACTIVE;
+            }
+#endif
+            ret = spi_device_queue_trans(spi_ctrl->spi_handle, &t->base, portMAX_DELAY);
+            if (ret == ESP_OK) {
+                queued++;
+            }
+            continue;
+        }
+        if (done == queued) {
+            break;
         }
+        spi_transaction_t *finished = NULL;
+        ret |= spi_device_get_trans_result(spi_ctrl->spi_handle, &finished, portMAX_DELAY);
+        done++;
     }
-    if (data_len) {
-        spi_transaction_t t = {0};
-        t.length = data_len * 8;
-        t.rxlength = data_len * 8;
-        t.rx_buffer = data;
-        ret = spi_device_transmit(spi_ctrl->spi_handle, &t);
+    return ret;
+}
+
+static esp_err_t _spi_ctrl_bulk_transfer(spi_ctrl_t *spi_ctrl, int addr, int addr_len, uint8_t *tx_data,
+                                         uint8_t *rx_data, int data_len)
+{
+    uint8_t *buf = tx_data ? tx_data : rx_data;
+    uint8_t *dma_buf = NULL;
+    if (spi_ctrl->use_dma && esp_ptr_dma_capable(buf) == false) {
+        // DMA can only access internal memory, copy into bounce buffer
+        dma_buf = (uint8_t *) heap_caps_malloc(data_len, MALLOC_CAP_DMA);
+        if (dma_buf == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        if (tx_data) {
+            memcpy(dma_buf, tx_data, data_len);
+        }
+    }
+    esp_err_t ret;
+    if (dma_buf) {
+        ret = _spi_ctrl_queue_transfer(spi_ctrl, addr, addr_len, tx_data ? dma_buf : NULL,
+                                       rx_data ? dma_buf : NULL, data_len);
+        if (rx_data && ret == ESP_OK) {
+            memcpy(rx_data, dma_buf, data_len);
+        }
+        heap_caps_free(dma_buf);
+    } else {
+        ret = _spi_ctrl_queue_transfer(spi_ctrl, addr, addr_len, tx_data, rx_data, data_len);
+    }
+    return ret;
+}
+
+static int _spi_ctrl_transfer(spi_ctrl_t *spi_ctrl, int addr, int addr_len, void *tx_data, void *rx_data, int data_len)
+{
+    if (_spi_ctrl_acquire(spi_ctrl, true) != CODEC_DEV_OK) {
+        return CODEC_DEV_DRV_ERR;
+    }
+    esp_err_t ret;
+    if (data_len <= SPI_POLLING_MAX_BYTES) {
+        spi_transaction_ext_t t = {0};
+        _spi_ctrl_fill_addr(&t, addr, addr_len);
+        if (data_len) {
+            _spi_ctrl_fill_data(&t, (uint8_t *) tx_data, (uint8_t *) rx_data, data_len);
+        }
+        ret = spi_device_polling_transmit(spi_ctrl->spi_handle, &t.base);
+    } else {
+        ret = _spi_ctrl_bulk_transfer(spi_ctrl, addr, addr_len, (uint8_t *) tx_data, (uint8_t *) rx_data, data_len);
+    }
+    _spi_ctrl_acquire(spi_ctrl, false);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Fail to transfer %d bytes ret %d", data_len, ret);
     }
     return ret == ESP_OK ? CODEC_DEV_OK : CODEC_DEV_DRV_ERR;
 }
 
+static int _spi_ctrl_read_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
+{
+    if (ctrl == NULL || (data == NULL && data_len)) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    spi_ctrl_t *spi_ctrl = (spi_ctrl_t *) ctrl;
+    if (spi_ctrl->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    if (addr_len > sizeof(int) || (addr_len & 1)) {
+        return CODEC_DEV_NOT_SUPPORT;
+    }
+    return _spi_ctrl_transfer(spi_ctrl, addr, addr_len, NULL, data, data_len);
+}
+
 static int _spi_ctrl_write_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
 {
     spi_ctrl_t *spi_ctrl = (spi_ctrl_t *) ctrl;
-    if (ctrl == NULL) {
+    if (ctrl == NULL || (data == NULL && data_len)) {
         return CODEC_DEV_INVALID_ARG;
     }
     if (spi_ctrl->is_open == false) {
         return CODEC_DEV_WRONG_STATE;
     }
-    esp_err_t ret = ESP_OK;
-    if (addr_len) {
-        uint16_t *v = (uint16_t *) &addr;
-        while (addr_len >= 2) {
-            spi_transaction_t t = {0};
-            t.length = 2 * 8;
-            t.tx_buffer = v;
-            ret = spi_device_transmit(spi_ctrl->spi_handle, &t);
-            v++;
-            addr_len -= 2;
-        }
+    if (addr_len > sizeof(int) || (addr_len & 1)) {
+        return CODEC_DEV_NOT_SUPPORT;
     }
-    if (data_len) {
-        spi_transaction_t t = {0};
-        t.length = data_len * 8;
-        t.tx_buffer = data;
-        ret = spi_device_transmit(spi_ctrl->spi_handle, &t);
+    return _spi_ctrl_transfer(spi_ctrl, addr, addr_len, data, NULL, data_len);
+}
+
+static int _spi_ctrl_acquire_bus(const audio_codec_ctrl_if_t *ctrl, bool acquire)
+{
+    spi_ctrl_t *spi_ctrl = (spi_ctrl_t *) ctrl;
+    if (ctrl == NULL) {
+        return CODEC_DEV_INVALID_ARG;
     }
-    return ret == ESP_OK ? CODEC_DEV_OK : CODEC_DEV_DRV_ERR;
+    if (spi_ctrl->is_open == false) {
+        return CODEC_DEV_WRONG_STATE;
+    }
+    return _spi_ctrl_acquire(spi_ctrl, acquire);
 }
 
 int _spi_ctrl_close(const audio_codec_ctrl_if_t *ctrl)
@@ -147,6 +314,11 @@ int _spi_ctrl_close(const audio_codec_ctrl_if_t *ctrl)
     int ret = 0;
     if (spi_ctrl->spi_handle) {
         ret = spi_bus_remove_device(spi_ctrl->spi_handle);
+        spi_ctrl->spi_handle = NULL;
+    }
+    if (spi_ctrl->bus_lock) {
+        audio_codec_bus_lock_put(spi_ctrl->bus_lock);
+        spi_ctrl->bus_lock = NULL;
     }
     spi_ctrl->is_open = false;
     return ret == ESP_OK ? CODEC_DEV_OK : CODEC_DEV_DRV_ERR;
@@ -162,6 +334,7 @@ const audio_codec_ctrl_if_t *audio_codec_new_spi_ctrl_if(codec_spi_dev_cfg_t *sp
     ctrl->base.is_open = _spi_ctrl_is_open;
     ctrl->base.read_addr = _spi_ctrl_read_addr;
     ctrl->base.write_addr = _spi_ctrl_write_addr;
+    ctrl->base.acquire_bus = _spi_ctrl_acquire_bus;
     ctrl->base.close = _spi_ctrl_close;
     int ret = _spi_ctrl_open(&ctrl->base, spi_cfg, sizeof(codec_spi_dev_cfg_t));
     if (ret != 0) {
@@ -9,6 +9,10 @@
 #include "unity.h"
 #include "test_utils.h"
 #include "esp_codec_dev.h"
+#include "codec_dev_utils.h"
+#include "codec_dev_defaults.h"
+#include "codec_dev_os.h"
+#include "driver/i2s.h"
 
 /*
  * Customized codec realization
@@ -30,6 +34,7 @@ typedef struct {
 typedef struct {
     audio_codec_data_if_t base;
     codec_sample_info_t   fmt;
+    codec_dev_type_t      fmt_type;
     int                   read_idx;
     int                   write_idx;
     bool                  is_open;
@@ -45,6 +50,11 @@ typedef struct {
     codec_sample_info_t          fs;
     bool                         is_open;
     bool                         enable;
+    codec_dev_type_t             enabled_path;
+    uint32_t                     fixed_rate;
+    uint32_t                     caps;
+    int                          vol_delay;
+    int                          vol_on_disabled;
 } my_codec_t;
 
 /*
@@ -62,9 +72,16 @@ static bool my_codec_data_is_open(const audio_codec_data_if_t *h)
     return data_if->is_open;
 }
 
-static int my_codec_data_set_fmt(const audio_codec_data_if_t *h, codec_sample_info_t *fs)
+static int my_codec_data_set_fmt(const audio_codec_data_if_t *h, codec_dev_type_t dev_type, codec_sample_info_t *fs)
 {
     my_codec_data_t *data_if = (my_codec_data_t *) h;
+    data_if->fmt_type = dev_type;
+    if (fs == NULL) {
+        memset(&data_if->fmt, 0, sizeof(codec_sample_info_t));
+        return 0;
+    }
+    // Report MCLK as real I2S driver does, codec should use it to configure clock
+    fs->mclk = fs->sample_rate * 384;
     memcpy(&data_if->fmt, fs, sizeof(codec_sample_info_t));
     return 0;
 }
@@ -195,13 +212,35 @@ static int my_codec_enable(const audio_codec_if_t *h, bool enable)
     return 0;
 }
 
+static int my_codec_enable_path(const audio_codec_if_t *h, codec_dev_type_t dev_type, bool enable)
+{
+    my_codec_t *codec = (my_codec_t *) h;
+    if (enable) {
+        codec->enabled_path |= dev_type;
+    } else {
+        codec->enabled_path &= ~dev_type;
+    }
+    return 0;
+}
+
 static int my_codec_set_fs(const audio_codec_if_t *h, codec_sample_info_t *fs)
 {
     my_codec_t *codec = (my_codec_t *) h;
+    // Codec with fixed format rejects other sample rate
+    if (codec->fixed_rate && fs->sample_rate != codec->fixed_rate) {
+        return CODEC_DEV_NOT_SUPPORT;
+    }
     memcpy(&codec->fs, fs, sizeof(codec_sample_info_t));
     return 0;
 }
 
+static int my_codec_get_caps(const audio_codec_if_t *h, uint32_t *caps)
+{
+    my_codec_t *codec = (my_codec_t *) h;
+    *caps = codec->caps;
+    return 0;
+}
+
 static int my_codec_mute(const audio_codec_if_t *h, bool mute)
 {
     my_codec_t *codec = (my_codec_t *) h;
@@ -212,6 +251,13 @@ static int my_codec_mute(const audio_codec_if_t *h, bool mute)
 static int my_codec_set_vol(const audio_codec_if_t *h, float db)
 {
     my_codec_t *codec = (my_codec_t *) h;
+    // Simulate slow control bus
+    if (codec->vol_delay) {
+        codec_dev_sleep(codec->vol_delay);
+    }
+    if ((codec->enabled_path & CODEC_DEV_TYPE_OUT) == 0) {
+        codec->vol_on_disabled++;
+    }
     uint8_t data = (uint8_t) (int) db;
     return codec->ctrl_if->write_addr(codec->ctrl_if, MY_CODEC_REG_VOL, 1, &data, 1);
 }
@@ -265,6 +311,7 @@ const audio_codec_if_t *my_codec_new(my_codec_cfg_t *codec_cfg)
     codec->base.open = my_codec_open;
     codec->base.is_open = my_codec_is_open;
     codec->base.enable = my_codec_enable;
+    codec->base.enable_path = my_codec_enable_path;
     codec->base.set_fs = my_codec_set_fs;
     codec->base.mute = my_codec_mute;
     codec->base.set_vol = my_codec_set_vol;
@@ -273,6 +320,8 @@ const audio_codec_if_t *my_codec_new(my_codec_cfg_t *codec_cfg)
     codec->base.set_reg = my_codec_set_reg;
     codec->base.get_reg = my_codec_get_reg;
     codec->base.close = my_codec_close;
+    codec->base.get_caps = my_codec_get_caps;
+    codec->caps = CODEC_IF_CAP_VOL_RAMP;
     codec->base.open(&codec->base, codec_cfg, sizeof(my_codec_cfg_t));
     return &codec->base;
 }
@@ -308,6 +357,12 @@ TEST_CASE("esp codec dev API test", "[esp_codec_dev]")
     };
     int ret = esp_codec_dev_open(dev, &fs);
     TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(CODEC_DEV_TYPE_IN_OUT, codec_data->fmt_type);
+    TEST_ASSERT_EQUAL(48000, codec_data->fmt.sample_rate);
+    // Codec clock configured after data interface with same sample rate and MCLK
+    my_codec_t *codec = (my_codec_t *) codec_if;
+    TEST_ASSERT_EQUAL(48000, codec->fs.sample_rate);
+    TEST_ASSERT_EQUAL(48000 * 384, codec->fs.mclk);
     codec_dev_vol_map_t vol_maps[2] = {
         {.vol = 0,   .db_value = 0  },
         {.vol = 100, .db_value = 100},
@@ -370,6 +425,16 @@ TEST_CASE("esp codec dev API test", "[esp_codec_dev]")
 
     esp_codec_dev_close(dev);
 
+    // Mono open configures data interface and codec with one channel
+    fs.channel = 1;
+    ret = esp_codec_dev_open(dev, &fs);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(1, codec_data->fmt.channel);
+    TEST_ASSERT_EQUAL(1, codec->fs.channel);
+    ret = esp_codec_dev_write(dev, data, 512);
+    TEST_ESP_OK(ret);
+    esp_codec_dev_close(dev);
+
     // Test for volume curve settings
     ret = esp_codec_dev_set_vol_curve(dev, &vol_curve);
     TEST_ASSERT(ret == 0);
@@ -407,6 +472,194 @@ TEST_CASE("esp codec dev API test", "[esp_codec_dev]")
     audio_codec_delete_data_if(data_if);
 }
 
+TEST_CASE("esp codec dev shared codec path test", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    const audio_codec_data_if_t *data_if = my_codec_data_new();
+    TEST_ASSERT_NOT_NULL(data_if);
+    my_codec_cfg_t codec_cfg = {
+        .ctrl_if = ctrl_if,
+    };
+    const audio_codec_if_t *codec_if = my_codec_new(&codec_cfg);
+    TEST_ASSERT_NOT_NULL(codec_if);
+    my_codec_t *codec = (my_codec_t *) codec_if;
+    // Playback and record devices share one codec
+    esp_codec_dev_cfg_t dev_cfg = {
+        .dev_type = CODEC_DEV_TYPE_OUT,
+        .codec_if = codec_if,
+        .data_if = data_if,
+    };
+    esp_codec_dev_handle_t play_dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(play_dev);
+    dev_cfg.dev_type = CODEC_DEV_TYPE_IN;
+    esp_codec_dev_handle_t rec_dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(rec_dev);
+
+    codec_sample_info_t fs = {
+        .bits_per_sample = 16,
+        .sample_rate = 16000,
+        .channel = 1,
+    };
+    // Only path of opened device is enabled
+    TEST_ESP_OK(esp_codec_dev_open(play_dev, &fs));
+    TEST_ASSERT_EQUAL(CODEC_DEV_TYPE_OUT, codec->enabled_path);
+    TEST_ESP_OK(esp_codec_dev_open(rec_dev, &fs));
+    TEST_ASSERT_EQUAL(CODEC_DEV_TYPE_IN_OUT, codec->enabled_path);
+    // Closing one device keeps path of the other running
+    TEST_ESP_OK(esp_codec_dev_close(play_dev));
+    TEST_ASSERT_EQUAL(CODEC_DEV_TYPE_IN, codec->enabled_path);
+    TEST_ESP_OK(esp_codec_dev_close(rec_dev));
+    TEST_ASSERT_EQUAL(CODEC_DEV_TYPE_NONE, codec->enabled_path);
+    // Path control is preferred over whole codec enable
+    TEST_ASSERT_FALSE(codec->enable);
+
+    esp_codec_dev_delete(play_dev);
+    esp_codec_dev_delete(rec_dev);
+    audio_codec_delete_codec_if(codec_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+    audio_codec_delete_data_if(data_if);
+}
+
+TEST_CASE("esp codec dev fixed format codec test", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    const audio_codec_data_if_t *data_if = my_codec_data_new();
+    TEST_ASSERT_NOT_NULL(data_if);
+    my_codec_data_t *codec_data = (my_codec_data_t *) data_if;
+    my_codec_cfg_t codec_cfg = {
+        .ctrl_if = ctrl_if,
+    };
+    const audio_codec_if_t *codec_if = my_codec_new(&codec_cfg);
+    TEST_ASSERT_NOT_NULL(codec_if);
+    my_codec_t *codec = (my_codec_t *) codec_if;
+    codec->fixed_rate = 48000;
+    esp_codec_dev_cfg_t dev_cfg = {
+        .dev_type = CODEC_DEV_TYPE_OUT,
+        .codec_if = codec_if,
+        .data_if = data_if,
+    };
+    esp_codec_dev_handle_t dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(dev);
+    codec_sample_info_t fs = {
+        .bits_per_sample = 16,
+        .sample_rate = 8000,
+        .channel = 2,
+    };
+    // Sample rate rejected by codec fails open and releases data interface
+    TEST_ASSERT_EQUAL(CODEC_DEV_NOT_SUPPORT, esp_codec_dev_open(dev, &fs));
+    TEST_ASSERT_EQUAL(0, codec_data->fmt.sample_rate);
+    TEST_ASSERT_EQUAL(CODEC_DEV_TYPE_NONE, codec->enabled_path);
+
+    // Codec reports fixed format, data interface runs at requested rate and codec keeps its own
+    codec->caps |= CODEC_IF_CAP_FIXED_FMT;
+    TEST_ESP_OK(esp_codec_dev_open(dev, &fs));
+    TEST_ASSERT_EQUAL(8000, codec_data->fmt.sample_rate);
+    TEST_ASSERT_EQUAL(0, codec->fs.sample_rate);
+    TEST_ASSERT_EQUAL(CODEC_DEV_TYPE_OUT, codec->enabled_path);
+    TEST_ESP_OK(esp_codec_dev_close(dev));
+    // Supported format still configures codec
+    fs.sample_rate = 48000;
+    TEST_ESP_OK(esp_codec_dev_open(dev, &fs));
+    TEST_ASSERT_EQUAL(48000, codec->fs.sample_rate);
+    TEST_ESP_OK(esp_codec_dev_close(dev));
+
+    esp_codec_dev_delete(dev);
+    audio_codec_delete_codec_if(codec_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+    audio_codec_delete_data_if(data_if);
+}
+
+TEST_CASE("esp codec dev software volume fade test", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    const audio_codec_data_if_t *data_if = my_codec_data_new();
+    TEST_ASSERT_NOT_NULL(data_if);
+    my_codec_cfg_t codec_cfg = {
+        .ctrl_if = ctrl_if,
+    };
+    const audio_codec_if_t *codec_if = my_codec_new(&codec_cfg);
+    TEST_ASSERT_NOT_NULL(codec_if);
+    // Codec can set volume but not ramp it
+    my_codec_t *codec = (my_codec_t *) codec_if;
+    codec->caps = CODEC_IF_CAP_NONE;
+    esp_codec_dev_cfg_t dev_cfg = {
+        .dev_type = CODEC_DEV_TYPE_OUT,
+        .codec_if = codec_if,
+        .data_if = data_if,
+    };
+    codec_sample_info_t fs = {
+        .bits_per_sample = 16,
+        .sample_rate = 48000,
+        .channel = 1,
+    };
+    // Software fade not requested, volume stays in codec
+    esp_codec_dev_handle_t dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(dev);
+    codec_dev_vol_map_t vol_maps[2] = {
+        {.vol = 0,   .db_value = 0  },
+        {.vol = 100, .db_value = 100},
+    };
+    esp_codec_dev_vol_curve_t vol_curve = {
+        .count = 2,
+        .vol_map = vol_maps,
+    };
+    TEST_ESP_OK(esp_codec_dev_set_vol_curve(dev, &vol_curve));
+    TEST_ESP_OK(esp_codec_dev_open(dev, &fs));
+    TEST_ESP_OK(esp_codec_dev_set_out_vol(dev, 30));
+    TEST_ASSERT_EQUAL(30, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    TEST_ESP_OK(esp_codec_dev_close(dev));
+    esp_codec_dev_delete(dev);
+
+    dev_cfg.sw_fade = true;
+    dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(dev);
+    TEST_ESP_OK(esp_codec_dev_set_vol_curve(dev, &vol_curve));
+    // Volume set before open goes to codec directly
+    TEST_ESP_OK(esp_codec_dev_set_out_vol(dev, 40));
+    TEST_ASSERT_EQUAL(40, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+
+    TEST_ESP_OK(esp_codec_dev_open(dev, &fs));
+    // Codec kept at top of volume curve, volume applied in software without fade at start
+    TEST_ASSERT_EQUAL(100, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    int sample_num = 48000 / 10;
+    int16_t *samples = (int16_t *) malloc(sample_num * sizeof(int16_t));
+    TEST_ASSERT_NOT_NULL(samples);
+    for (int i = 0; i < sample_num; i++) {
+        samples[i] = 10000;
+    }
+    TEST_ESP_OK(esp_codec_dev_write(dev, samples, sample_num * sizeof(int16_t)));
+    TEST_ASSERT(samples[0] < 20);
+
+    // Volume change fades in software, codec register untouched
+    TEST_ESP_OK(esp_codec_dev_set_out_vol(dev, 100));
+    TEST_ASSERT_EQUAL(100, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    int volume = 0;
+    TEST_ESP_OK(esp_codec_dev_get_out_vol(dev, &volume));
+    TEST_ASSERT_EQUAL(100, volume);
+    for (int i = 0; i < sample_num; i++) {
+        samples[i] = 10000;
+    }
+    TEST_ESP_OK(esp_codec_dev_write(dev, samples, sample_num * sizeof(int16_t)));
+    TEST_ASSERT(samples[0] < 100);
+    TEST_ASSERT(samples[sample_num / 4] > samples[0] && samples[sample_num / 4] < 10000);
+    TEST_ASSERT_EQUAL(10000, samples[sample_num - 1]);
+
+    // Volume given back to codec after close
+    TEST_ESP_OK(esp_codec_dev_set_out_vol(dev, 60));
+    TEST_ESP_OK(esp_codec_dev_close(dev));
+    TEST_ASSERT_EQUAL(60, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    free(samples);
+
+    esp_codec_dev_delete(dev);
+    audio_codec_delete_codec_if(codec_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+    audio_codec_delete_data_if(data_if);
+}
+
 TEST_CASE("esp codec dev wrong argument test", "[esp_codec_dev]")
 {
     const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
@@ -565,6 +818,419 @@ TEST_CASE("esp codec dev feature should not support", "[esp_codec_dev]")
     audio_codec_delete_data_if(data_if);
 }
 
+TEST_CASE("register sequence write test", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    const codec_reg_val_pair_t seq[] = {
+        {MY_CODEC_REG_VOL,      10},
+        {MY_CODEC_REG_MUTE,     1 },
+        {MY_CODEC_REG_VOL,      20},
+        {MY_CODEC_REG_MIC_GAIN, 30},
+    };
+    // Control interface without write_regs fallback to register write one by one
+    int ret = audio_codec_write_regs(ctrl_if, seq, sizeof(seq) / sizeof(seq[0]));
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(20, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    TEST_ASSERT_EQUAL(1, codec_ctrl->reg[MY_CODEC_REG_MUTE]);
+    TEST_ASSERT_EQUAL(30, codec_ctrl->reg[MY_CODEC_REG_MIC_GAIN]);
+    ret = audio_codec_write_regs(ctrl_if, NULL, 1);
+    TEST_ASSERT_EQUAL(CODEC_DEV_INVALID_ARG, ret);
+    audio_codec_delete_ctrl_if(ctrl_if);
+}
+
+TEST_CASE("register sequence engine test", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    codec_ctrl->reg[MY_CODEC_REG_MIC_MUTE] = 0x0F;
+    const codec_reg_seq_t seq[] = {
+        CODEC_REG_SEQ_WRITE(MY_CODEC_REG_VOL, 0x0A),
+        // Use pending write value without read
+        CODEC_REG_SEQ_UPDATE(MY_CODEC_REG_VOL, 0xF0, 0x30),
+        // Read back and skip write for value not changed
+        CODEC_REG_SEQ_UPDATE(MY_CODEC_REG_MIC_MUTE, 0x03, 0x03),
+        CODEC_REG_SEQ_IF(0, 1),
+        CODEC_REG_SEQ_WRITE(MY_CODEC_REG_MUTE, 1),
+        CODEC_REG_SEQ_IF_NOT(0, 1),
+        CODEC_REG_SEQ_WRITE(MY_CODEC_REG_MUTE, 2),
+        CODEC_REG_SEQ_DELAY(1),
+        CODEC_REG_SEQ_BURST(MY_CODEC_REG_MIC_GAIN, 2),
+        CODEC_REG_SEQ_DATA(30, 0x1F, 0, 0),
+    };
+    codec_reg_seq_stats_t stats = {0};
+    int ret = audio_codec_run_reg_seq(ctrl_if, seq, CODEC_REG_SEQ_NUM(seq), (1 << 0), &stats);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(0x3A, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    TEST_ASSERT_EQUAL(1, codec_ctrl->reg[MY_CODEC_REG_MUTE]);
+    TEST_ASSERT_EQUAL(30, codec_ctrl->reg[MY_CODEC_REG_MIC_GAIN]);
+    TEST_ASSERT_EQUAL(0x1F, codec_ctrl->reg[MY_CODEC_REG_MIC_MUTE]);
+    // Bits update of volume merged into its pending write
+    TEST_ASSERT_EQUAL(4, stats.writes);
+    TEST_ASSERT_EQUAL(1, stats.reads);
+    TEST_ASSERT_EQUAL(1, stats.skipped);
+    TEST_ASSERT_EQUAL(1, stats.delay_ms);
+    // No write_regs in control interface, each write is one transaction
+    TEST_ASSERT_EQUAL(5, stats.transactions);
+
+    // Dry run not touch codec and counts each batch as single transaction like interface with write_regs
+    // Register value is unknown, so bits update not resolved by pending write is always written
+    codec_ctrl->reg[MY_CODEC_REG_MUTE] = 0;
+    memset(&stats, 0, sizeof(stats));
+    ret = audio_codec_count_reg_seq(seq, CODEC_REG_SEQ_NUM(seq), 0, &stats);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(0, codec_ctrl->reg[MY_CODEC_REG_MUTE]);
+    TEST_ASSERT_EQUAL(5, stats.writes);
+    TEST_ASSERT_EQUAL(1, stats.reads);
+    TEST_ASSERT_EQUAL(4, stats.transactions);
+
+    // Bits update after write of other register keeps write order
+    const codec_reg_seq_t order_seq[] = {
+        CODEC_REG_SEQ_WRITE(MY_CODEC_REG_VOL, 0x0A),
+        CODEC_REG_SEQ_WRITE(MY_CODEC_REG_MUTE, 0),
+        CODEC_REG_SEQ_UPDATE(MY_CODEC_REG_VOL, 0xF0, 0x30),
+    };
+    memset(&stats, 0, sizeof(stats));
+    ret = audio_codec_count_reg_seq(order_seq, CODEC_REG_SEQ_NUM(order_seq), 0, &stats);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(3, stats.writes);
+    TEST_ASSERT_EQUAL(0, stats.reads);
+
+    // Malformed sequence
+    const codec_reg_seq_t bad_seq[] = {
+        CODEC_REG_SEQ_IF(0, 2),
+        CODEC_REG_SEQ_WRITE(MY_CODEC_REG_VOL, 0),
+    };
+    ret = audio_codec_run_reg_seq(ctrl_if, bad_seq, CODEC_REG_SEQ_NUM(bad_seq), 0, NULL);
+    TEST_ASSERT_EQUAL(CODEC_DEV_INVALID_ARG, ret);
+    ret = audio_codec_run_reg_seq(NULL, seq, CODEC_REG_SEQ_NUM(seq), 0, NULL);
+    TEST_ASSERT_EQUAL(CODEC_DEV_INVALID_ARG, ret);
+    audio_codec_delete_ctrl_if(ctrl_if);
+}
+
+TEST_CASE("register cache control interface test", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    const uint8_t volatile_mask[] = {(1 << MY_CODEC_REG_MIC_MUTE)};
+    const codec_reg_cache_desc_t desc = {
+        .reg_num = MY_CODEC_REG_MAX,
+        .reset_reg = -1,
+        .volatile_mask = volatile_mask,
+    };
+    codec_cache_ctrl_cfg_t cache_cfg = {
+        .ctrl_if = ctrl_if,
+        .desc = &desc,
+    };
+    const audio_codec_ctrl_if_t *cache_if = audio_codec_new_cache_ctrl_if(&cache_cfg);
+    TEST_ASSERT_NOT_NULL(cache_if);
+    TEST_ASSERT_TRUE(cache_if->is_open(cache_if));
+    uint8_t v = 10;
+    int ret = cache_if->write_addr(cache_if, MY_CODEC_REG_VOL, 1, &v, 1);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(10, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    v = 1;
+    ret = cache_if->write_addr(cache_if, MY_CODEC_REG_MIC_MUTE, 1, &v, 1);
+    TEST_ESP_OK(ret);
+
+    // Change register behind cache, cached value is returned for normal register
+    codec_ctrl->reg[MY_CODEC_REG_VOL] = 20;
+    codec_ctrl->reg[MY_CODEC_REG_MIC_MUTE] = 0;
+    ret = cache_if->read_addr(cache_if, MY_CODEC_REG_VOL, 1, &v, 1);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(10, v);
+    ret = cache_if->read_addr(cache_if, MY_CODEC_REG_MIC_MUTE, 1, &v, 1);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(0, v);
+
+    // Write same value is skipped
+    v = 10;
+    ret = cache_if->write_addr(cache_if, MY_CODEC_REG_VOL, 1, &v, 1);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(20, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    const codec_reg_val_pair_t seq[] = {
+        {MY_CODEC_REG_VOL,  10},
+        {MY_CODEC_REG_MUTE, 1 },
+    };
+    ret = audio_codec_write_regs(cache_if, seq, sizeof(seq) / sizeof(seq[0]));
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(20, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    TEST_ASSERT_EQUAL(1, codec_ctrl->reg[MY_CODEC_REG_MUTE]);
+
+    // Read from device again after invalidate
+    ret = audio_codec_cache_ctrl_invalidate(cache_if);
+    TEST_ESP_OK(ret);
+    ret = cache_if->read_addr(cache_if, MY_CODEC_REG_VOL, 1, &v, 1);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(20, v);
+    ret = audio_codec_cache_ctrl_invalidate(ctrl_if);
+    TEST_ASSERT_EQUAL(CODEC_DEV_INVALID_ARG, ret);
+
+    audio_codec_delete_ctrl_if(cache_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+}
+
+TEST_CASE("shared control bus lock test", "[esp_codec_dev]")
+{
+    codec_i2c_dev_cfg_t i2c_cfg = {
+        .port = 0,
+        .addr = 0x30,
+    };
+    const audio_codec_ctrl_if_t *ctrl_if = audio_codec_new_i2c_ctrl_if(&i2c_cfg);
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    i2c_cfg.addr = 0x80;
+    const audio_codec_ctrl_if_t *other_ctrl_if = audio_codec_new_i2c_ctrl_if(&i2c_cfg);
+    TEST_ASSERT_NOT_NULL(other_ctrl_if);
+
+    // Nested acquire only counted once
+    TEST_ESP_OK(audio_codec_ctrl_acquire(ctrl_if, true));
+    TEST_ESP_OK(audio_codec_ctrl_acquire(ctrl_if, true));
+    TEST_ESP_OK(audio_codec_ctrl_acquire(ctrl_if, false));
+    TEST_ESP_OK(audio_codec_ctrl_acquire(ctrl_if, false));
+    TEST_ASSERT_EQUAL(CODEC_DEV_WRONG_STATE, audio_codec_ctrl_acquire(ctrl_if, false));
+    // Devices on same port share one lock
+    TEST_ESP_OK(audio_codec_ctrl_acquire(other_ctrl_if, true));
+    TEST_ESP_OK(audio_codec_ctrl_acquire(other_ctrl_if, false));
+    codec_bus_lock_stats_t stats;
+    TEST_ESP_OK(audio_codec_get_bus_lock_stats(CODEC_BUS_TYPE_I2C, 0, &stats));
+    TEST_ASSERT_EQUAL(2, stats.acquire_count);
+    TEST_ASSERT_EQUAL(0, stats.contention_count);
+    TEST_ASSERT_EQUAL(CODEC_DEV_NOT_FOUND, audio_codec_get_bus_lock_stats(CODEC_BUS_TYPE_I2C, 1, &stats));
+
+    // Control interface without bus lock support
+    const audio_codec_ctrl_if_t *my_ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(my_ctrl_if);
+    TEST_ESP_OK(audio_codec_ctrl_acquire(my_ctrl_if, true));
+    TEST_ESP_OK(audio_codec_ctrl_acquire(my_ctrl_if, false));
+    audio_codec_delete_ctrl_if(my_ctrl_if);
+
+    audio_codec_delete_ctrl_if(ctrl_if);
+    audio_codec_delete_ctrl_if(other_ctrl_if);
+    TEST_ASSERT_EQUAL(CODEC_DEV_NOT_FOUND, audio_codec_get_bus_lock_stats(CODEC_BUS_TYPE_I2C, 0, &stats));
+}
+
+static int async_done_count;
+static int async_done_mask;
+
+static void async_ctrl_done(esp_codec_dev_handle_t codec, esp_codec_dev_ctrl_cmd_t cmd, int ret, void *ctx)
+{
+    if (ret == CODEC_DEV_OK) {
+        async_done_count++;
+        async_done_mask |= (1 << cmd);
+    }
+}
+
+TEST_CASE("esp codec dev asynchronous control test", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    const audio_codec_data_if_t *data_if = my_codec_data_new();
+    TEST_ASSERT_NOT_NULL(data_if);
+    my_codec_cfg_t codec_cfg = {
+        .ctrl_if = ctrl_if,
+    };
+    const audio_codec_if_t *codec_if = my_codec_new(&codec_cfg);
+    TEST_ASSERT_NOT_NULL(codec_if);
+    esp_codec_dev_cfg_t dev_cfg = {
+        .dev_type = CODEC_DEV_TYPE_IN_OUT,
+        .codec_if = codec_if,
+        .data_if = data_if,
+    };
+    esp_codec_dev_handle_t dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(dev);
+    codec_sample_info_t fs = {
+        .bits_per_sample = 16,
+        .sample_rate = 48000,
+        .channel = 2,
+    };
+    int ret = esp_codec_dev_open(dev, &fs);
+    TEST_ESP_OK(ret);
+    codec_dev_vol_map_t vol_maps[2] = {
+        {.vol = 0,   .db_value = 0  },
+        {.vol = 100, .db_value = 100},
+    };
+    esp_codec_dev_vol_curve_t vol_curve = {
+        .count = 2,
+        .vol_map = vol_maps,
+    };
+    ret = esp_codec_dev_set_vol_curve(dev, &vol_curve);
+    TEST_ESP_OK(ret);
+
+    async_done_count = 0;
+    async_done_mask = 0;
+    esp_codec_dev_async_ctrl_cfg_t async_cfg = {
+        .task_prio = 5,
+        .done_cb = async_ctrl_done,
+    };
+    ret = esp_codec_dev_set_async_ctrl(dev, &async_cfg);
+    TEST_ESP_OK(ret);
+    // Only latest setting need be applied
+    for (int i = 1; i <= 10; i++) {
+        ret = esp_codec_dev_set_out_vol(dev, i * 5);
+        TEST_ESP_OK(ret);
+    }
+    ret = esp_codec_dev_set_in_gain(dev, 40.0);
+    TEST_ESP_OK(ret);
+    int volume = 0;
+    ret = esp_codec_dev_get_out_vol(dev, &volume);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(50, volume);
+    // Disable asynchronous control will execute all pending commands
+    ret = esp_codec_dev_set_async_ctrl(dev, NULL);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(50, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+    TEST_ASSERT_EQUAL(40, codec_ctrl->reg[MY_CODEC_REG_MIC_GAIN]);
+    TEST_ASSERT_EQUAL((1 << ESP_CODEC_DEV_CTRL_OUT_VOL) | (1 << ESP_CODEC_DEV_CTRL_IN_GAIN), async_done_mask);
+    TEST_ASSERT(async_done_count >= 2 && async_done_count <= 11);
+
+    // Synchronous setting after disabled
+    ret = esp_codec_dev_set_out_vol(dev, 20);
+    TEST_ESP_OK(ret);
+    TEST_ASSERT_EQUAL(20, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+
+    esp_codec_dev_delete(dev);
+    audio_codec_delete_codec_if(codec_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+    audio_codec_delete_data_if(data_if);
+}
+
+TEST_CASE("esp codec dev asynchronous control close test", "[esp_codec_dev]")
+{
+    const audio_codec_ctrl_if_t *ctrl_if = my_codec_ctrl_new();
+    TEST_ASSERT_NOT_NULL(ctrl_if);
+    my_codec_ctrl_t *codec_ctrl = (my_codec_ctrl_t *) ctrl_if;
+    const audio_codec_data_if_t *data_if = my_codec_data_new();
+    TEST_ASSERT_NOT_NULL(data_if);
+    my_codec_cfg_t codec_cfg = {
+        .ctrl_if = ctrl_if,
+    };
+    const audio_codec_if_t *codec_if = my_codec_new(&codec_cfg);
+    TEST_ASSERT_NOT_NULL(codec_if);
+    // Use software fade so that close also releases software volume
+    my_codec_t *codec = (my_codec_t *) codec_if;
+    codec->caps = CODEC_IF_CAP_NONE;
+    codec->vol_delay = 2;
+    esp_codec_dev_cfg_t dev_cfg = {
+        .dev_type = CODEC_DEV_TYPE_OUT,
+        .codec_if = codec_if,
+        .data_if = data_if,
+        .sw_fade = true,
+    };
+    esp_codec_dev_handle_t dev = esp_codec_dev_new(&dev_cfg);
+    TEST_ASSERT_NOT_NULL(dev);
+    codec_dev_vol_map_t vol_maps[2] = {
+        {.vol = 0,   .db_value = 0  },
+        {.vol = 100, .db_value = 100},
+    };
+    esp_codec_dev_vol_curve_t vol_curve = {
+        .count = 2,
+        .vol_map = vol_maps,
+    };
+    TEST_ESP_OK(esp_codec_dev_set_vol_curve(dev, &vol_curve));
+    codec_sample_info_t fs = {
+        .bits_per_sample = 16,
+        .sample_rate = 48000,
+        .channel = 2,
+    };
+    esp_codec_dev_async_ctrl_cfg_t async_cfg = {
+        .task_prio = 5,
+    };
+    TEST_ESP_OK(esp_codec_dev_set_async_ctrl(dev, &async_cfg));
+    // Close right after volume posted, worker must not touch codec once path disabled
+    for (int i = 1; i <= 20; i++) {
+        TEST_ESP_OK(esp_codec_dev_open(dev, &fs));
+        TEST_ESP_OK(esp_codec_dev_set_out_vol(dev, i));
+        TEST_ESP_OK(esp_codec_dev_close(dev));
+        TEST_ASSERT_EQUAL(CODEC_DEV_TYPE_NONE, codec->enabled_path);
+    }
+    codec_dev_sleep(20);
+    TEST_ASSERT_EQUAL(0, codec->vol_on_disabled);
+
+    // Volume posted while closed is applied after output opened
+    TEST_ESP_OK(esp_codec_dev_set_out_vol(dev, 30));
+    codec_dev_sleep(20);
+    TEST_ASSERT_EQUAL(0, codec->vol_on_disabled);
+    TEST_ESP_OK(esp_codec_dev_open(dev, &fs));
+    TEST_ESP_OK(esp_codec_dev_set_async_ctrl(dev, NULL));
+    TEST_ESP_OK(esp_codec_dev_close(dev));
+    TEST_ASSERT_EQUAL(0, codec->vol_on_disabled);
+    TEST_ASSERT_EQUAL(30, codec_ctrl->reg[MY_CODEC_REG_VOL]);
+
+    esp_codec_dev_delete(dev);
+    audio_codec_delete_codec_if(codec_if);
+    audio_codec_delete_ctrl_if(ctrl_if);
+    audio_codec_delete_data_if(data_if);
+}
+
+TEST_CASE("I2S data interface shared port format test", "[esp_codec_dev]")
+{
+    i2s_config_t i2s_config = {
+        .mode = (i2s_mode_t) (I2S_MODE_TX | I2S_MODE_RX | I2S_MODE_MASTER),
+        .sample_rate = 16000,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+        .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+        .dma_buf_count = 2,
+        .dma_buf_len = 128,
+    };
+    TEST_ESP_OK(i2s_driver_install(0, &i2s_config, 0, NULL));
+    codec_i2s_dev_cfg_t i2s_cfg = {
+        .port = 0,
+    };
+    const audio_codec_data_if_t *data_if = audio_codec_new_i2s_data_if(&i2s_cfg);
+    TEST_ASSERT_NOT_NULL(data_if);
+
+    // First direction programs port clock
+    codec_sample_info_t out_fs = {
+        .bits_per_sample = 16,
+        .channel = 2,
+        .sample_rate = 16000,
+    };
+    TEST_ESP_OK(data_if->set_fmt(data_if, CODEC_DEV_TYPE_OUT, &out_fs));
+    TEST_ASSERT_EQUAL(16000, out_fs.sample_rate);
+    TEST_ASSERT_EQUAL(16000 * 256, out_fs.mclk);
+
+    // Other direction can not reclock running TX
+    codec_sample_info_t in_fs = {
+        .bits_per_sample = 16,
+        .channel = 2,
+        .sample_rate = 48000,
+    };
+    TEST_ASSERT_EQUAL(CODEC_DEV_NOT_SUPPORT, data_if->set_fmt(data_if, CODEC_DEV_TYPE_IN, &in_fs));
+    in_fs.sample_rate = 16000;
+    in_fs.bits_per_sample = 32;
+    TEST_ASSERT_EQUAL(CODEC_DEV_NOT_SUPPORT, data_if->set_fmt(data_if, CODEC_DEV_TYPE_IN, &in_fs));
+
+    // Rate which running rate is integer multiple of is negotiated to the running rate
+    in_fs.bits_per_sample = 16;
+    in_fs.sample_rate = 8000;
+    TEST_ESP_OK(data_if->set_fmt(data_if, CODEC_DEV_TYPE_IN, &in_fs));
+    TEST_ASSERT_EQUAL(16000, in_fs.sample_rate);
+    TEST_ASSERT_EQUAL(16000 * 256, in_fs.mclk);
+
+    // Releasing TX keeps RX clock, reopened TX must follow it
+    TEST_ESP_OK(data_if->set_fmt(data_if, CODEC_DEV_TYPE_OUT, NULL));
+    out_fs.sample_rate = 44100;
+    TEST_ASSERT_EQUAL(CODEC_DEV_NOT_SUPPORT, data_if->set_fmt(data_if, CODEC_DEV_TYPE_OUT, &out_fs));
+    out_fs.sample_rate = 16000;
+    TEST_ESP_OK(data_if->set_fmt(data_if, CODEC_DEV_TYPE_OUT, &out_fs));
+    TEST_ASSERT_EQUAL(16000, out_fs.sample_rate);
+
+    // Port is free to reclock after both directions released
+    TEST_ESP_OK(data_if->set_fmt(data_if, CODEC_DEV_TYPE_IN_OUT, NULL));
+    out_fs.sample_rate = 44100;
+    TEST_ESP_OK(data_if->set_fmt(data_if, CODEC_DEV_TYPE_OUT, &out_fs));
+    TEST_ASSERT_EQUAL(44100, out_fs.sample_rate);
+    TEST_ASSERT_EQUAL(44100 * 256, out_fs.mclk);
+
+    audio_codec_delete_data_if(data_if);
+    i2s_driver_uninstall(0);
+}
+
 #define CONFIG_USE_S3_KORVO2_V3
 
 #ifdef CONFIG_USE_S3_KORVO2_V3
@@ -681,6 +1347,7 @@ TEST_CASE("esp codec dev test using S3 board", "[esp_codec_dev]")
         .codec_mode = CODEC_WORK_MODE_DAC,
         .ctrl_if = out_ctrl_if,
         .pa_pin = TEST_CODEC_PA_PIN,
+        .use_mclk = true,
     };
     const audio_codec_if_t *out_codec_if = es8311_codec_new(&es8311_cfg);
     TEST_ASSERT_NOT_NULL(out_codec_if);
@@ -0,0 +1,332 @@
+#!/usr/bin/env python3
+#
+# ESPRESSIF MIT License
+#
+# Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+#
+# Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+# it is free of charge, to any person obtaining a copy of this software and associated
+# documentation files (the "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+# to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all copies or
+# substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+# FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+# COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+# IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+"""
+Record codec bring-up of one driver into a register script
+
+The driver is built for host together with tools/codec_reg_recorder.c and runs codec_new(),
+set_fs() (when --rate given) and enable() against a recording control interface.
+Reads for read-modify-write are resolved by the register model, so the script holds writes and delays only:
+
+- Writes to consecutive registers are packed into CODEC_REG_SEQ_BURST entries
+- Delays become CODEC_REG_SEQ_DELAY entries
+- Registers read before written take their reset value from --default, they are listed in the header.
+  Recording fails when such a register has no --default, take the reset value from the codec datasheet
+- With --drop-redundant, writes which do not change register value are removed
+
+The script is an array of codec_reg_seq_t, play it by audio_codec_run_reg_seq().
+The binary form (--bin) is the same array in raw 4 bytes entries.
+
+Usage:
+    codec_reg_record.py es8311 es8311_boot_script.h --mode dac --rate 48000 --bits 16 --channel 2 \
+        --default 0x06=0x03 --default 0x07=0x00 --default 0x08=0xFF --default 0x09=0x00 --default 0x0A=0x00
+"""
+
+import argparse
+import os
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+
+OP_WRITE = 0
+OP_DELAY = 2
+OP_BURST = 4
+MIN_BURST = 3
+MAX_DELAY = 255
+MAX_BURST = 255
+
+CODEC_DRIVERS = ['es8311', 'es8388', 'es8374', 'es8156', 'es7210', 'es7243', 'es7243e']
+
+HOST_ESP_LOG = '''#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#ifndef BIT
+#define BIT(nr) (1UL << (nr))
+#endif
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+#define ESP_LOGD(tag, fmt, ...) do { if (0) fprintf(stderr, fmt, ##__VA_ARGS__); } while (0)
+#define ets_printf(fmt, ...)    fprintf(stderr, fmt, ##__VA_ARGS__)
+'''
+
+HOST_ESP_ERR = '''#pragma once
+typedef int esp_err_t;
+#define ESP_OK   0
+#define ESP_FAIL -1
+'''
+
+
+def build_recorder(component, work_dir, cc):
+    with open(os.path.join(work_dir, 'esp_log.h'), 'w') as f:
+        f.write(HOST_ESP_LOG)
+    with open(os.path.join(work_dir, 'esp_err.h'), 'w') as f:
+        f.write(HOST_ESP_ERR)
+    sources = [os.path.join(component, 'tools', 'codec_reg_recorder.c'), os.path.join(component, 'codec_dev_utils.c')]
+    includes = [work_dir] + [os.path.join(component, d) for d in ['include', 'interface', 'internal', 'driver/include']]
+    for codec in CODEC_DRIVERS:
+        sources.append(os.path.join(component, 'driver', codec, codec + '.c'))
+        includes.append(os.path.join(component, 'driver', codec))
+    exe = os.path.join(work_dir, 'codec_reg_recorder')
+    cmd = [cc, '-std=gnu99', '-O1', '-Wall', '-o', exe] + ['-I' + d for d in includes] + sources + ['-lm']
+    subprocess.check_call(cmd)
+    return exe
+
+
+def parse_log(text):
+    ops = []
+    unknown = []
+    for line in text.splitlines():
+        fields = line.split()
+        if not fields:
+            continue
+        if fields[0] == 'W':
+            ops.append(('w', int(fields[1]), int(fields[2])))
+        elif fields[0] == 'D':
+            ops.append(('d', int(fields[1])))
+        elif fields[0] == 'U':
+            unknown.append((int(fields[1]), int(fields[2])))
+        else:
+            raise ValueError('Unknown recorder output: %s' % line)
+    return ops, unknown
+
+
+def split_delay(op):
+    ms = op[1]
+    out = []
+    while ms > 0:
+        out.append(('d', min(ms, MAX_DELAY)))
+        ms -= min(ms, MAX_DELAY)
+    return out
+
+
+def pack(ops):
+    """Pack recorded operations into codec_reg_seq_t entries (op, reg, value, mask)"""
+    entries = []
+    i = 0
+    while i < len(ops):
+        op = ops[i]
+        if op[0] == 'd':
+            entries.extend((OP_DELAY, 0, d[1], 0) for d in split_delay(op))
+            i += 1
+            continue
+        run = [op[2]]
+        while (i + len(run) < len(ops) and len(run) < MAX_BURST and ops[i + len(run)][0] == 'w' and
+               ops[i + len(run)][1] == op[1] + len(run)):
+            run.append(ops[i + len(run)][2])
+        if len(run) >= MIN_BURST:
+            entries.append((OP_BURST, op[1], len(run), 0))
+            data = run + [0] * (-len(run) % 4)
+            for k in range(0, len(data), 4):
+                entries.append(tuple(data[k:k + 4]))
+            i += len(run)
+        else:
+            entries.append((OP_WRITE, op[1], op[2], 0xFF))
+            i += 1
+    return entries
+
+
+def replay(entries):
+    """Replay packed entries, return register writes and delays for self check"""
+    out = []
+    i = 0
+    while i < len(entries):
+        op, reg, value, _ = entries[i]
+        i += 1
+        if op == OP_WRITE:
+            out.append(('w', reg, value))
+        elif op == OP_DELAY:
+            out.append(('d', value))
+        elif op == OP_BURST:
+            data = [b for e in entries[i:i + (value + 3) // 4] for b in e][:value]
+            out.extend(('w', reg + k, data[k]) for k in range(value))
+            i += (value + 3) // 4
+    return out
+
+
+def drop_redundant(ops):
+    """Drop writes of value already written to register, first write of each register is kept"""
+    last = {}
+    out = []
+    for op in ops:
+        if op[0] == 'w':
+            if last.get(op[1]) == op[2]:
+                continue
+            last[op[1]] = op[2]
+        out.append(op)
+    return out
+
+
+def merge_delays(ops):
+    out = []
+    for op in ops:
+        if op[0] == 'd' and out and out[-1][0] == 'd':
+            out[-1] = ('d', out[-1][1] + op[1])
+        else:
+            out.append(op)
+    return out
+
+
+def format_entries(entries):
+    lines = []
+    i = 0
+    while i < len(entries):
+        op, reg, value, mask = entries[i]
+        i += 1
+        if op == OP_WRITE:
+            lines.append('    CODEC_REG_SEQ_WRITE(0x%02X, 0x%02X),' % (reg, value))
+        elif op == OP_DELAY:
+            lines.append('    CODEC_REG_SEQ_DELAY(%d),' % value)
+        else:
+            lines.append('    CODEC_REG_SEQ_BURST(0x%02X, %d),' % (reg, value))
+            for data in entries[i:i + (value + 3) // 4]:
+                lines.append('    CODEC_REG_SEQ_DATA(0x%02X, 0x%02X, 0x%02X, 0x%02X),' % data)
+            i += (value + 3) // 4
+    return lines
+
+
+def parse_defaults(defaults):
+    regs = set()
+    for default in defaults:
+        try:
+            reg, _ = [int(v, 0) for v in default.split('=')]
+        except ValueError:
+            sys.exit('Bad register default %s, use REG=VALUE' % default)
+        regs.add(reg)
+    return regs
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Record codec driver bring-up into register script')
+    parser.add_argument('codec', choices=CODEC_DRIVERS, help='codec driver')
+    parser.add_argument('output', help='generated register script header')
+    parser.add_argument('--name', help='name of the generated script, default <codec>_boot_script')
+    parser.add_argument('--bin', help='also write script in binary form')
+    parser.add_argument('--mode', choices=['adc', 'dac', 'both', 'line'], default='both', help='codec work mode')
+    parser.add_argument('--master', action='store_true', help='codec works as I2S master')
+    parser.add_argument('--no-mclk', action='store_true', help='codec not use MCLK')
+    parser.add_argument('--digital-mic', action='store_true', help='use digital microphone')
+    parser.add_argument('--invert-mclk', action='store_true', help='MCLK inverted')
+    parser.add_argument('--invert-sclk', action='store_true', help='SCLK inverted')
+    parser.add_argument('--mic-selected', default='0', help='selected microphones (ES7210)')
+    parser.add_argument('--rate', type=int, default=0, help='sample rate for set_fs, skipped if 0')
+    parser.add_argument('--bits', type=int, default=16, help='bits per sample')
+    parser.add_argument('--channel', type=int, default=2, help='channels')
+    parser.add_argument('--mclk', type=int, default=0, help='MCLK frequency reported by data interface, 0 if unknown')
+    parser.add_argument('--no-enable', action='store_true', help='do not record enable()')
+    parser.add_argument('--drop-redundant', action='store_true',
+                        help='drop writes of unchanged value, only for codecs without write triggered actions')
+    parser.add_argument('--default', action='append', default=[], metavar='REG=VALUE',
+                        help='register reset value used for reads before write, required for each such register')
+    parser.add_argument('--cc', default=os.environ.get('CC', 'cc'), help='host C compiler')
+    args = parser.parse_args()
+
+    component = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    name = args.name or '%s_boot_script' % args.codec
+    rec_args = [args.codec, '--mode', args.mode, '--mic-selected', args.mic_selected]
+    for flag in ['master', 'no_mclk', 'digital_mic', 'invert_mclk', 'invert_sclk', 'no_enable']:
+        if getattr(args, flag):
+            rec_args.append('--' + flag.replace('_', '-'))
+    if args.rate:
+        rec_args += ['--rate', str(args.rate), '--bits', str(args.bits), '--channel', str(args.channel)]
+        if args.mclk:
+            rec_args += ['--mclk', str(args.mclk)]
+    default_regs = parse_defaults(args.default)
+    for default in args.default:
+        rec_args += ['--default', default]
+
+    work_dir = tempfile.mkdtemp(prefix='codec_reg_record')
+    try:
+        exe = build_recorder(component, work_dir, args.cc)
+        log = subprocess.check_output([exe] + rec_args).decode()
+    except subprocess.CalledProcessError:
+        sys.exit('Fail to record %s with %s' % (args.codec, ' '.join(rec_args[1:])))
+    finally:
+        shutil.rmtree(work_dir)
+
+    ops, unknown = parse_log(log)
+    missing = [reg for reg, _ in unknown if reg not in default_regs]
+    if missing:
+        sys.exit('Registers read before written without reset value: %s\n'
+                 'Give each reset value from the codec datasheet by --default REG=VALUE' %
+                 ', '.join('0x%02X' % reg for reg in missing))
+    recorded = sum(1 for op in ops if op[0] == 'w')
+    if args.drop_redundant:
+        ops = drop_redundant(ops)
+    ops = merge_delays(ops)
+    entries = pack(ops)
+    expected = [d for op in ops for d in (split_delay(op) if op[0] == 'd' else [op])]
+    if replay(entries) != expected:
+        sys.exit('Packed register script does not match recorded accesses')
+    writes = sum(1 for op in ops if op[0] == 'w')
+
+    license_text = open(os.path.join(component, 'include', 'codec_dev_utils.h')).read().split('*/')[0] + '*/\n'
+    guard = '_%s_H_' % name.upper()
+    comment = [
+        '/* Generated by tools/%s, do not edit' % os.path.basename(sys.argv[0]),
+        ' * Recorded: %s' % ' '.join(rec_args),
+        ' * %d register writes (%d recorded), %d script entries' % (writes, recorded, len(entries)),
+    ]
+    if unknown:
+        comment.append(' * Registers read before written (reset value by --default): %s' %
+                       ', '.join('0x%02X=0x%02X' % u for u in unknown))
+    comment.append(' */')
+    body = [license_text.rstrip(), ''] + comment + [
+        '#ifndef %s' % guard,
+        '#define %s' % guard,
+        '',
+        '#include "codec_dev_utils.h"',
+        '',
+        '#ifdef __cplusplus',
+        'extern "C" {',
+        '#endif',
+        '',
+        '// clang-format off',
+        'static const codec_reg_seq_t %s[] = {' % name,
+    ] + format_entries(entries) + [
+        '};',
+        '// clang-format on',
+        '',
+        '#ifdef __cplusplus',
+        '}',
+        '#endif',
+        '',
+        '#endif',
+        '',
+    ]
+    with open(args.output, 'w') as f:
+        f.write('\n'.join(body))
+    if args.bin:
+        with open(args.bin, 'wb') as f:
+            for e in entries:
+                f.write(struct.pack('4B', *e))
+    print('%d register writes, %d reads before write -> %d entries (%d bytes)' %
+          (writes, len(unknown), len(entries), len(entries) * 4))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,312 @@
+/*
+ * ESPRESSIF MIT License
+ *
+ * Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+ *
+ * Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+ * it is free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+ * to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or
+ * substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+/*
+ * Host side register recorder, built and run by codec_reg_record.py
+ *
+ * Runs `codec_new`, `set_fs` and `enable` of one driver against a recording control interface.
+ * Register values are modelled, so read-modify-write accesses resolve to plain writes.
+ * Output lines on stdout:
+ *     W <reg> <value>    Register write
+ *     D <ms>             Delay
+ *     U <reg> <value>    Read of register never written, value comes from default
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codec_dev_defaults.h"
+#include "codec_dev_err.h"
+#include "codec_dev_os.h"
+#include "es8311.h"
+#include "es8388.h"
+#include "es8374.h"
+#include "es8156.h"
+#include "es7210.h"
+#include "es7243.h"
+#include "es7243e.h"
+
+typedef struct {
+    audio_codec_ctrl_if_t base;
+    uint8_t               reg[0x100];
+    uint8_t               written[0x100 / 8];
+    uint8_t               reported[0x100 / 8];
+} rec_ctrl_t;
+
+typedef struct {
+    const char         *codec;
+    codec_work_mode_t   codec_mode;
+    bool                master_mode;
+    bool                use_mclk;
+    bool                digital_mic;
+    bool                invert_mclk;
+    bool                invert_sclk;
+    uint8_t             mic_selected;
+    bool                enable;
+    codec_sample_info_t fs;
+} rec_cfg_t;
+
+static bool rec_bit(const uint8_t *bits, int reg)
+{
+    return (bits[reg >> 3] & (1 << (reg & 7))) != 0;
+}
+
+static void rec_set_bit(uint8_t *bits, int reg)
+{
+    bits[reg >> 3] |= (1 << (reg & 7));
+}
+
+static int rec_open(const audio_codec_ctrl_if_t *ctrl, void *cfg, int cfg_size)
+{
+    return CODEC_DEV_OK;
+}
+
+static bool rec_is_open(const audio_codec_ctrl_if_t *ctrl)
+{
+    return true;
+}
+
+static int rec_read_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
+{
+    rec_ctrl_t *rec = (rec_ctrl_t *) ctrl;
+    if (addr_len != 1 || addr < 0 || addr + data_len > 0x100) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    for (int i = 0; i < data_len; i++) {
+        int reg = addr + i;
+        if (rec_bit(rec->written, reg) == false && rec_bit(rec->reported, reg) == false) {
+            printf("U %d %d\n", reg, rec->reg[reg]);
+            rec_set_bit(rec->reported, reg);
+        }
+        ((uint8_t *) data)[i] = rec->reg[reg];
+    }
+    return CODEC_DEV_OK;
+}
+
+static int rec_write_addr(const audio_codec_ctrl_if_t *ctrl, int addr, int addr_len, void *data, int data_len)
+{
+    rec_ctrl_t *rec = (rec_ctrl_t *) ctrl;
+    if (addr_len != 1 || addr < 0 || addr + data_len > 0x100) {
+        return CODEC_DEV_INVALID_ARG;
+    }
+    for (int i = 0; i < data_len; i++) {
+        int reg = addr + i;
+        rec->reg[reg] = ((uint8_t *) data)[i];
+        rec_set_bit(rec->written, reg);
+        printf("W %d %d\n", reg, rec->reg[reg]);
+    }
+    return CODEC_DEV_OK;
+}
+
+static int rec_close(const audio_codec_ctrl_if_t *ctrl)
+{
+    return CODEC_DEV_OK;
+}
+
+void codec_dev_sleep(int ms)
+{
+    printf("D %d\n", ms);
+}
+
+void codec_dev_delay_us(int us)
+{
+    printf("D %d\n", (us + 999) / 1000);
+}
+
+const audio_codec_gpio_if_t *audio_codec_get_gpio_if(void)
+{
+    return NULL;
+}
+
+static const audio_codec_if_t *rec_codec_new(rec_cfg_t *cfg, const audio_codec_ctrl_if_t *ctrl_if)
+{
+    if (strcmp(cfg->codec, "es8311") == 0) {
+        es8311_codec_cfg_t codec_cfg = {
+            .ctrl_if = ctrl_if,
+            .codec_mode = cfg->codec_mode,
+            .pa_pin = -1,
+            .master_mode = cfg->master_mode,
+            .use_mclk = cfg->use_mclk,
+            .digital_mic = cfg->digital_mic,
+            .invert_mclk = cfg->invert_mclk,
+            .invert_sclk = cfg->invert_sclk,
+        };
+        return es8311_codec_new(&codec_cfg);
+    }
+    if (strcmp(cfg->codec, "es8388") == 0) {
+        es8388_codec_cfg_t codec_cfg = {
+            .ctrl_if = ctrl_if,
+            .codec_mode = cfg->codec_mode,
+            .master_mode = cfg->master_mode,
+            .pa_pin = -1,
+        };
+        return es8388_codec_new(&codec_cfg);
+    }
+    if (strcmp(cfg->codec, "es8374") == 0) {
+        es8374_codec_cfg_t codec_cfg = {
+            .ctrl_if = ctrl_if,
+            .codec_mode = cfg->codec_mode,
+            .master_mode = cfg->master_mode,
+            .pa_pin = -1,
+        };
+        return es8374_codec_new(&codec_cfg);
+    }
+    if (strcmp(cfg->codec, "es8156") == 0) {
+        es8156_codec_cfg_t codec_cfg = {
+            .ctrl_if = ctrl_if,
+            .pa_pin = -1,
+        };
+        return es8156_codec_new(&codec_cfg);
+    }
+    if (strcmp(cfg->codec, "es7210") == 0) {
+        es7210_codec_cfg_t codec_cfg = {
+            .ctrl_if = ctrl_if,
+            .master_mode = cfg->master_mode,
+            .mic_selected = cfg->mic_selected,
+        };
+        return es7210_codec_new(&codec_cfg);
+    }
+    if (strcmp(cfg->codec, "es7243") == 0) {
+        es7243_codec_cfg_t codec_cfg = {
+            .ctrl_if = ctrl_if,
+        };
+        return es7243_codec_new(&codec_cfg);
+    }
+    if (strcmp(cfg->codec, "es7243e") == 0) {
+        es7243e_codec_cfg_t codec_cfg = {
+            .ctrl_if = ctrl_if,
+        };
+        return es7243e_codec_new(&codec_cfg);
+    }
+    fprintf(stderr, "Codec %s not supported\n", cfg->codec);
+    return NULL;
+}
+
+static codec_work_mode_t rec_get_mode(const char *mode)
+{
+    if (strcmp(mode, "adc") == 0) {
+        return CODEC_WORK_MODE_ADC;
+    }
+    if (strcmp(mode, "dac") == 0) {
+        return CODEC_WORK_MODE_DAC;
+    }
+    if (strcmp(mode, "line") == 0) {
+        return CODEC_WORK_MODE_LINE;
+    }
+    return CODEC_WORK_MODE_BOTH;
+}
+
+int main(int argc, char *argv[])
+{
+    rec_ctrl_t rec = {
+        .base = {
+            .open = rec_open,
+            .is_open = rec_is_open,
+            .read_addr = rec_read_addr,
+            .write_addr = rec_write_addr,
+            .close = rec_close,
+        },
+    };
+    rec_cfg_t cfg = {
+        .codec_mode = CODEC_WORK_MODE_BOTH,
+        .use_mclk = true,
+        .enable = true,
+    };
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : "0";
+        if (strcmp(arg, "--mode") == 0) {
+            cfg.codec_mode = rec_get_mode(val);
+            i++;
+        } else if (strcmp(arg, "--master") == 0) {
+            cfg.master_mode = true;
+        } else if (strcmp(arg, "--no-mclk") == 0) {
+            cfg.use_mclk = false;
+        } else if (strcmp(arg, "--digital-mic") == 0) {
+            cfg.digital_mic = true;
+        } else if (strcmp(arg, "--invert-mclk") == 0) {
+            cfg.invert_mclk = true;
+        } else if (strcmp(arg, "--invert-sclk") == 0) {
+            cfg.invert_sclk = true;
+        } else if (strcmp(arg, "--no-enable") == 0) {
+            cfg.enable = false;
+        } else if (strcmp(arg, "--mic-selected") == 0) {
+            cfg.mic_selected = (uint8_t) strtol(val, NULL, 0);
+            i++;
+        } else if (strcmp(arg, "--rate") == 0) {
+            cfg.fs.sample_rate = strtol(val, NULL, 0);
+            i++;
+        } else if (strcmp(arg, "--bits") == 0) {
+            cfg.fs.bits_per_sample = strtol(val, NULL, 0);
+            i++;
+        } else if (strcmp(arg, "--channel") == 0) {
+            cfg.fs.channel = strtol(val, NULL, 0);
+            i++;
+        } else if (strcmp(arg, "--mclk") == 0) {
+            cfg.fs.mclk = strtol(val, NULL, 0);
+            i++;
+        } else if (strcmp(arg, "--default") == 0) {
+            // Register reset value as reg=value
+            int reg = 0, value = 0;
+            if (sscanf(val, "%i=%i", &reg, &value) != 2 || reg < 0 || reg >= 0x100) {
+                fprintf(stderr, "Bad register default %s\n", val);
+                return 1;
+            }
+            rec.reg[reg] = (uint8_t) value;
+            i++;
+        } else if (arg[0] != '-' && cfg.codec == NULL) {
+            cfg.codec = arg;
+        } else {
+            fprintf(stderr, "Unknown argument %s\n", arg);
+            return 1;
+        }
+    }
+    if (cfg.codec == NULL) {
+        fprintf(stderr, "Usage: %s codec [options]\n", argv[0]);
+        return 1;
+    }
+    const audio_codec_if_t *codec_if = rec_codec_new(&cfg, &rec.base);
+    if (codec_if == NULL) {
+        fprintf(stderr, "Fail to create codec %s\n", cfg.codec);
+        return 1;
+    }
+    if (cfg.fs.sample_rate && codec_if->set_fs) {
+        if (cfg.fs.bits_per_sample == 0) {
+            cfg.fs.bits_per_sample = 16;
+        }
+        if (cfg.fs.channel == 0) {
+            cfg.fs.channel = 2;
+        }
+        if (codec_if->set_fs(codec_if, &cfg.fs) != CODEC_DEV_OK) {
+            fprintf(stderr, "Fail to set sample rate %d\n", (int) cfg.fs.sample_rate);
+            return 1;
+        }
+    }
+    if (cfg.enable && codec_if->enable) {
+        if (codec_if->enable(codec_if, true) != CODEC_DEV_OK) {
+            fprintf(stderr, "Fail to enable codec\n");
+            return 1;
+        }
+    }
+    return 0;
+}
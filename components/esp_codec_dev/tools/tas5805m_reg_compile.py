@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+#
+# ESPRESSIF MIT License
+#
+# Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+#
+# Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+# it is free of charge, to any person obtaining a copy of this software and associated
+# documentation files (the "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+# to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all copies or
+# substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+# FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+# COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+# IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+"""
+Compile the TAS5805M register table (PPC3 style offset/value pairs) into a register program
+
+- Book and page selects which do not change the current book/page are removed
+- Writes to consecutive registers of the same page are merged into CFG_META_BURST runs
+- CFG_META_DELAY entries are kept, CFG_META_SWITCH entries are dropped (ignored by driver)
+
+The program uses the same tas5805m_cfg_reg_t layout so that it is sent by tas5805m_transmit_registers().
+Burst run layout: {CFG_META_BURST, n}, {reg, data0}, {data1, data2} ... n is the number of data bytes.
+
+Usage:
+    tas5805m_reg_compile.py driver/tas5805m/tas5805m_reg_cfg.h driver/tas5805m/tas5805m_reg_program.h
+"""
+
+import argparse
+import os
+import re
+import sys
+
+CFG_META_SWITCH = 255
+CFG_META_DELAY = 254
+CFG_META_BURST = 253
+CFG_END_1 = 0xaa
+CFG_END_2 = 0xcc
+CFG_END_3 = 0xee
+META_NAMES = {'CFG_META_SWITCH': CFG_META_SWITCH, 'CFG_META_DELAY': CFG_META_DELAY, 'CFG_META_BURST': CFG_META_BURST,
+              'CFG_END_1': CFG_END_1, 'CFG_END_2': CFG_END_2, 'CFG_END_3': CFG_END_3}
+
+PAGE_REG = 0x00
+BOOK_REG = 0x7f    # book select, only on page 0
+RESET_REG = 0x01   # RESET_CTRL on book 0 page 0
+MAX_BURST = 128    # registers of one page
+PAIRS_PER_LINE = 8
+
+
+def parse_value(text):
+    text = text.strip()
+    if text in META_NAMES:
+        return META_NAMES[text]
+    return int(text, 0)
+
+
+def parse_table(path, name):
+    """Return list of (offset, value) of table `name`, honoring simple #if 0/1 blocks"""
+    lines = open(path).read().splitlines()
+    start = next(i for i, line in enumerate(lines) if re.search(r'\b%s\s*\[\s*\]\s*=' % name, line))
+    entries = []
+    active = [True]
+    for line in lines[start + 1:]:
+        code = line.split('//')[0].strip()
+        if code.startswith('#if'):
+            cond = code.split()[1] if len(code.split()) > 1 else '1'
+            active.append(active[-1] and cond not in ('0', 'false'))
+            continue
+        if code.startswith('#else'):
+            parent = active[-2]
+            active[-1] = parent and not active[-1]
+            continue
+        if code.startswith('#endif'):
+            active.pop()
+            continue
+        if code.startswith('};'):
+            break
+        if not active[-1]:
+            continue
+        for m in re.finditer(r'\{\s*([\w]+)\s*,\s*([\w]+)\s*\}', code):
+            entries.append((parse_value(m.group(1)), parse_value(m.group(2))))
+    return entries
+
+
+def expand(entries):
+    """Expand existing burst runs into single writes, return list of ('w', reg, val) / ('d', ms)"""
+    ops = []
+    i = 0
+    while i < len(entries):
+        offset, value = entries[i]
+        if offset == CFG_META_DELAY:
+            ops.append(('d', value))
+        elif offset == CFG_META_BURST:
+            data = [b for e in entries[i + 1:i + 2 + value // 2] for b in e]
+            reg = data[0]
+            for k in range(value):
+                ops.append(('w', reg + k, data[1 + k]))
+            i += value // 2 + 1
+        elif offset == CFG_META_SWITCH:
+            pass
+        elif offset == CFG_END_1 and i + 2 < len(entries) and entries[i + 1][0] == CFG_END_2 \
+                and entries[i + 2][0] == CFG_END_3:
+            i += 2
+        else:
+            ops.append(('w', offset, value))
+        i += 1
+    return ops
+
+
+def compile_ops(ops):
+    """Return list of items: ('w', reg, val), ('b', reg, [values]), ('d', ms)"""
+    out = []
+    run = []
+    book = page = None
+    keep_dummy = False
+
+    def flush():
+        if len(run) == 1:
+            out.append(('w', run[0][0], run[0][1]))
+        elif run:
+            out.append(('b', run[0][0], [v for _, v in run]))
+        del run[:]
+
+    for op in ops:
+        if op[0] == 'd':
+            flush()
+            out.append(op)
+            continue
+        _, reg, val = op
+        if reg == PAGE_REG:
+            # dummy page writes right after a device reset give it time to settle, keep them
+            if page == val and not (keep_dummy and val == 0):
+                continue
+            flush()
+            out.append(op)
+            page = val
+            continue
+        keep_dummy = False
+        if reg == BOOK_REG and page != 0:
+            if page is None:
+                book = None
+        elif reg == BOOK_REG:
+            if book == val:
+                continue
+            flush()
+            out.append(op)
+            book = val
+            continue
+        if run and run[-1][0] + 1 == reg and len(run) < MAX_BURST:
+            run.append((reg, val))
+        else:
+            flush()
+            run.append((reg, val))
+        if reg == RESET_REG and book == 0 and page == 0 and val:
+            # do not rely on book and page after reset, select them again
+            flush()
+            book = page = None
+            keep_dummy = True
+    flush()
+    return out
+
+
+def simulate(items):
+    """Replay writes on a book/page register model, return final register map and write order"""
+    regs = {}
+    order = []
+    book = page = 0
+    for item in items:
+        if item[0] == 'd':
+            order.append(('d', item[1]))
+            continue
+        values = [item[2]] if item[0] == 'w' else item[2]
+        for k, val in enumerate(values):
+            reg = item[1] + k
+            if reg == PAGE_REG:
+                page = val
+                continue
+            if reg == BOOK_REG and page == 0:
+                book = val
+                continue
+            regs[(book, page, reg)] = val
+            order.append((book, page, reg, val))
+    return regs, order
+
+
+def transactions(items):
+    return sum(1 for item in items if item[0] != 'd')
+
+
+def format_items(items):
+    lines = []
+    for item in items:
+        if item[0] == 'd':
+            lines.append('    {CFG_META_DELAY, %d},' % item[1])
+        elif item[0] == 'w':
+            lines.append('    {0x%02x, 0x%02x},' % (item[1], item[2]))
+        else:
+            data = [item[1]] + item[2]
+            if len(data) % 2:
+                data.append(0)
+            pairs = ['{0x%02x, 0x%02x}' % (data[k], data[k + 1]) for k in range(0, len(data), 2)]
+            lines.append('    {CFG_META_BURST, %d},' % len(item[2]))
+            for k in range(0, len(pairs), PAIRS_PER_LINE):
+                lines.append('        %s,' % ', '.join(pairs[k:k + PAIRS_PER_LINE]))
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compile TAS5805M register table into burst register program')
+    parser.add_argument('input', help='header holding the register table')
+    parser.add_argument('output', help='generated register program header')
+    parser.add_argument('--table', default='tas5805m_registers', help='name of the register table')
+    parser.add_argument('--name', default='tas5805m_reg_program', help='name of the generated register program')
+    args = parser.parse_args()
+
+    entries = parse_table(args.input, args.table)
+    ops = expand(entries)
+    items = compile_ops(ops)
+    if simulate(items) != simulate([op for op in ops]):
+        sys.exit('Compiled register program does not match register table')
+    before = sum(1 for op in ops if op[0] == 'w')
+    after = transactions(items)
+    license_text = open(args.input).read().split('*/')[0] + '*/\n'
+    guard = '_%s_H_' % args.name.upper()
+    body = [
+        license_text.rstrip(),
+        '',
+        '/* Generated by tools/%s from %s, do not edit' % (os.path.basename(sys.argv[0]), os.path.basename(args.input)),
+        ' * %d register writes compiled into %d I2C transactions' % (before, after),
+        ' */',
+        '#ifndef %s' % guard,
+        '#define %s' % guard,
+        '',
+        '#include "%s"' % os.path.basename(args.input),
+        '',
+        '#ifdef __cplusplus',
+        'extern "C" {',
+        '#endif',
+        '',
+        '// clang-format off',
+        'static const tas5805m_cfg_reg_t %s[] = {' % args.name,
+    ] + format_items(items) + [
+        '};',
+        '// clang-format on',
+        '',
+        '#ifdef __cplusplus',
+        '}',
+        '#endif',
+        '',
+        '#endif',
+        '',
+    ]
+    with open(args.output, 'w') as f:
+        f.write('\n'.join(body))
+    print('%d entries, %d register writes -> %d transactions, %d table entries' %
+          (len(entries), before, after, sum(1 for line in format_items(items) for _ in re.finditer(r'\{', line))))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+#
+# ESPRESSIF MIT License
+#
+# Copyright (c) 2022 <ESPRESSIF SYSTEMS (SHANGHAI) CO., LTD>
+#
+# Permission is hereby granted for use on all ESPRESSIF SYSTEMS products, in which case,
+# it is free of charge, to any person obtaining a copy of this software and associated
+# documentation files (the "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the Software is furnished
+# to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in all copies or
+# substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+# FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+# COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+# IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+# CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+"""
+Pack ZL38063 firmware into the compressed image read by vproc_fw_stream.c
+
+Input is either the pre-compiled firmware archive (libfirmware.a, record array
+`st_twFirmware`) or a Microsemi *.s3 firmware file.
+
+Image layout (little endian):
+    header (32 bytes)
+        magic "ZLFZ", u16 version, u8 window_bits, u8 reserved,
+        u32 raw_size, u32 comp_size, u32 exec_addr, u32 prgm_base,
+        u8 have_prgm_base, 3 bytes reserved, u32 crc32 of raw stream
+    LZ compressed raw stream (comp_size bytes)
+
+Raw stream is a list of segments, each covering continuous device RAM:
+    u32 target address, u16 number of words, words (u16 each)
+
+LZ sequence: token byte (high nibble literal length, low nibble match length - 4),
+literal length extension bytes (when 15, each 255 continues), literals,
+u16 match offset (1 .. window size), match length extension bytes (when 15).
+The last sequence carries literals only, decoding stops at raw_size.
+
+Usage:
+    zl38063_fw_pack.py driver/zl38063/firmware/libfirmware.a [driver/zl38063/firmware/zl38063_firmware_lz.bin]
+
+Output defaults to zl38063_firmware_lz.bin beside the input, which is the image embedded by the component build.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAGIC = b'ZLFZ'
+VERSION = 1
+MIN_MATCH = 4
+MAX_CHAIN = 64
+REC_SIZE = 44  # twFwr on ESP32: u16 buf[16], u16 numWords, u32 targetAddr, u8 useTargetAddr
+
+
+def read_archive_member(path, member):
+    data = open(path, 'rb').read()
+    if data[:8] != b'!<arch>\n':
+        raise ValueError('%s is not an archive' % path)
+    pos = 8
+    long_names = b''
+    while pos + 60 <= len(data):
+        name = data[pos:pos + 16].decode().strip()
+        size = int(data[pos + 48:pos + 58].decode().strip())
+        if name == '//':
+            long_names = data[pos + 60:pos + 60 + size]
+        elif name.startswith('/') and name[1:].isdigit():
+            # GNU long member name stored in '//' table
+            start = int(name[1:])
+            name = long_names[start:long_names.index(b'\n', start)].decode()
+        if name.rstrip('/') == member:
+            return data[pos + 60:pos + 60 + size]
+        pos += 60 + size + (size & 1)
+    raise ValueError('%s not found in %s' % (member, path))
+
+
+def elf_symbols(obj):
+    """Return {name: bytes} for symbols defined in sections of an ELF32 LE object"""
+    shoff, = struct.unpack_from('<I', obj, 0x20)
+    shentsize, shnum, shstrndx = struct.unpack_from('<HHH', obj, 0x2E)
+    sections = [struct.unpack_from('<IIIIIIIIII', obj, shoff + i * shentsize) for i in range(shnum)]
+    symbols = {}
+    for sec in sections:
+        if sec[1] != 2:  # SHT_SYMTAB
+            continue
+        strtab = sections[sec[6]]
+        for off in range(sec[4], sec[4] + sec[5], 16):
+            st_name, st_value, st_size, _, _, st_shndx = struct.unpack_from('<IIIBBH', obj, off)
+            if st_shndx == 0 or st_shndx >= shnum or st_size == 0:
+                continue
+            end = obj.index(b'\0', strtab[4] + st_name)
+            name = obj[strtab[4] + st_name:end].decode()
+            base = sections[st_shndx][4] + st_value
+            symbols[name] = obj[base:base + st_size]
+    return symbols
+
+
+def load_archive(path):
+    sym = elf_symbols(read_archive_member(path, 'zl38063_firmware.o'))
+    count, = struct.unpack('<H', sym['firmwareStreamLen'])
+    records = []
+    for i in range(count):
+        rec = sym['st_twFirmware'][i * REC_SIZE:(i + 1) * REC_SIZE]
+        num, = struct.unpack_from('<H', rec, 32)
+        addr, = struct.unpack_from('<I', rec, 36)
+        records.append((addr, list(struct.unpack_from('<%dH' % num, rec, 0))))
+    info = (struct.unpack('<I', sym['executionAddress'])[0], struct.unpack('<I', sym['programBaseAddress'])[0],
+            sym['haveProgramBaseAddress'][0])
+    return records, info
+
+
+def load_s3(path):
+    records = []
+    exec_addr = 0
+    for line in open(path):
+        line = line.strip()
+        if len(line) < 4 or line[0] != 'S':
+            continue
+        rec_type = int(line[1])
+        count = int(line[2:4], 16)
+        if rec_type == 3:
+            addr = int(line[4:12], 16)
+            num = (count - 5) // 2
+            words = [int(line[12 + i * 4:16 + i * 4], 16) for i in range(num)]
+            records.append((addr, words))
+        elif rec_type == 7:
+            exec_addr = int(line[4:12], 16)
+    return records, (exec_addr, 0, 0)
+
+
+def build_raw(records):
+    """Merge records with continuous address into segments"""
+    segments = []
+    for addr, words in records:
+        if not words:
+            continue
+        if segments and segments[-1][0] + len(segments[-1][1]) * 2 == addr:
+            segments[-1][1].extend(words)
+        else:
+            segments.append((addr, list(words)))
+    raw = bytearray()
+    for addr, words in segments:
+        raw += struct.pack('<IH', addr, len(words))
+        raw += struct.pack('<%dH' % len(words), *words)
+    return bytes(raw), len(segments)
+
+
+def put_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def lz_compress(data, window):
+    out = bytearray()
+    head = {}
+    prev = [0] * len(data)
+    i = lit_start = 0
+    n = len(data)
+
+    def insert(pos):
+        if pos + MIN_MATCH <= n:
+            key = data[pos:pos + MIN_MATCH]
+            prev[pos] = head.get(key, -1)
+            head[key] = pos
+
+    while i < n:
+        best_len = best_off = 0
+        if i + MIN_MATCH <= n:
+            cand = head.get(data[i:i + MIN_MATCH], -1)
+            chain = 0
+            while cand >= 0 and i - cand <= window and chain < MAX_CHAIN:
+                length = 0
+                while i + length < n and data[cand + length] == data[i + length]:
+                    length += 1
+                if length > best_len:
+                    best_len, best_off = length, i - cand
+                cand = prev[cand]
+                chain += 1
+        if best_len < MIN_MATCH:
+            insert(i)
+            i += 1
+            continue
+        lit = data[lit_start:i]
+        ml = best_len - MIN_MATCH
+        out.append((min(len(lit), 15) << 4) | min(ml, 15))
+        if len(lit) >= 15:
+            put_length(out, len(lit) - 15)
+        out += lit
+        out += struct.pack('<H', best_off)
+        if ml >= 15:
+            put_length(out, ml - 15)
+        for k in range(best_len):
+            insert(i + k)
+        i += best_len
+        lit_start = i
+    lit = data[lit_start:]
+    out.append(min(len(lit), 15) << 4)
+    if len(lit) >= 15:
+        put_length(out, len(lit) - 15)
+    out += lit
+    return bytes(out)
+
+
+def lz_decompress(comp, raw_size, window):
+    out = bytearray()
+    pos = 0
+    while len(out) < raw_size:
+        token = comp[pos]
+        pos += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = comp[pos]
+                pos += 1
+                lit += b
+                if b != 255:
+                    break
+        out += comp[pos:pos + lit]
+        pos += lit
+        if len(out) >= raw_size:
+            break
+        off, = struct.unpack_from('<H', comp, pos)
+        pos += 2
+        ml = token & 0xF
+        if ml == 15:
+            while True:
+                b = comp[pos]
+                pos += 1
+                ml += b
+                if b != 255:
+                    break
+        assert 0 < off <= window
+        for _ in range(ml + MIN_MATCH):
+            out.append(out[-off])
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Pack ZL38063 firmware into compressed image')
+    parser.add_argument('input', help='libfirmware.a or *.s3 firmware file')
+    parser.add_argument('output', nargs='?', help='compressed image to generate (default: zl38063_firmware_lz.bin '
+                        'beside the input)')
+    parser.add_argument('--window-bits', type=int, default=11, help='LZ window size in bits (decoder RAM)')
+    args = parser.parse_args()
+    if args.output is None:
+        args.output = os.path.join(os.path.dirname(args.input), 'zl38063_firmware_lz.bin')
+    if args.input.endswith('.a'):
+        records, info = load_archive(args.input)
+    else:
+        records, info = load_s3(args.input)
+    raw, seg_num = build_raw(records)
+    window = 1 << args.window_bits
+    comp = lz_compress(raw, window)
+    if lz_decompress(comp, len(raw), window) != raw:
+        sys.exit('Verify compressed image failed')
+    header = MAGIC + struct.pack('<HBBIIIIB3xI', VERSION, args.window_bits, 0, len(raw), len(comp), info[0], info[1],
+                                 info[2], zlib.crc32(raw) & 0xFFFFFFFF)
+    with open(args.output, 'wb') as f:
+        f.write(header + comp)
+    print('records:%d segments:%d raw:%d compressed:%d (%.1f%%)' %
+          (len(records), seg_num, len(raw), len(comp), 100.0 * len(comp) / len(raw)))
+
+
+if __name__ == '__main__':
+    main()
@@ -1,5 +1,6 @@
 #include <string.h>
 #include <stdio.h>
+#include <inttypes.h>
 #include "audio_board.h"
 #include "driver/i2s.h"
 #include "driver/i2c.h"
@@ -12,6 +13,10 @@
 
 #define ESP_INTR_FLG_DEFAULT   (0)
 #define ESP_I2C_MASTER_BUF_LEN (0)
+#define I2C_STANDARD_SPEED     (100000)
+#define I2C_FAST_SPEED         (400000)
+#define I2C_FAST_PLUS_SPEED    (1000000)
+#define I2S_MCLK_MULTIPLE      (256)
 
 #define DEFAULT_I2S_CFG                                             \
     {.mode = (i2s_mode_t) (I2S_MODE_TX | I2S_MODE_RX),              \
@@ -54,12 +59,15 @@ static int fill_i2c_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr)
     cfg->i2c_bus_cfg = new_i2c_bus;
     audio_board_i2c_cfg_t *i2c_cfg = &new_i2c_bus[cfg->i2c_bus_num];
     i2c_cfg->master_mode = true;
+    i2c_cfg->clk_speed = I2C_STANDARD_SPEED;
     cfg->i2c_bus_num++;
     while (attr) {
         if (str_same(attr->attr, "sda")) {
             i2c_cfg->sda_pin = atoi(attr->value);
         } else if (str_same(attr->attr, "scl")) {
             i2c_cfg->scl_pin = atoi(attr->value);
+        } else if (str_same(attr->attr, "speed")) {
+            i2c_cfg->clk_speed = (uint32_t) atoi(attr->value);
         }
         attr = attr->next;
     }
@@ -102,6 +110,20 @@ static void clear_spi_cfg(audio_board_spi_cfg_t *spi_cfg)
     spi_cfg->sclk_pin = -1;
     spi_cfg->quadwp_pin = -1;
     spi_cfg->quadhd_pin = -1;
+    spi_cfg->host = 0;
+    spi_cfg->dma_chan = 0;
+}
+
+static int get_spi_dma_chan(const char *value)
+{
+    if (str_same(value, "auto")) {
+#if (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 3, 0))
+        return SPI_DMA_CH_AUTO;
+#else
+        return 1;
+#endif
+    }
+    return atoi(value);
 }
 
 static int fill_spi_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr)
@@ -122,6 +144,10 @@ static int fill_spi_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr)
             spi_cfg->sclk_pin = atoi(attr->value);
         } else if (str_same(attr->attr, "miso")) {
             spi_cfg->miso_pin = atoi(attr->value);
+        } else if (str_same(attr->attr, "host")) {
+            spi_cfg->host = (uint8_t) atoi(attr->value);
+        } else if (str_same(attr->attr, "dma")) {
+            spi_cfg->dma_chan = (int8_t) get_spi_dma_chan(attr->value);
         }
         attr = attr->next;
     }
@@ -174,6 +200,7 @@ static void reset_i2c_dev_cfg(codec_i2c_dev_cfg_t *i2c_cfg)
 {
     i2c_cfg->port = 0;
     i2c_cfg->addr = 0;
+    i2c_cfg->speed = 0;
 }
 
 static codec_i2c_dev_cfg_t *codec_check_i2c_ready(audio_board_cfg_t *cfg, int port)
@@ -199,6 +226,9 @@ static codec_i2c_dev_cfg_t *codec_check_i2c_ready(audio_board_cfg_t *cfg, int po
 static void reset_i2s_dev_cfg(codec_i2s_dev_cfg_t *i2s_cfg)
 {
     i2s_cfg->port = 0;
+    // Same MCLK setting as I2S driver installed so that codec knows MCLK generated
+    i2s_cfg->mclk_multiple = I2S_MCLK_MULTIPLE;
+    i2s_cfg->fixed_mclk = 0;
 }
 
 static codec_i2s_dev_cfg_t *codec_check_i2s_ready(audio_board_cfg_t *cfg, int port)
@@ -225,6 +255,8 @@ static void reset_spi_dev_cfg(codec_spi_dev_cfg_t *spi_cfg)
 {
     spi_cfg->cs_pin = -1;
     spi_cfg->spi_port = 0;
+    spi_cfg->clock_speed = 0;
+    spi_cfg->use_dma = false;
 }
 
 static codec_spi_dev_cfg_t *codec_check_spi_ready(audio_board_cfg_t *cfg, int port)
@@ -243,7 +275,6 @@ static codec_spi_dev_cfg_t *codec_check_spi_ready(audio_board_cfg_t *cfg, int po
     }
     cfg->spi_dev_num = need_num;
     cfg->spi_dev_cfg = spi_cfg;
-    spi_cfg[port].spi_port = port;
     return &spi_cfg[port];
 }
 
@@ -280,6 +311,7 @@ static int fill_codec_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr, codec_
     audio_board_codec_cfg_t *codec_cfg = &new_codec_cfg[cfg->codec_num];
     clear_codec_cfg(codec_cfg);
     codec_cfg->io_cfg.codec_mode = codec_mode;
+    bool use_mclk_set = false;
 
     // set i2c default control port
     if (codec_cfg->ctrl_media == AUDIO_BOARD_MEDIA_I2C) {
@@ -299,6 +331,9 @@ static int fill_codec_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr, codec_
             codec_cfg->io_cfg.pa_pin = (int16_t) atoi(attr->value);
         } else if (str_same(attr->attr, "pa_gain")) {
             codec_cfg->pa_gain = atof(attr->value);
+        } else if (str_same(attr->attr, "use_mclk")) {
+            codec_cfg->io_cfg.use_mclk = (atoi(attr->value) != 0);
+            use_mclk_set = true;
         } else if (str_same(attr->attr, "spi_port")) {
             int port = get_ctrl_media_idx(cfg, AUDIO_BOARD_MEDIA_SPI);
             codec_spi_dev_cfg_t *spi_dev = codec_check_spi_ready(cfg, port);
@@ -306,7 +341,13 @@ static int fill_codec_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr, codec_
                 codec_cfg->ctrl_media = AUDIO_BOARD_MEDIA_SPI;
                 codec_cfg->ctrl_port = port;
                 port = atoi(attr->value);
-                spi_dev->spi_port = port;
+                // use host and DMA setting of the installed SPI bus
+                if (port < cfg->spi_bus_num) {
+                    spi_dev->spi_port = cfg->spi_bus_cfg[port].host;
+                    spi_dev->use_dma = (cfg->spi_bus_cfg[port].dma_chan != 0);
+                } else {
+                    spi_dev->spi_port = 0;
+                }
             } else {
                 ESP_LOGE(TAG, "Fail to alloc spi dev memory");
             }
@@ -324,6 +365,13 @@ static int fill_codec_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr, codec_
                     spi_dev->cs_pin = atoi(attr->value);
                 }
             }
+        } else if (str_same(attr->attr, "spi_speed")) {
+            if (codec_cfg->ctrl_media == AUDIO_BOARD_MEDIA_SPI) {
+                codec_spi_dev_cfg_t *spi_dev = codec_check_spi_ready(cfg, codec_cfg->ctrl_port);
+                if (spi_dev) {
+                    spi_dev->clock_speed = (uint32_t) atoi(attr->value);
+                }
+            }
         } else if (str_same(attr->attr, "i2c_port")) {
             if (codec_cfg->ctrl_media == AUDIO_BOARD_MEDIA_I2C) {
                 codec_i2c_dev_cfg_t *i2c_dev = codec_check_i2c_ready(cfg, codec_cfg->ctrl_port);
@@ -339,6 +387,13 @@ static int fill_codec_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr, codec_
                     i2c_dev->addr = atoi(attr->value);
                 }
             }
+        } else if (str_same(attr->attr, "i2c_speed")) {
+            if (codec_cfg->ctrl_media == AUDIO_BOARD_MEDIA_I2C) {
+                codec_i2c_dev_cfg_t *i2c_dev = codec_check_i2c_ready(cfg, codec_cfg->ctrl_port);
+                if (i2c_dev) {
+                    i2c_dev->speed = (uint32_t) atoi(attr->value);
+                }
+            }
         }
         attr = attr->next;
     }
@@ -348,7 +403,11 @@ static int fill_codec_cfg(audio_board_cfg_t *cfg, board_cfg_attr_t *attr, codec_
     }
     // alloc default dev for i2s
     if (codec_cfg->data_media == AUDIO_BOARD_MEDIA_I2S) {
-        codec_check_i2s_ready(cfg, codec_cfg->data_port);
+        codec_i2s_dev_cfg_t *i2s_dev = codec_check_i2s_ready(cfg, codec_cfg->data_port);
+        // codec use MCLK only when MCLK pin of I2S bus is set if not configured
+        if (i2s_dev && use_mclk_set == false && i2s_dev->port < cfg->i2s_bus_num) {
+            codec_cfg->io_cfg.use_mclk = (cfg->i2s_bus_cfg[i2s_dev->port].mck_pin >= 0);
+        }
     }
     // increase codec num
     cfg->codec_num++;
@@ -482,8 +541,8 @@ static int _i2c_install(int port, audio_board_i2c_cfg_t *cfg)
         .mode = cfg->master_mode ? I2C_MODE_MASTER : I2C_MODE_SLAVE,
         .sda_pullup_en = GPIO_PULLUP_ENABLE,
         .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master.clk_speed = 100000,
     };
+    i2c_cfg.master.clk_speed = cfg->clk_speed ? cfg->clk_speed : I2C_STANDARD_SPEED;
     i2c_cfg.sda_io_num = cfg->sda_pin;
     i2c_cfg.scl_io_num = cfg->scl_pin;
     esp_err_t ret = i2c_param_config(port, &i2c_cfg);
@@ -495,7 +554,7 @@ static int _i2c_install(int port, audio_board_i2c_cfg_t *cfg)
         ESP_LOGE(TAG, "Fail to Install I2C driver for port %d", port);
         return -1;
     }
-    ESP_LOGI(TAG, "Install I2C driver for port %d OK", port);
+    ESP_LOGI(TAG, "Install I2C driver for port %d speed %" PRIu32 " OK", port, i2c_cfg.master.clk_speed);
     return 0;
 }
 
@@ -505,11 +564,90 @@ static int _i2c_uninstall(int port)
     return 0;
 }
 
+static uint32_t _i2c_lower_speed(uint32_t speed)
+{
+    if (speed > I2C_FAST_SPEED) {
+        return I2C_FAST_SPEED;
+    }
+    return I2C_STANDARD_SPEED;
+}
+
+static int _i2c_set_speed(int port, audio_board_i2c_cfg_t *bus_cfg, uint32_t speed)
+{
+    if (bus_cfg->clk_speed == speed) {
+        return 0;
+    }
+    // Clock can only be changed through driver re-installation
+    _i2c_uninstall(port);
+    bus_cfg->clk_speed = speed;
+    return _i2c_install(port, bus_cfg);
+}
+
+static int _i2c_read_reg(uint8_t port, uint8_t addr, uint8_t reg, uint8_t *value)
+{
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    esp_err_t ret = i2c_master_start(cmd);
+    ret |= i2c_master_write_byte(cmd, addr, 1);
+    ret |= i2c_master_write_byte(cmd, reg, 1);
+    ret |= i2c_master_start(cmd);
+    ret |= i2c_master_write_byte(cmd, addr | 0x01, 1);
+    ret |= i2c_master_read_byte(cmd, value, I2C_MASTER_NACK);
+    ret |= i2c_master_stop(cmd);
+    ret |= i2c_master_cmd_begin(port, cmd, 100 / portTICK_RATE_MS);
+    i2c_cmd_link_delete(cmd);
+    return ret == ESP_OK ? 0 : -1;
+}
+
+int audio_board_i2c_probe(audio_board_cfg_t *cfg, codec_i2c_dev_cfg_t *dev_cfg, int id_reg)
+{
+    if (cfg == NULL || dev_cfg == NULL || dev_cfg->port >= cfg->i2c_bus_num) {
+        return -1;
+    }
+    audio_board_i2c_cfg_t *bus_cfg = &cfg->i2c_bus_cfg[dev_cfg->port];
+    uint32_t speed = bus_cfg->clk_speed;
+    // Bus runs at speed of slowest device
+    while (dev_cfg->speed && speed > dev_cfg->speed && speed > I2C_STANDARD_SPEED) {
+        speed = _i2c_lower_speed(speed);
+    }
+    if (id_reg < 0) {
+        return _i2c_set_speed(dev_cfg->port, bus_cfg, speed);
+    }
+    while (1) {
+        if (_i2c_set_speed(dev_cfg->port, bus_cfg, speed) != 0) {
+            return -1;
+        }
+        uint8_t chip_id = 0;
+        if (_i2c_read_reg(dev_cfg->port, dev_cfg->addr, (uint8_t) id_reg, &chip_id) == 0) {
+            ESP_LOGI(TAG, "I2C dev %02x on port %d id %02x speed %" PRIu32, dev_cfg->addr, dev_cfg->port, chip_id, speed);
+            dev_cfg->speed = speed;
+            return 0;
+        }
+        if (speed <= I2C_STANDARD_SPEED) {
+            break;
+        }
+        ESP_LOGW(TAG, "I2C dev %02x no ack at speed %" PRIu32 ", try lower speed", dev_cfg->addr, speed);
+        speed = _i2c_lower_speed(speed);
+    }
+    ESP_LOGE(TAG, "I2C dev %02x on port %d not found", dev_cfg->addr, dev_cfg->port);
+    return -1;
+}
+
+uint32_t audio_board_get_i2c_speed(audio_board_cfg_t *cfg, int port)
+{
+    if (cfg == NULL || port >= cfg->i2c_bus_num) {
+        return 0;
+    }
+    return cfg->i2c_bus_cfg[port].clk_speed;
+}
+
 static int _i2s_install(uint8_t dev_port, audio_board_i2s_cfg_t *i2s_pin)
 {
     i2s_config_t i2s_config = DEFAULT_I2S_CFG;
 #if (ESP_IDF_VERSION_MAJOR >= 4) && (ESP_IDF_VERSION_MINOR > 2)
     i2s_config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+#endif
+#if (ESP_IDF_VERSION_MAJOR >= 4) && (ESP_IDF_VERSION_MINOR > 3)
+    i2s_config.mclk_multiple = I2S_MCLK_MULTIPLE;
 #endif
     if (i2s_pin->master_mode || i2s_pin->dac_mode) {
         i2s_config.mode |= I2S_MODE_MASTER;
@@ -555,6 +693,18 @@ static int _i2s_uninstall(uint8_t dev_port)
     return 0;
 }
 
+static spi_host_device_t get_spi_host(audio_board_spi_cfg_t *spi_cfg)
+{
+    if (spi_cfg->host) {
+        return (spi_host_device_t) spi_cfg->host;
+    }
+#if (ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(4, 0, 0))
+    return HSPI_HOST;
+#else
+    return SPI3_HOST;
+#endif
+}
+
 static int _spi_install(audio_board_spi_cfg_t *spi_cfg)
 {
     esp_err_t ret;
@@ -564,26 +714,21 @@ static int _spi_install(audio_board_spi_cfg_t *spi_cfg)
     bus_cfg.sclk_io_num = spi_cfg->sclk_pin;
     bus_cfg.quadwp_io_num = spi_cfg->quadwp_pin;
     bus_cfg.quadhd_io_num = spi_cfg->quadhd_pin;
-#if (ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(4, 0, 0))
-    ret = spi_bus_initialize(HSPI_HOST, &bus_cfg, 0);
-#else
-    ret = spi_bus_initialize(SPI3_HOST, &bus_cfg, 0);
-    ESP_LOGI(TAG, "Add bus mosi:%d miso:%d sclk:%d quadw:%d quadh:%d sz:%d\n", bus_cfg.mosi_io_num, bus_cfg.miso_io_num,
-           bus_cfg.sclk_io_num, bus_cfg.quadwp_io_num, bus_cfg.quadhd_io_num, bus_cfg.max_transfer_sz);
-#endif
+    if (spi_cfg->dma_chan) {
+        // Allow one DMA transfer to carry firmware block
+        bus_cfg.max_transfer_sz = 4096;
+    }
+    ret = spi_bus_initialize(get_spi_host(spi_cfg), &bus_cfg, spi_cfg->dma_chan);
+    ESP_LOGI(TAG, "Add bus mosi:%d miso:%d sclk:%d quadw:%d quadh:%d sz:%d dma:%d\n", bus_cfg.mosi_io_num,
+             bus_cfg.miso_io_num, bus_cfg.sclk_io_num, bus_cfg.quadwp_io_num, bus_cfg.quadhd_io_num,
+             bus_cfg.max_transfer_sz, spi_cfg->dma_chan);
     ESP_LOGI(TAG, "Initial spi bus return %d", ret);
     return ret;
 }
 
-static int _spi_uninstall()
+static int _spi_uninstall(audio_board_spi_cfg_t *spi_cfg)
 {
-    int ret;
-#if (ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(4, 0, 0))
-    ret = spi_bus_free(HSPI_HOST);
-#else
-    ret = spi_bus_free(SPI3_HOST);
-#endif
-    return ret;
+    return spi_bus_free(get_spi_host(spi_cfg));
 }
 
 int audio_board_install_device(audio_board_cfg_t *cfg)
@@ -630,7 +775,7 @@ int audio_board_uninstall_device(audio_board_cfg_t *cfg)
     // install spi driver
     // TODO currently only support one SPI
     if (cfg->spi_bus_num == 1) {
-        _spi_uninstall();
+        _spi_uninstall(cfg->spi_bus_cfg);
     }
     return 0;
 }
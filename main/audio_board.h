@@ -2,9 +2,10 @@
 #include "codec_dev_types.h"
 
 typedef struct {
-    bool    master_mode;
-    int16_t scl_pin;
-    int16_t sda_pin;
+    bool     master_mode;
+    int16_t  scl_pin;
+    int16_t  sda_pin;
+    uint32_t clk_speed;
 } audio_board_i2c_cfg_t;
 
 typedef struct {
@@ -24,6 +25,8 @@ typedef struct {
     int16_t sclk_pin;
     int16_t quadwp_pin;
     int16_t quadhd_pin;
+    uint8_t host;     /* SPI host, 0 to use default host */
+    int8_t  dma_chan; /* DMA channel, 0 to disable DMA */
 } audio_board_spi_cfg_t;
 
 typedef enum {
@@ -100,4 +103,8 @@ int audio_board_install_device(audio_board_cfg_t *cfg);
 
 int audio_board_uninstall_device(audio_board_cfg_t *cfg);
 
+int audio_board_i2c_probe(audio_board_cfg_t *cfg, codec_i2c_dev_cfg_t *dev_cfg, int id_reg);
+
+uint32_t audio_board_get_i2c_speed(audio_board_cfg_t *cfg, int port);
+
 void audio_board_free_cfg(audio_board_cfg_t *cfg);
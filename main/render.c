@@ -1,4 +1,5 @@
 #include <math.h>
+#include <inttypes.h>
 #include <string.h>
 #include "driver/gpio.h"
 #include "esp_log.h"
@@ -50,6 +51,7 @@ typedef struct {
     audio_board_media_t          ctrl_media[MAX_RENDER_DEV_NUM];
     uint8_t                      ctrl_port[MAX_RENDER_DEV_NUM];
     const audio_codec_ctrl_if_t *ctrl_if[MAX_RENDER_DEV_NUM];
+    const audio_codec_ctrl_if_t *raw_ctrl_if[MAX_RENDER_DEV_NUM];
     audio_board_media_t          data_media[MAX_RENDER_DEV_NUM];
     uint8_t                      data_port[MAX_RENDER_DEV_NUM];
     const audio_codec_data_if_t *data_if[MAX_RENDER_DEV_NUM];
@@ -160,12 +162,14 @@ static int play_internal()
     return 0;
 }
 
-static void add_ctrl_if(audio_board_media_t media, uint8_t port, const audio_codec_ctrl_if_t *ctrl_if)
+static void add_ctrl_if(audio_board_media_t media, uint8_t port, const audio_codec_ctrl_if_t *ctrl_if,
+                        const audio_codec_ctrl_if_t *raw_ctrl_if)
 {
     int i;
     for (i = 0; i < MAX_RENDER_DEV_NUM; i++) {
         if (render_res.ctrl_if[i] == NULL) {
             render_res.ctrl_if[i] = ctrl_if;
+            render_res.raw_ctrl_if[i] = raw_ctrl_if;
             render_res.ctrl_media[i] = media;
             render_res.ctrl_port[i] = port;
             break;
@@ -250,6 +254,44 @@ static uint8_t get_codec_default_addr(audio_board_codec_type_t codec_type)
     }
 }
 
+static int get_codec_id_reg(audio_board_codec_type_t codec_type)
+{
+    switch (codec_type) {
+        case AUDIO_BOARD_CODEC_ES8311:
+        case AUDIO_BOARD_CODEC_ES8156:
+        case AUDIO_BOARD_CODEC_ES7243E:
+            return 0xFD;
+        case AUDIO_BOARD_CODEC_ES7210:
+            return 0x3D;
+        case AUDIO_BOARD_CODEC_TAS5805M:
+            // Device keep in reset until codec open, skip probe
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+static const codec_reg_cache_desc_t *get_codec_cache_desc(audio_board_codec_type_t codec_type)
+{
+    switch (codec_type) {
+        case AUDIO_BOARD_CODEC_ES8311:
+            return &es8311_reg_cache_desc;
+        case AUDIO_BOARD_CODEC_ES7210:
+            return &es7210_reg_cache_desc;
+        case AUDIO_BOARD_CODEC_ES8388:
+            return &es8388_reg_cache_desc;
+        case AUDIO_BOARD_CODEC_ES7243E:
+            return &es7243e_reg_cache_desc;
+        case AUDIO_BOARD_CODEC_ES8374:
+            return &es8374_reg_cache_desc;
+        case AUDIO_BOARD_CODEC_ES8156:
+            return &es8156_reg_cache_desc;
+        default:
+            // TAS5805M use paged registers, not cacheable
+            return NULL;
+    }
+}
+
 static void get_codec_cfg(audio_board_codec_type_t codec_type, const audio_codec_ctrl_if_t *ctrl_if,
                           audio_board_codec_io_cfg_t *io_cfg, render_codec_cfg_t *codec_cfg)
 {
@@ -307,6 +349,7 @@ static void get_codec_cfg(audio_board_codec_type_t codec_type, const audio_codec
             zl38063_cfg->codec_mode = io_cfg->codec_mode;
             zl38063_cfg->pa_pin = io_cfg->pa_pin;
             zl38063_cfg->reset_pin = io_cfg->reset_pin;
+            zl38063_cfg->irq_pin = -1;
         } break;
         default:
             break;
@@ -329,8 +372,13 @@ static int init_render()
                         if (dev_cfg->addr == 0) {
                             dev_cfg->addr = get_codec_default_addr(codec_cfg->codec_type);
                         }
+                        if (audio_board_i2c_probe(board_cfg, dev_cfg, get_codec_id_reg(codec_cfg->codec_type)) != 0) {
+                            ESP_LOGE(TAG, "Codec %d not found on i2c port %d", codec_cfg->codec_type, dev_cfg->port);
+                            continue;
+                        }
                         ctrl_if = audio_codec_new_i2c_ctrl_if(dev_cfg);
-                        ESP_LOGI(TAG, "Use i2c port %d addr:%02x\n", dev_cfg->port, dev_cfg->addr);
+                        ESP_LOGI(TAG, "Use i2c port %d addr:%02x speed:%" PRIu32 "\n", dev_cfg->port, dev_cfg->addr,
+                                 audio_board_get_i2c_speed(board_cfg, dev_cfg->port));
                     }
                     break;
                 case AUDIO_BOARD_MEDIA_SPI:
@@ -342,8 +390,21 @@ static int init_render()
                 default:
                     break;
             }
+            const audio_codec_ctrl_if_t *raw_ctrl_if = NULL;
+            const codec_reg_cache_desc_t *cache_desc = get_codec_cache_desc(codec_cfg->codec_type);
+            if (ctrl_if && cache_desc) {
+                codec_cache_ctrl_cfg_t cache_cfg = {
+                    .ctrl_if = ctrl_if,
+                    .desc = cache_desc,
+                };
+                const audio_codec_ctrl_if_t *cache_if = audio_codec_new_cache_ctrl_if(&cache_cfg);
+                if (cache_if) {
+                    raw_ctrl_if = ctrl_if;
+                    ctrl_if = cache_if;
+                }
+            }
             if (ctrl_if) {
-                add_ctrl_if(codec_cfg->ctrl_media, codec_cfg->ctrl_port, ctrl_if);
+                add_ctrl_if(codec_cfg->ctrl_media, codec_cfg->ctrl_port, ctrl_if, raw_ctrl_if);
                 ESP_LOGI(TAG, "Add to ctrl if OK\n");
             }
         }
@@ -477,6 +538,11 @@ static void deinit_render()
             audio_codec_delete_ctrl_if(render_res.ctrl_if[i]);
             render_res.ctrl_if[i] = NULL;
         }
+        // Cache interface need delete before wrapped control interface
+        if (render_res.raw_ctrl_if[i]) {
+            audio_codec_delete_ctrl_if(render_res.raw_ctrl_if[i]);
+            render_res.raw_ctrl_if[i] = NULL;
+        }
     }
     // Unregister GPIO interface
     audio_codec_set_gpio_if(NULL);